@@ -0,0 +1,447 @@
+/******************************************************************************/
+
+/** @file calib.c
+*
+* @brief This module keeps the carriage position of each column in FRAM.
+*
+* @par
+* The positions start out on the nominal board geometry and are corrected by
+* calib_start(), which finds where each column actually takes a chip. A chip
+* lands in a column anywhere within a window of carriage positions, so
+* calibration drops test chips to find both edges of the window and keeps
+* the point halfway between them.
+*
+* @par
+* Each edge is found with a binary search between a position that lands in
+* the column and one half a column away, CALIB_PROBES chips per edge, so
+* a calibration drops 6 chips per column and fills the board once. A column
+* whose old position is below its window takes 3 more, and a column none of
+* the chips landed in keeps its old position. If homing never finds the
+* switch no chips are dropped and every column keeps its old position.
+*
+* @par
+* Test chips that miss land in the neighbouring column, so the 42 chips
+* don't fill the board evenly and the chips seen in each column are counted.
+* Before a chip that could land in a column already holding CALIB_ROWS the
+* calibration pauses and replies Y with BOARD_FULL set in failed. Another Y
+* once the board is empty carries on from the same chip.
+*
+* @par
+* calib_start() answers the Y maintenance instruction, see uart.c, and once
+* done replies Y failed p0_l p0_h ... p6_l p6_h, where bit n of failed is
+* set for a column that kept its old position and the positions are little
+* endian steps.
+*
+* @par
+* The 42 chips take minutes, so calibration runs on the scheduler's events
+* like the game does. While calib_busy() the game hands every event to
+* calib_event(), which starts each carriage move, drop, retract and reload
+* delay as the last one finishes. Instructions wait until it is done, but
+* the host's frames are still answered meanwhile.
+*/
+
+// Includes
+#include <stdint.h>
+#include "driverlib.h"
+#include "Board.h"
+#include "defines.h"
+#include "sched.h"
+#include "calib.h"
+#include "stepper.h"
+#include "servo.h"
+#include "photo.h"
+#include "protocol.h"
+
+#define BOARD_STEPS         319     // 319 steps = 45mm, 1000 steps = 141mm
+#define COLUMN_STEPS        248     // 248 steps = 35mm
+#define NOMINAL(column)     (BOARD_STEPS + COLUMN_STEPS * (CALIB_COLUMNS - (column) - 1))
+#define CALIB_PROBES        3       // Chips per window edge, halving the search each time
+#define OP_CALIBRATE        0x59    // Y
+#define BOARD_FULL          0x80    // Y reply's failed bit 7, paused until the board is emptied
+
+// What the calibration is waiting for
+typedef enum
+{
+    CALIB_IDLE,
+    CALIB_HOME,         // Carriage homing before the first column
+    CALIB_MOVE,         // Carriage heading for the next probe
+    CALIB_WATCH,        // Test chip seen or timed out
+    CALIB_RETRACT,      // Dispenser coming back
+    CALIB_RELOAD,       // Next chip loading, SCHED_TIMER_RELOAD
+    CALIB_EMPTY,        // Board full, waiting for Y once it is emptied
+    CALIB_PARK          // Carriage homing after the last column
+} calib_phase_t;
+
+// Which edge of a column's window is being searched for
+typedef enum
+{
+    EDGE_LOW,           // Down from the old position
+    EDGE_HIGH,          // Up from the lowest position found in the column
+    EDGE_HIGH_FIRST,    // Up from the old position, which is below the window
+    EDGE_LOW_LAST       // Down from the highest position found in the column
+} calib_edge_t;
+
+// FRAM, kept through resets and written with FRAMCtl. 0 is the column
+// farthest from home.
+#pragma PERSISTENT(positions)
+static int16_t positions[CALIB_COLUMNS] =
+{
+    NOMINAL(0), NOMINAL(1), NOMINAL(2), NOMINAL(3), NOMINAL(4), NOMINAL(5), NOMINAL(6)
+};
+
+static calib_phase_t phase      = CALIB_IDLE;
+static calib_edge_t  edge       = EDGE_LOW;
+static uint8_t       column     = 0;    // Column being calibrated
+static uint8_t       probe      = 0;    // Chips dropped for this edge so far
+static uint8_t       landed     = 0;    // 1 if the last chip landed in the column
+static uint8_t       failed     = 0;    // Columns that keep their old position, bit n = column n
+static int16_t       start      = 0;    // The column's old position
+static int16_t       inside     = 0;    // Farthest position found that lands in the column
+static int16_t       outside    = 0;    // Nearest position found that doesn't
+static int16_t       middle     = 0;    // Where the last chip was dropped from
+static int16_t       low        = 0;    // The window's edges
+static int16_t       high       = 0;
+static uint8_t       chips[CALIB_COLUMNS];  // Test chips in each column, an unseen one counts in the column aimed at
+
+
+/*!
+* @brief Gets the carriage position over a column.
+* @param[in] column The column 0-6, any higher is taken as 6, the column
+* nearest home, so the carriage never heads beyond its travel.
+* @return The position in steps away from home.
+*/
+int16_t
+calib_get_position (uint8_t column)
+{
+    if (column >= CALIB_COLUMNS)
+    {
+        column = CALIB_COLUMNS - 1;
+    }
+    return positions[column];
+}   /* calib_get_position() */
+
+/*!
+* @brief Sends Y failed p0_l p0_h ... p6_l p6_h.
+* @param[in] flags Set in failed as well, BOARD_FULL or 0.
+*/
+static void
+calib_reply (uint8_t flags)
+{
+    uint8_t reply[1 + 2 * CALIB_COLUMNS];
+    uint8_t i;
+
+    reply[0] = failed | flags;
+    for (i = 0; i < CALIB_COLUMNS; i++)
+    {
+        reply[1 + 2 * i] = positions[i] & 0xFF;
+        reply[2 + 2 * i] = (uint16_t)positions[i] >> 8;
+    }
+    protocol_send(OP_CALIBRATE, reply, sizeof(reply));
+}   /* calib_reply() */
+
+/*!
+* @brief Starts the carriage towards the next test chip's position, halfway
+* between the positions either side of the edge, or pauses for the board to
+* be emptied if a column it could land in is full.
+*/
+static void
+calib_probe (void)
+{
+    // A chip that misses lands in the neighbour on the outside's side,
+    // the one farther from home when outside is the higher position
+    uint8_t neighbour = (outside > inside) ? column - 1 : column + 1;
+
+    if ((chips[column] >= CALIB_ROWS)
+        || ((neighbour < CALIB_COLUMNS) && (chips[neighbour] >= CALIB_ROWS)))
+    {
+        stepper_disable();
+        phase = CALIB_EMPTY;
+        calib_reply(BOARD_FULL);
+        return;
+    }
+
+    middle = (inside + outside) / 2;
+    phase  = CALIB_MOVE;
+    stepper_move_async(middle);
+}   /* calib_probe() */
+
+/*!
+* @brief Starts searching for one edge of the column's window.
+* @param[in] next The edge.
+* @param[in] from A position that doesn't land in the column, inside is one
+* that does.
+*/
+static void
+calib_search (calib_edge_t next, int16_t from)
+{
+    edge    = next;
+    outside = from;
+    probe   = 0;
+    calib_probe();
+}   /* calib_search() */
+
+/*!
+* @brief Starts on the next column, or homes the carriage after the last.
+*/
+static void
+calib_column (void)
+{
+    if (column >= CALIB_COLUMNS)
+    {
+        phase = CALIB_PARK;
+        stepper_home_async();
+        return;
+    }
+
+    // Search down from the current position to half a column below
+    start  = positions[column];
+    inside = start;
+    calib_search(EDGE_LOW, start - COLUMN_STEPS / 2);
+}   /* calib_column() */
+
+/*!
+* @brief Goes on once an edge is found, halfway between the last positions
+* either side of it, to the column's other edge or the next column.
+*/
+static void
+calib_edge (void)
+{
+    int16_t found = (inside + outside) / 2;
+
+    switch (edge)
+    {
+    case EDGE_LOW:
+        low = found;
+        if (inside != start)
+        {
+            // Search up from the lowest position found in the column, a
+            // window is never wider than half a column
+            calib_search(EDGE_HIGH, inside + COLUMN_STEPS / 2);
+        }
+        else
+        {
+            // The current position is below the window, search up first
+            // then back down from the highest position found in it
+            calib_search(EDGE_HIGH_FIRST, start + COLUMN_STEPS / 2);
+        }
+        return;
+
+    case EDGE_HIGH_FIRST:
+        high = found;
+        if (inside != start)
+        {
+            calib_search(EDGE_LOW_LAST, inside - COLUMN_STEPS / 2);
+            return;
+        }
+        failed |= 1 << column;
+        break;
+
+    case EDGE_HIGH:
+        high = found;
+        break;
+
+    default:
+        low = found;
+        break;
+    }
+
+    if (!(failed & (1 << column)))
+    {
+        found = (low + high) / 2;
+        FRAMCtl_write16((uint16_t *)&found, (uint16_t *)&positions[column], 1);
+    }
+    column++;
+    calib_column();
+}   /* calib_edge() */
+
+/*!
+* @brief Finishes a test chip and retracts the dispenser for the next one.
+* @param[in] columns The beams the chip broke, 0 if it timed out.
+*/
+static void
+calib_watched (uint8_t columns)
+{
+    uint8_t detected = photo_column(columns);
+
+    photo_disarm();
+    landed = detected == column;
+    chips[(detected < CALIB_COLUMNS) ? detected : column]++;
+    phase  = CALIB_RETRACT;
+    servo_move_async(SERVO_MAX_DUTY, SERVO_RATE);
+}   /* calib_watched() */
+
+/*!
+* @brief Narrows the search with the last test chip once the next one has
+* loaded.
+*/
+static void
+calib_probed (void)
+{
+    if (landed)
+    {
+        inside = middle;
+    }
+    else
+    {
+        outside = middle;
+    }
+
+    if (++probe < CALIB_PROBES)
+    {
+        calib_probe();
+    }
+    else
+    {
+        calib_edge();
+    }
+}   /* calib_probed() */
+
+/*!
+* @brief Sends the result once the carriage is back home.
+*/
+static void
+calib_finish (void)
+{
+    stepper_disable();
+    phase = CALIB_IDLE;
+    calib_reply(0);
+}   /* calib_finish() */
+
+/*!
+* @brief Handles the carriage coming to a stop.
+*/
+static void
+calib_stopped (void)
+{
+    switch (phase)
+    {
+    case CALIB_HOME:
+        if (stepper_home_failed())
+        {
+            failed = (1 << CALIB_COLUMNS) - 1;
+            column = CALIB_COLUMNS;
+        }
+        calib_column();
+        break;
+
+    case CALIB_MOVE:
+        phase = CALIB_WATCH;
+        servo_write_min();
+        photo_disarm();
+        photo_arm(1);
+        break;
+
+    case CALIB_PARK:
+        calib_finish();
+        break;
+
+    default:
+        break;
+    }
+}   /* calib_stopped() */
+
+/*!
+* @brief Starts finding the center of every column's window with test chips,
+* to be stored in FRAM. The game hands its events to calib_event() until it
+* is done.
+*
+* @par
+* The board must be empty, the dispenser loaded with 42 chips and the
+* carriage standing still. The carriage is homed first and left at home.
+* While paused for the board to be emptied, carries on instead.
+*/
+void
+calib_start (void)
+{
+    uint8_t i;
+
+    for (i = 0; i < CALIB_COLUMNS; i++)
+    {
+        chips[i] = 0;
+    }
+
+    if (CALIB_EMPTY == phase)
+    {
+        stepper_enable();
+        calib_probe();
+        return;
+    }
+
+    failed = 0;
+    column = 0;
+    stepper_enable();
+    phase  = CALIB_HOME;
+    stepper_home_async();
+}   /* calib_start() */
+
+/*!
+* @brief Checks whether a calibration is under way.
+* @return 1 if it is, 0 if not.
+*/
+uint8_t
+calib_busy (void)
+{
+    return CALIB_IDLE != phase;
+}   /* calib_busy() */
+
+/*!
+* @brief Checks whether a calibration is paused for the board to be emptied.
+* @return 1 if it is, 0 if not.
+*/
+uint8_t
+calib_paused (void)
+{
+    return CALIB_EMPTY == phase;
+}   /* calib_paused() */
+
+/*!
+* @brief Takes the calibration a step further on a scheduler event.
+* @param[in] event The event.
+* @param[in] arg Its argument, listed in sched_event_t.
+*/
+void
+calib_event (sched_event_t event, uint8_t arg)
+{
+    photo_drop_t drop;
+
+    switch (event)
+    {
+    case SCHED_EV_STEPPER:
+        if (!stepper_is_busy())
+        {
+            calib_stopped();
+        }
+        break;
+
+    case SCHED_EV_SERVO:
+        if ((CALIB_RETRACT == phase) && !servo_is_busy())
+        {
+            phase = CALIB_RELOAD;
+            sched_timer_start(SCHED_TIMER_RELOAD, SERVO_RELOAD_TICKS);
+        }
+        break;
+
+    case SCHED_EV_TIMER:
+        if ((SCHED_TIMER_RELOAD == arg) && (CALIB_RELOAD == phase) && sched_timer_expired(SCHED_TIMER_RELOAD))
+        {
+            calib_probed();
+        }
+        else if ((SCHED_TIMER_PHOTO == arg) && (CALIB_WATCH == phase) && photo_timed_out())
+        {
+            calib_watched(0);
+        }
+        break;
+
+    case SCHED_EV_CHIP:
+        if ((CALIB_WATCH == phase) && photo_take_drop(&drop))
+        {
+            calib_watched(drop.columns);
+        }
+        break;
+
+    default:
+        break;
+    }
+}   /* calib_event() */
+
+/*** end of file ***/
@@ -0,0 +1,26 @@
+/******************************************************************************/
+
+/** @file calib.h
+*
+* @brief This module keeps the carriage position of each column in FRAM.
+*/
+
+#ifndef CALIB_H
+#define CALIB_H
+
+#define CALIB_COLUMNS           7
+#define CALIB_ROWS              6
+
+int16_t calib_get_position(uint8_t column);
+
+void calib_start(void);
+
+uint8_t calib_busy(void);
+
+uint8_t calib_paused(void);
+
+void calib_event(sched_event_t event, uint8_t arg);
+
+#endif /* CALIB_H */
+
+/*** end of file ***/
@@ -21,15 +21,39 @@
 #define NENABLE_PORT                     GPIO_PORT_P3
 #define NENABLE_PIN                      GPIO_PIN1
 
+// Stepper motion profile, speeds in steps/s and acceleration in steps/s^2
+#define STEPPER_TIMER_FREQUENCY          250000  // SMCLK/8 = 250kHz
+#define STEPPER_START_SPEED              1000    // Pull-in speed, matches TIMER_PERIOD
+#define STEPPER_MAX_SPEED                3000    // Cruise speed, 83 timer counts
+#define STEPPER_ACCELERATION             8000    // 0.25s from start to cruise speed
+#define STEPPER_SPEED_MIN                100     // Slowest cruise stepper_set_profile() takes, 2500 timer counts
+#define STEPPER_SPEED_LIMIT              5000    // Fastest, 50 timer counts, beyond what the motor pulls
+#define STEPPER_ACCEL_MIN                1000    // Gentlest, 2s from start to the default cruise speed
+
+// Stepper homing
+#define STEPPER_HOME_SEEK_SPEED          2500    // Fast seek towards the bump switch
+#define STEPPER_HOME_APPROACH_SPEED      250     // Slow re-approach for a repeatable zero
+#define STEPPER_HOME_BACKOFF_STEPS       40      // Most steps backing off until the switch releases
+#define STEPPER_HOME_MAX_STEPS           2400    // More than the full carriage travel
+#define STEPPER_JOG_MARGIN_STEPS         124     // Jogs stop this far past column 0, as far out as calibration probes
+
 // Servo PWM Output using Timer1_A3
 #define SERVO_TIMER_PERIOD               4999    // 5000/250000 = 0.02, 50Hz
 #define SERVO_MIN_DUTY                   124     // 125/250000 = 500us
 #define SERVO_MAX_DUTY                   574     // 575/250000 = 2300us
+#define SERVO_RATE                       20      // Duty counts per period, 80us/20ms, the servo's own slew
+#define SERVO_RELOAD_TICKS               102     // TimerA2 cycles at 512Hz, 0.2s for the next chip to load once retracted
+#define SERVO_SETTLE_PERIODS             10      // 200ms of PWM after a move for the horn to get there
+#define SERVO_TRAVEL_PERIODS             23      // 460ms of PWM for the horn to cross its whole range
+#define SERVO_HOLD_DUTY                  174     // 175/250000 = 700us, interlock stops short of dropping the chip
+#define SERVO_RESEAT_DUTY                374     // 375/250000 = 1500us, backs a stuck chip off without loading the next
+#define SERVO_LEAD_STEPS                 600     // Carriage steps left when the dispenser starts extending
+#define SERVO_RELEASE_TOLERANCE          12      // Carriage steps off the column the chip may be released at
 #define SERVO_PORT                       GPIO_PORT_P1
 #define SERVO_PIN                        GPIO_PIN4
 #define SERVO_PIN_FUNCTION               GPIO_SECONDARY_MODULE_FUNCTION
 
-// Bump sensor for stepper homing
+// Bump sensor for stepper homing, P3 has no port interrupt so it is sampled every step
 #define BUMP_PORT                        GPIO_PORT_P3
 #define BUMP_PIN                         GPIO_PIN2
 
@@ -57,7 +81,21 @@
 #define PHOTO7_PORT                      P1
 #define PHOTO7                           BIT3
 
-#define PHOTO_IN                        ((P1IN & (PHOTO7 | PHOTO6)) << 3) | ((P2IN & PHOTO5) >> 3) | ((P2IN & PHOTO4) >> 1) | (P2IN & (PHOTO3 | PHOTO2 | PHOTO1))
+#define PHOTO_P1_PINS                   (PHOTO7 | PHOTO6)
+#define PHOTO_P2_PINS                   (PHOTO5 | PHOTO4 | PHOTO3 | PHOTO2 | PHOTO1)
+
+// Packs port 1 and port 2 pin bits into one byte, bit n = column n
+#define PHOTO_BITS(p1, p2)              ((((p1) & (PHOTO7 | PHOTO6)) << 3) | (((p2) & PHOTO5) >> 3) | (((p2) & PHOTO4) >> 1) | ((p2) & (PHOTO3 | PHOTO2 | PHOTO1)))
+#define PHOTO_IN                        PHOTO_BITS(P1IN, P2IN)
+#define PHOTO_SIMULTANEOUS_TICKS        33      // 33/32768 = 1ms, beams broken closer together are one drop
+#define PHOTO_MIN_BREAK_TICKS           16      // 16/32768 = 490us, shorter breaks are noise
+#define PHOTO_MIN_CLEAR_TICKS           328     // 328/32768 = 10ms, breaking again sooner is the same chip bouncing
+#define PHOTO_STUCK_TICKS               32768   // 1s broken between turns, no chip takes that long
+#define PHOTO_STUCK_MISSES              2       // Robot's chips unseen in a row before the sensor is taken as dead
+
+// Robot's own moves, see engine.c
+#define ENGINE_DEPTH                    8       // Most moves the robot looks ahead when it chooses
+#define ENGINE_BUDGET_TICKS             16384   // 16384/32768 = 0.5s of search, half the watchdog period
 
 #endif /* DEFINES_H */
 
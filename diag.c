@@ -0,0 +1,348 @@
+/******************************************************************************/
+
+/** @file diag.c
+*
+* @brief This module runs the hardware diagnostics the host asks for.
+*
+* @par
+* These take the place of the test modes main.c used to be built with, so
+* a robot can be checked over on the bench with the production firmware.
+* They move the carriage and the dispenser behind the game's back, so run
+* them between games. Like the other maintenance instructions they carry
+* their arguments in a frame, see protocol.c, and sent bare they run with
+* the defaults given below. Numbers are little endian.
+*
+* @par
+* ] test arg_l arg_h runs one test and replies ] test and its results:
+* - 0 echo, replies with the rest of the frame, to check the link.
+* - 1 jog, moves the carriage arg steps, signed, but not beyond home or just
+*   past column 0, or homes it for 0, and replies position_l position_h
+*   bump, bump 1 if the switch is pressed.
+*   Without arguments it homes.
+* - 2 servo, extends and retracts the dispenser arg times, at least once,
+*   dropping a chip each time, and replies the mean cycle in ms_l ms_h.
+* - 3 bump, counts presses of the bump switch for arg ms and replies
+*   presses_l presses_h bump.
+* - 4 profile, ] 4 speed_l speed_h accel_l accel_h sets the carriage's
+*   cruise speed in steps/s and acceleration in steps/s^2 until the next
+*   reset, and replies ] 4 speed_l speed_h accel_l accel_h with the profile
+*   moves now run with. Out of range values leave it as it was, see
+*   stepper_set_profile(). Without arguments it only replies.
+* An unknown test is answered with ] test alone.
+*
+* @par
+* ^ dumps what the robot senses and how it has been reset: ^ beams bump
+* position_l position_h overruns cause_l cause_h resets_l resets_h
+* faults_l faults_h missed missing homing, beams being the
+* photo-interrupters blocked now, bit n = column n, overruns the bytes the
+* UART has dropped, homing 1 if the last homing never found the bump switch,
+* and the rest the watchdog's log, see watchdog.h.
+*
+* @par
+* _ columns drops a chip into each column set in columns, bit n = column n,
+* or every column without it. The carriage homes first, and after each drop
+* the robot replies _ column seen ms_l ms_h, seen being the column the chip
+* was seen in or 7 if it never was, and ms how long it took from the
+* dispenser starting out. The carriage is left at home.
+*/
+
+// Includes
+#include <stdint.h>
+#include "driverlib.h"
+#include "Board.h"
+#include "defines.h"
+#include "diag.h"
+#include "sched.h"
+#include "calib.h"
+#include "stepper.h"
+#include "servo.h"
+#include "photo.h"
+#include "uart.h"
+#include "trace.h"
+#include "watchdog.h"
+#include "protocol.h"
+#include "power.h"
+
+#define OP_TEST             0x5D    // ]
+#define OP_DUMP             0x5E    // ^
+#define OP_DROPS            0x5F    // _
+#define BUMP_SAMPLE_TICKS   5       // TimerA2 cycles at 512Hz, ~10ms between bump switch samples
+#define TRACE_TICKS_PER_MS  (TRACE_TICKS_PER_SECOND / 1000)
+
+typedef enum
+{
+    DIAG_ECHO,
+    DIAG_JOG,
+    DIAG_SERVO,
+    DIAG_BUMP,
+    DIAG_PROFILE
+} diag_test_t;
+
+/*!
+* @brief Checks the bump switch.
+* @return 1 if it is pressed, 0 if not.
+*/
+static uint8_t
+diag_bump (void)
+{
+    return !GPIO_getInputPinValue(BUMP_PORT, BUMP_PIN);
+}   /* diag_bump() */
+
+/*!
+* @brief Converts a trace interval to ms for a reply.
+* @param[in] ticks The interval in trace_now() ticks.
+* @return The interval in ms, up to 65535.
+*/
+static uint16_t
+diag_ms (uint32_t ticks)
+{
+    ticks /= TRACE_TICKS_PER_MS;
+    return (ticks > 0xFFFF) ? 0xFFFF : (uint16_t)ticks;
+}   /* diag_ms() */
+
+/*!
+* @brief Moves the carriage by a number of steps, or homes it.
+* @param[in] steps Steps away from home, negative towards it, 0 to home.
+*
+* @par
+* The carriage stops between home and STEPPER_JOG_MARGIN_STEPS past column
+* 0, the column farthest from home.
+*/
+static void
+diag_jog (int16_t steps)
+{
+    int32_t target = (int32_t)stepper_get_position() + steps;
+    int32_t limit  = (int32_t)calib_get_position(0) + STEPPER_JOG_MARGIN_STEPS;
+
+    if (target < 0)
+    {
+        target = 0;
+    }
+    else if (target > limit)
+    {
+        target = limit;
+    }
+
+    stepper_wait();
+    stepper_enable();
+    if (0 == steps)
+    {
+        stepper_go_home();
+    }
+    else
+    {
+        stepper_move_to((int16_t)target);
+    }
+    stepper_disable();
+}   /* diag_jog() */
+
+/*!
+* @brief Cycles the dispenser out and back.
+* @param[in] cycles How many times, at least once.
+* @return The mean cycle in trace_now() ticks, reloading included.
+*/
+static uint32_t
+diag_servo (uint16_t cycles)
+{
+    uint32_t start;
+    uint16_t i;
+
+    if (0 == cycles)
+    {
+        cycles = 1;
+    }
+
+    servo_wait();
+    start = trace_now();
+    for (i = 0; i < cycles; i++)
+    {
+        servo_move_to(SERVO_MIN_DUTY, SERVO_RATE);
+        servo_move_to(SERVO_MAX_DUTY, SERVO_RATE);
+        power_delay(SERVO_RELOAD_TICKS);
+    }
+
+    return (trace_now() - start) / cycles;
+}   /* diag_servo() */
+
+/*!
+* @brief Counts presses of the bump switch.
+* @param[in] ms How long to count for.
+* @return The presses, each pressed after a sample found the switch released.
+*
+* @par
+* Sampling every BUMP_SAMPLE_TICKS is slower than the switch bounces, so a
+* press is only counted once.
+*/
+static uint16_t
+diag_presses (uint16_t ms)
+{
+    uint16_t samples = (uint16_t)(((uint32_t)ms * 512 / 1000) / BUMP_SAMPLE_TICKS);
+    uint16_t presses = 0;
+    uint8_t  pressed = diag_bump();
+    uint8_t  now;
+
+    while (samples--)
+    {
+        power_delay(BUMP_SAMPLE_TICKS);
+        now = diag_bump();
+        if (now && !pressed)
+        {
+            presses++;
+        }
+        pressed = now;
+    }
+
+    return presses;
+}   /* diag_presses() */
+
+/*!
+* @brief Answers the ] maintenance instruction.
+* @param[in] data The payload, the test and its argument.
+* @param[in] len The number of payload bytes.
+*/
+void
+diag_test (const uint8_t *data, uint8_t len)
+{
+    uint8_t  reply[PROTOCOL_MAX_DATA];
+    uint8_t  size = 1;
+    uint16_t arg  = 0;
+    uint16_t value;
+    uint16_t accel;
+    uint8_t  i;
+
+    reply[0] = len ? data[0] : DIAG_JOG;
+    if (len >= 3)
+    {
+        arg = data[1] | (data[2] << 8);
+    }
+
+    switch ((diag_test_t)reply[0])
+    {
+    case DIAG_ECHO:
+        for (i = 1; i < len; i++)
+        {
+            reply[i] = data[i];
+        }
+        size = len;
+        break;
+
+    case DIAG_JOG:
+        diag_jog((int16_t)arg);
+        value    = (uint16_t)stepper_get_position();
+        reply[1] = value & 0xFF;
+        reply[2] = value >> 8;
+        reply[3] = diag_bump();
+        size     = 4;
+        break;
+
+    case DIAG_SERVO:
+        value    = diag_ms(diag_servo(arg));
+        reply[1] = value & 0xFF;
+        reply[2] = value >> 8;
+        size     = 3;
+        break;
+
+    case DIAG_BUMP:
+        value    = diag_presses(arg);
+        reply[1] = value & 0xFF;
+        reply[2] = value >> 8;
+        reply[3] = diag_bump();
+        size     = 4;
+        break;
+
+    case DIAG_PROFILE:
+        if (len >= 5)
+        {
+            stepper_set_profile(arg, data[3] | (data[4] << 8));
+        }
+        stepper_get_profile(&value, &accel);
+        reply[1] = value & 0xFF;
+        reply[2] = value >> 8;
+        reply[3] = accel & 0xFF;
+        reply[4] = accel >> 8;
+        size     = 5;
+        break;
+
+    default:
+        break;
+    }
+
+    protocol_send(OP_TEST, reply, size);
+}   /* diag_test() */
+
+/*!
+* @brief Answers the ^ maintenance instruction.
+*/
+void
+diag_dump (void)
+{
+    const watchdog_log_t *log = watchdog_get_log();
+    uint8_t               reply[14];
+    uint16_t              position = (uint16_t)stepper_get_position();
+
+    reply[0]  = photo_blocked();
+    reply[1]  = diag_bump();
+    reply[2]  = position & 0xFF;
+    reply[3]  = position >> 8;
+    reply[4]  = uart_get_overruns();
+    reply[5]  = log->cause & 0xFF;
+    reply[6]  = log->cause >> 8;
+    reply[7]  = log->resets & 0xFF;
+    reply[8]  = log->resets >> 8;
+    reply[9]  = log->faults & 0xFF;
+    reply[10] = log->faults >> 8;
+    reply[11] = log->missed;
+    reply[12] = log->missing;
+    reply[13] = stepper_home_failed();
+    protocol_send(OP_DUMP, reply, sizeof(reply));
+}   /* diag_dump() */
+
+/*!
+* @brief Answers the _ maintenance instruction.
+* @param[in] data The payload, the columns to drop into.
+* @param[in] len The number of payload bytes.
+*
+* @par
+* The board must have room in each column and the dispenser a chip for each.
+*/
+void
+diag_drops (const uint8_t *data, uint8_t len)
+{
+    uint8_t  columns = len ? data[0] : 0x7F;
+    uint8_t  reply[4];
+    uint32_t start;
+    uint16_t ms;
+    uint8_t  column;
+
+    stepper_wait();
+    servo_wait();
+    stepper_enable();
+    stepper_go_home();
+
+    for (column = 0; column < CALIB_COLUMNS; column++)
+    {
+        if (!(columns & (1 << column)))
+        {
+            continue;
+        }
+
+        stepper_move_to(calib_get_position(column));
+        start = trace_now();
+        servo_write_min();
+        reply[1] = photo_wait(1);
+        ms = diag_ms(trace_now() - start);
+
+        reply[0] = column;
+        reply[2] = ms & 0xFF;
+        reply[3] = ms >> 8;
+        protocol_send(OP_DROPS, reply, sizeof(reply));
+
+        servo_move_to(SERVO_MAX_DUTY, SERVO_RATE);
+        power_delay(SERVO_RELOAD_TICKS);
+    }
+
+    stepper_go_home();
+    stepper_disable();
+}   /* diag_drops() */
+
+/*** end of file ***/
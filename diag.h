@@ -0,0 +1,19 @@
+/******************************************************************************/
+
+/** @file diag.h
+*
+* @brief This module runs the hardware diagnostics the host asks for.
+*/
+
+#ifndef DIAG_H
+#define DIAG_H
+
+void diag_test(const uint8_t *data, uint8_t len);
+
+void diag_dump(void);
+
+void diag_drops(const uint8_t *data, uint8_t len);
+
+#endif /* DIAG_H */
+
+/*** end of file ***/
@@ -0,0 +1,356 @@
+/******************************************************************************/
+
+/** @file engine.c
+*
+* @brief This module picks the robot's move with a negamax search.
+*
+* @par
+* The board is a 64 bit bitboard. Each column takes 7 bits, 6 for the rows
+* and a spare bit on top that stops the shifts in alignment() from carrying
+* into the next column. Bit 0 is the bottom of column 0. The position is
+* kept as the chips of the player to move plus a mask of every chip, so a
+* move is two 64 bit operations and undoing it is two more.
+*
+* @par
+* The search is negamax with alpha-beta pruning, trying the center columns
+* first since they take part in the most lines. Moves are made and undone
+* on the one position rather than copied, so each level of the search only
+* costs a small stack frame. The tables are const and stay in FRAM.
+*
+* @par
+* engine_choose() deepens the search one move at a time up to the depth
+* asked for, and keeps the choice of the deepest search that finished
+* within ENGINE_BUDGET_TICKS of trace time. One cut short by the budget is
+* thrown away, so the robot answers in bounded time whatever the position.
+*/
+
+// Includes
+#include <stdint.h>
+#include "driverlib.h"
+#include "defines.h"
+#include "engine.h"
+#include "watchdog.h"
+#include "protocol.h"
+#include "trace.h"
+
+#define HEIGHT                  (ENGINE_ROWS + 1)
+#define CELLS                   (ENGINE_ROWS * ENGINE_COLUMNS)
+#define SCORE_MIN               (-(CELLS / 2) - 1)  // Lower than any loss
+#define SCORE_MAX               ((CELLS / 2) + 1)   // Higher than any win
+
+#if ENGINE_BUDGET_TICKS >= WATCHDOG_PERIOD_TICKS
+#error "ENGINE_BUDGET_TICKS must keep the search inside the watchdog period"
+#endif
+
+// Bottom cell of each column
+static const uint64_t bottom_masks[ENGINE_COLUMNS] =
+{
+    0x0000000000000001ULL, 0x0000000000000080ULL, 0x0000000000004000ULL,
+    0x0000000000200000ULL, 0x0000000010000000ULL, 0x0000000800000000ULL,
+    0x0000040000000000ULL
+};
+
+// Every playable cell of each column
+static const uint64_t column_masks[ENGINE_COLUMNS] =
+{
+    0x000000000000003FULL, 0x0000000000001F80ULL, 0x00000000000FC000ULL,
+    0x0000000007E00000ULL, 0x00000003F0000000ULL, 0x000001F800000000ULL,
+    0x0000FC0000000000ULL
+};
+
+// Top playable cell of each column
+static const uint64_t top_masks[ENGINE_COLUMNS] =
+{
+    0x0000000000000020ULL, 0x0000000000001000ULL, 0x0000000000080000ULL,
+    0x0000000004000000ULL, 0x0000000200000000ULL, 0x0000010000000000ULL,
+    0x0000800000000000ULL
+};
+
+// Center first
+static const uint8_t column_order[ENGINE_COLUMNS] = { 3, 2, 4, 1, 5, 0, 6 };
+
+// Local variables
+static uint64_t current = 0;    // Chips of the player to move
+static uint64_t mask    = 0;    // Every chip on the board
+static uint8_t  moves   = 0;
+static uint32_t started = 0;    // trace_now() when engine_choose() began
+static uint8_t  expired = 0;    // The search ran past ENGINE_BUDGET_TICKS
+
+/*!
+* @brief Checks for 4 in a row.
+* @param[in] chips One player's chips.
+* @return 1 if any 4 of them are in a line, 0 if not.
+*/
+static uint8_t
+alignment (uint64_t chips)
+{
+    uint64_t pairs;
+
+    // Horizontal
+    pairs = chips & (chips >> HEIGHT);
+    if (pairs & (pairs >> (2 * HEIGHT)))
+    {
+        return 1;
+    }
+
+    // Diagonal, down to the right
+    pairs = chips & (chips >> (HEIGHT - 1));
+    if (pairs & (pairs >> (2 * (HEIGHT - 1))))
+    {
+        return 1;
+    }
+
+    // Diagonal, up to the right
+    pairs = chips & (chips >> (HEIGHT + 1));
+    if (pairs & (pairs >> (2 * (HEIGHT + 1))))
+    {
+        return 1;
+    }
+
+    // Vertical
+    pairs = chips & (chips >> 1);
+    if (pairs & (pairs >> 2))
+    {
+        return 1;
+    }
+
+    return 0;
+}   /* alignment() */
+
+/*!
+* @brief Checks if a column has room for another chip.
+*/
+static uint8_t
+playable (uint8_t column)
+{
+    return 0 == (mask & top_masks[column]);
+}   /* playable() */
+
+/*!
+* @brief Checks if playing a column wins for the player to move.
+*/
+static uint8_t
+winning_move (uint8_t column)
+{
+    return alignment(current | ((mask + bottom_masks[column]) & column_masks[column]));
+}   /* winning_move() */
+
+/*!
+* @brief Scores the position for the player to move.
+* @param[in] alpha The score already guaranteed.
+* @param[in] beta The score the opponent already holds us to.
+* @param[in] depth Moves left to look ahead.
+* @return How many moves early the win is, negative for a loss, 0 for a draw
+* or nothing found within depth.
+*/
+static int8_t
+negamax (int8_t alpha, int8_t beta, uint8_t depth)
+{
+    uint64_t chip;
+    int8_t   score;
+    int8_t   best;
+    uint8_t  column;
+    uint8_t  i;
+
+    // The search doesn't sleep, so the watchdog is fed and the host's frames
+    // answered from here
+    watchdog_service();
+    protocol_service();
+
+    // Out of time, engine_choose() throws this search away
+    if (expired || ((trace_now() - started) >= ENGINE_BUDGET_TICKS))
+    {
+        expired = 1;
+        return 0;
+    }
+
+    if (CELLS == moves)
+    {
+        return 0;
+    }
+
+    for (column = 0; column < ENGINE_COLUMNS; column++)
+    {
+        if (playable(column) && winning_move(column))
+        {
+            return (CELLS + 1 - moves) / 2;
+        }
+    }
+
+    if (0 == depth)
+    {
+        return 0;
+    }
+
+    // The opponent can't win on its next move, which caps our best score
+    best = (CELLS - 1 - moves) / 2;
+    if (beta > best)
+    {
+        beta = best;
+        if (alpha >= beta)
+        {
+            return beta;
+        }
+    }
+
+    for (i = 0; i < ENGINE_COLUMNS; i++)
+    {
+        column = column_order[i];
+        if (!playable(column))
+        {
+            continue;
+        }
+
+        chip     = (mask + bottom_masks[column]) & column_masks[column];
+        current ^= mask;
+        mask    |= chip;
+        moves++;
+
+        score = -negamax(-beta, -alpha, depth - 1);
+
+        moves--;
+        mask    ^= chip;
+        current ^= mask;
+
+        if (score >= beta)
+        {
+            return score;
+        }
+        if (score > alpha)
+        {
+            alpha = score;
+        }
+    }
+
+    return alpha;
+}   /* negamax() */
+
+/*!
+* @brief Clears the board for a new game.
+*/
+void
+engine_reset (void)
+{
+    current = 0;
+    mask    = 0;
+    moves   = 0;
+}   /* engine_reset() */
+
+/*!
+* @brief Records a chip played by either side, in turn order.
+* @param[in] column The column 0-6.
+* @return 1 if recorded, 0 if the column is full or out of range.
+*/
+uint8_t
+engine_play (uint8_t column)
+{
+    if ((column >= ENGINE_COLUMNS) || !playable(column))
+    {
+        return 0;
+    }
+
+    current ^= mask;
+    mask    |= mask + bottom_masks[column];
+    moves++;
+    return 1;
+}   /* engine_play() */
+
+/*!
+* @brief Searches each move for the player to move.
+* @param[in] depth Moves to look ahead after it.
+* @return The best column, ties going to the one nearest the center, or 7
+* if the board is full.
+*/
+static uint8_t
+search (uint8_t depth)
+{
+    uint64_t chip;
+    int8_t   alpha  = SCORE_MIN;
+    int8_t   score;
+    uint8_t  best   = ENGINE_COLUMNS;
+    uint8_t  column;
+    uint8_t  i;
+
+    for (i = 0; i < ENGINE_COLUMNS; i++)
+    {
+        column = column_order[i];
+        if (!playable(column))
+        {
+            continue;
+        }
+
+        chip     = (mask + bottom_masks[column]) & column_masks[column];
+        current ^= mask;
+        mask    |= chip;
+        moves++;
+
+        score = -negamax(-SCORE_MAX, -alpha, depth);
+
+        moves--;
+        mask    ^= chip;
+        current ^= mask;
+
+        if (score > alpha)
+        {
+            alpha = score;
+            best  = column;
+        }
+    }
+
+    return best;
+}   /* search() */
+
+/*!
+* @brief Picks a move for the player to move.
+* @param[in] depth Most moves to look ahead, ENGINE_DEPTH, each one costs
+* 2 to 4 times the one before.
+* @return The column 0-6, or 7 if the board is full.
+*
+* @par
+* Ties go to the column nearest the center. Should even the shallowest
+* search run out of time, that is the choice. The position is unchanged,
+* the chosen move still has to be recorded with engine_play() once it is
+* made.
+*/
+uint8_t
+engine_choose (uint8_t depth)
+{
+    uint8_t choice  = ENGINE_COLUMNS;
+    uint8_t best;
+    uint8_t column;
+    uint8_t level   = 0;
+    uint8_t i;
+
+    for (i = 0; i < ENGINE_COLUMNS; i++)
+    {
+        column = column_order[i];
+        if (!playable(column))
+        {
+            continue;
+        }
+        if (winning_move(column))
+        {
+            return column;
+        }
+        if (ENGINE_COLUMNS == choice)
+        {
+            choice = column;
+        }
+    }
+
+    started = trace_now();
+    expired = 0;
+    do
+    {
+        best = search(level);
+        if (expired)
+        {
+            break;
+        }
+        choice = best;
+    } while (++level < depth);
+
+    return choice;
+}   /* engine_choose() */
+
+/*** end of file ***/
@@ -0,0 +1,22 @@
+/******************************************************************************/
+
+/** @file engine.h
+*
+* @brief This module picks the robot's move with a negamax search.
+*/
+
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#define ENGINE_ROWS             6
+#define ENGINE_COLUMNS          7
+
+void engine_reset(void);
+
+uint8_t engine_play(uint8_t column);
+
+uint8_t engine_choose(uint8_t depth);
+
+#endif /* ENGINE_H */
+
+/*** end of file ***/
@@ -0,0 +1,459 @@
+/******************************************************************************/
+
+/** @file bench.c
+*
+* @brief Measures the robot's round trip and turn latencies, against a robot
+* on a serial port or the simulated one on a pseudo terminal.
+*
+* @par
+* Without -d the simulator built alongside is started with -P and driven
+* through its terminal, at the pace a robot keeps, and stopped at the end.
+*
+* @par
+* Round trips are ] echo tests, timed to the ACK and to the echoed reply.
+* Turns are robot turns of a game started with @, timed from the column
+* being sent to the W or z that ends the turn, and ended with O since
+* there is no human to play against. Each is printed as a histogram, with
+* the link counters at the end. Without frames (-l) there are no echo tests
+* and only the turns are timed.
+*
+* @par
+* Usage: connect4_bench [-d device] [-S sim] [-l] [-n echoes] [-t turns] [-e] [-s seed]
+*/
+
+#define _GNU_SOURCE
+
+// Includes
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "client.h"
+
+#define DEFAULT_ECHOES          200
+#define DEFAULT_TURNS           20
+#define ECHO_TIMEOUT_MS         1000
+#define TURN_TIMEOUT_MS         20000
+#define LINK_TIMEOUT_MS         5000
+#define BOOT_MS                 2000    // Homing from the far end included
+#define ECHO_BYTES              6
+#define BUCKETS                 24      // Powers of 2 from 1us
+#define COLUMNS                 7
+#define NS_PER_US               1000
+
+// Latencies taken for one histogram
+typedef struct
+{
+    const char *name;
+    int64_t    *samples;    // ns
+    uint32_t    count;
+    uint32_t    failed;
+} bench_series_t;
+
+// Local variables
+static pid_t        sim_pid     = -1;
+static char         sim_link[64];
+
+/*!
+* @brief Prints the command line options.
+*/
+static void
+usage (const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -d device    robot's serial port, instead of starting the simulator\n"
+            "  -S sim       simulator to start (%s)\n"
+            "  -l           legacy 1 byte instructions, turns only\n"
+            "  -n echoes    round trips to time (%d)\n"
+            "  -t turns     robot turns to time (%d)\n"
+            "  -e           have the robot choose its own columns\n"
+            "  -s seed      random seed for the columns and the simulator\n",
+            name, CONNECT4_SIM, DEFAULT_ECHOES, DEFAULT_TURNS);
+    exit(2);
+}   /* usage() */
+
+/*!
+* @brief Starts the simulator on a pseudo terminal and waits for its link.
+* @param[in] sim The simulator.
+* @param[in] seed Its random seed.
+* @return The link to open, or 0 if it never came up.
+*/
+static const char *
+bench_start_sim (const char *sim, uint32_t seed)
+{
+    char    seed_arg[16];
+    int64_t deadline = client_now() + (int64_t)LINK_TIMEOUT_MS * 1000000;
+
+    snprintf(sim_link, sizeof(sim_link), "/tmp/connect4_bench.%d", (int)getpid());
+    snprintf(seed_arg, sizeof(seed_arg), "%u", seed);
+
+    sim_pid = fork();
+    if (0 == sim_pid)
+    {
+        execl(sim, sim, "-P", sim_link, "-s", seed_arg, (char *)0);
+        perror(sim);
+        _exit(127);
+    }
+    if (sim_pid < 0)
+    {
+        perror("fork");
+        return 0;
+    }
+
+    while (access(sim_link, F_OK))
+    {
+        if ((client_now() > deadline) || (waitpid(sim_pid, 0, WNOHANG) == sim_pid))
+        {
+            sim_pid = -1;
+            return 0;
+        }
+        usleep(10000);
+    }
+    return sim_link;
+}   /* bench_start_sim() */
+
+/*!
+* @brief Stops the simulator, if one was started.
+*/
+static void
+bench_stop_sim (void)
+{
+    if (sim_pid > 0)
+    {
+        kill(sim_pid, SIGTERM);
+        waitpid(sim_pid, 0, 0);
+        sim_pid = -1;
+    }
+}   /* bench_stop_sim() */
+
+/*!
+* @brief Orders two latencies for qsort().
+*/
+static int
+bench_compare (const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+
+    return (x > y) - (x < y);
+}   /* bench_compare() */
+
+/*!
+* @brief Gets a percentile from sorted latencies, nearest rank.
+* @return The latency in us.
+*/
+static double
+bench_percentile (const bench_series_t *series, uint32_t percent)
+{
+    uint32_t rank = (uint32_t)(((uint64_t)series->count * percent + 99) / 100);
+
+    return (double)series->samples[rank ? rank - 1 : 0] / NS_PER_US;
+}   /* bench_percentile() */
+
+/*!
+* @brief Prints a summary and a log2 histogram of a series.
+*/
+static void
+bench_report (bench_series_t *series)
+{
+    uint32_t buckets[BUCKETS] = {0};
+    uint32_t most = 0;
+    uint32_t bucket;
+    uint32_t i;
+    int64_t  us;
+    double   total = 0;
+
+    printf("%s: n %u failed %u", series->name, series->count, series->failed);
+    if (0 == series->count)
+    {
+        printf("\n\n");
+        return;
+    }
+
+    qsort(series->samples, series->count, sizeof(series->samples[0]), bench_compare);
+    for (i = 0; i < series->count; i++)
+    {
+        total += series->samples[i];
+        us     = series->samples[i] / NS_PER_US;
+        for (bucket = 0; (bucket < BUCKETS - 1) && (us >= (2LL << bucket)); bucket++)
+        {
+        }
+        buckets[bucket]++;
+        if (buckets[bucket] > most)
+        {
+            most = buckets[bucket];
+        }
+    }
+    printf(" us min %.0f mean %.0f p50 %.0f p90 %.0f p99 %.0f max %.0f\n",
+           (double)series->samples[0] / NS_PER_US, total / series->count / NS_PER_US,
+           bench_percentile(series, 50), bench_percentile(series, 90), bench_percentile(series, 99),
+           (double)series->samples[series->count - 1] / NS_PER_US);
+
+    for (bucket = 0; bucket < BUCKETS; bucket++)
+    {
+        if (buckets[bucket])
+        {
+            printf("  %9lld us | %-40.*s %u\n", 1LL << bucket,
+                   (int)((buckets[bucket] * 40 + most - 1) / most),
+                   "########################################", buckets[bucket]);
+        }
+    }
+    printf("\n");
+}   /* bench_report() */
+
+/*!
+* @brief Works out how much of a timeout is left.
+* @param[in] start client_now() when it started.
+* @param[in] timeout_ms The timeout.
+* @return The ms left, 0 once it has run out.
+*/
+static int
+bench_left (int64_t start, int timeout_ms)
+{
+    int64_t left = start + (int64_t)timeout_ms * 1000000 - client_now();
+
+    return (left > 0) ? (int)(left / 1000000) : 0;
+}   /* bench_left() */
+
+/*!
+* @brief Times echo tests to the ACK and to the reply.
+* @param[in] count How many to time.
+* @param[out] ack Time to the ACK.
+* @param[out] reply Time to the echoed reply.
+*/
+static void
+bench_echoes (client_t *client, uint32_t count, bench_series_t *ack, bench_series_t *reply)
+{
+    uint8_t          request[1 + ECHO_BYTES] = {0};
+    client_message_t message;
+    int64_t          start;
+    int64_t          acked;
+    uint32_t         i;
+    uint8_t          j;
+    int              found;
+
+    for (i = 0; i < count; i++)
+    {
+        for (j = 1; j <= ECHO_BYTES; j++)
+        {
+            request[j] = (uint8_t)(i * 7 + j);
+        }
+
+        start = client_now();
+        if (client_send(client, ']', request, sizeof(request)))
+        {
+            ack->failed++;
+            reply->failed++;
+            client_resync(client);
+            continue;
+        }
+        acked = client_now();
+        ack->samples[ack->count++] = acked - start;
+
+        // Replies to earlier echoes that timed out are passed over
+        do
+        {
+            found = (client_receive(client, &message, bench_left(start, ECHO_TIMEOUT_MS)) > 0);
+        }
+        while (found && ((']' != message.op) || (sizeof(request) != message.len)
+                         || memcmp(message.data, request, sizeof(request))));
+        if (!found)
+        {
+            reply->failed++;
+            client_resync(client);
+            continue;
+        }
+        reply->samples[reply->count++] = message.time - start;
+    }
+}   /* bench_echoes() */
+
+/*!
+* @brief Times robot turns, one per game.
+* @param[in] count How many to time.
+* @param[in] engine 1 for the robot to choose its columns.
+* @param[out] turns Time from the column to the end of the turn.
+*/
+static void
+bench_turns (client_t *client, uint32_t count, uint8_t engine, bench_series_t *turns)
+{
+    client_turn_t turn;
+    uint8_t       column;
+    int64_t       start;
+    uint32_t      i;
+
+    for (i = 0; i < count; i++)
+    {
+        column = engine ? CLIENT_NO_COLUMN : (uint8_t)(rand() % COLUMNS);
+
+        if (client_start(client, CLIENT_ROBOT_FIRST))
+        {
+            turns->failed++;
+            client_resync(client);
+            continue;
+        }
+        start = client_now();
+        if (client_turn(client, column, &turn, TURN_TIMEOUT_MS) || turn.unseen)
+        {
+            turns->failed++;
+            client_resync(client);
+        }
+        else
+        {
+            turns->samples[turns->count++] = client_now() - start;
+        }
+
+        if (client_status(client, 1))
+        {
+            client_resync(client);
+        }
+    }
+}   /* bench_turns() */
+
+/*!
+* @brief Waits for the robot to answer, then clears the link.
+* @return 0 once it answers, -1 if it never does.
+*
+* @par
+* Without frames there is nothing to ask, so this waits for the robot to be
+* quiet for long enough to have booted.
+*/
+static int
+bench_ready (client_t *client)
+{
+    int64_t start = client_now();
+    uint8_t probe = 0;
+
+    if (!client->framed)
+    {
+        usleep(BOOT_MS * 1000);
+        client_resync(client);
+        return 0;
+    }
+    while (client_echo(client, &probe, 1, ECHO_TIMEOUT_MS))
+    {
+        if (!bench_left(start, LINK_TIMEOUT_MS))
+        {
+            return -1;
+        }
+    }
+    client_resync(client);
+    memset(&client->stats, 0, sizeof(client->stats));
+    return 0;
+}   /* bench_ready() */
+
+int
+main (int argc, char **argv)
+{
+    const char     *device  = 0;
+    const char     *sim     = CONNECT4_SIM;
+    uint8_t         framed  = 1;
+    uint32_t        echoes  = DEFAULT_ECHOES;
+    uint32_t        count   = DEFAULT_TURNS;
+    uint8_t         engine  = 0;
+    uint32_t        seed    = 1;
+    client_t        client;
+    bench_series_t  ack     = { "echo ack", 0, 0, 0 };
+    bench_series_t  reply   = { "echo reply", 0, 0, 0 };
+    bench_series_t  turns   = { "robot turn", 0, 0, 0 };
+    client_stats_t *stats   = &client.stats;
+    int             option;
+
+    while ((option = getopt(argc, argv, "d:S:ln:t:es:h")) != -1)
+    {
+        switch (option)
+        {
+        case 'd':
+            device = optarg;
+            break;
+
+        case 'S':
+            sim = optarg;
+            break;
+
+        case 'l':
+            framed = 0;
+            break;
+
+        case 'n':
+            echoes = (uint32_t)strtoul(optarg, 0, 0);
+            break;
+
+        case 't':
+            count = (uint32_t)strtoul(optarg, 0, 0);
+            break;
+
+        case 'e':
+            engine = 1;
+            break;
+
+        case 's':
+            seed = (uint32_t)strtoul(optarg, 0, 0);
+            break;
+
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (!framed)
+    {
+        echoes = 0;
+    }
+    srand(seed);
+
+    if (!device)
+    {
+        device = bench_start_sim(sim, seed);
+        if (!device)
+        {
+            fprintf(stderr, "connect4_bench: %s never brought up its link\n", sim);
+            return 1;
+        }
+    }
+    if (client_open(&client, device, framed))
+    {
+        perror(device);
+        bench_stop_sim();
+        return 1;
+    }
+
+    ack.samples   = calloc(echoes + 1, sizeof(int64_t));
+    reply.samples = calloc(echoes + 1, sizeof(int64_t));
+    turns.samples = calloc(count + 1, sizeof(int64_t));
+
+    // Anything sent while the robot boots may be lost or taken for something else
+    if (bench_ready(&client))
+    {
+        fprintf(stderr, "connect4_bench: no answer from the robot on %s\n", device);
+        client_close(&client);
+        bench_stop_sim();
+        return 1;
+    }
+
+    bench_echoes(&client, echoes, &ack, &reply);
+    bench_turns(&client, count, engine, &turns);
+
+    printf("connect4_bench: %s, %s\n\n", device, framed ? "framed" : "legacy");
+    if (framed)
+    {
+        bench_report(&ack);
+        bench_report(&reply);
+    }
+    bench_report(&turns);
+    printf("link: sent %u received %u retries %u bad frames %u repeats %u resyncs %u noise %u overflows %u\n",
+           stats->sent, stats->received, stats->retries, stats->bad_frames, stats->repeats, stats->resyncs,
+           stats->noise, stats->overflows);
+
+    client_close(&client);
+    bench_stop_sim();
+    free(ack.samples);
+    free(reply.samples);
+    free(turns.samples);
+    return (ack.failed || reply.failed || turns.failed) ? 1 : 0;
+}
+
+/*** end of file ***/
@@ -0,0 +1,940 @@
+/******************************************************************************/
+
+/** @file client.c
+*
+* @brief Host side of the robot's UART protocol, over a serial port or the
+* simulator's pseudo terminal.
+*
+* @par
+* Speaks either the 1 byte instructions listed in uart.c or the CRC checked
+* frames described in protocol.c, with the frame format, CRC, sequence
+* numbers and timeouts the firmware uses. Maintenance instructions carry
+* data both ways, so they need frames.
+*
+* @par
+* The port is raw at 115200 baud, non-blocking and watched through an epoll
+* instance. client_poll() waits on it once and runs whatever came in
+* through the frame parser, which answers the robot's frames with ACKs
+* straight away and queues the instructions they carry. client_fd() gives
+* the epoll instance to a caller with an event loop of its own, which calls
+* client_poll() with no timeout whenever it is readable. Everything else
+* here is built on client_poll() and waits with a timeout.
+*
+* @par
+* A frame the robot doesn't acknowledge within ack_timeout is sent again,
+* up to retries times, and the robot knows a frame it has already taken by
+* its sequence number. A frame from the robot that stalls part way through,
+* or fails its CRC, is dropped and the parser waits for the next SOF, so
+* the link resynchronizes by itself. client_resync() also throws away
+* whatever is waiting, for after a timeout.
+*
+* @par
+* Functions return 0 or a count on success and -1 with errno set on
+* failure: ETIMEDOUT when the robot doesn't answer in time, EPROTO when it
+* answers with something else, ENOTSUP for maintenance without frames.
+*/
+
+#define _GNU_SOURCE
+
+// Includes
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include "client.h"
+
+#define SOF                 0xA5
+#define OP_ACK              0x06
+#define OP_NACK             0x15
+#define OP_TEST             0x5D    // ]
+#define OP_DUMP             0x5E    // ^
+#define OP_BUSY             0x7B    // {
+#define OP_NO_MOVE          0x7C    // |
+#define TEST_ECHO           0
+#define TEST_JOG            1
+#define ACK_TIMEOUT_MS      250     // The robot only reads between jobs
+#define RETRIES             5
+#define BYTE_TIMEOUT_NS     50000000    // A gap this long abandons a frame
+#define NACK_QUIET_MS       25      // The robot drops what follows a bad frame until its line is quiet for 16ms
+#define NS_PER_MS           1000000
+
+typedef enum
+{
+    RX_SOF,
+    RX_LEN,
+    RX_BODY,
+    RX_CRC_L,
+    RX_CRC_H
+} rx_state_t;
+
+/*!
+* @brief Gets the time on the monotonic clock.
+* @return The time in ns.
+*/
+int64_t
+client_now (void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}   /* client_now() */
+
+/*!
+* @brief Works out how long is left until a deadline.
+* @param[in] deadline client_now() to stop at, or -1 for never.
+* @return The ms left for epoll_wait(), -1 for no limit.
+*/
+static int
+client_left (int64_t deadline)
+{
+    int64_t left;
+
+    if (deadline < 0)
+    {
+        return -1;
+    }
+    left = deadline - client_now();
+    return (left <= 0) ? 0 : (int)((left + NS_PER_MS - 1) / NS_PER_MS);
+}   /* client_left() */
+
+/*!
+* @brief Works out the deadline for a timeout.
+* @param[in] timeout_ms The timeout, or -1 for none.
+* @return client_now() to stop at, or -1 for never.
+*/
+static int64_t
+client_deadline (int timeout_ms)
+{
+    return (timeout_ms < 0) ? -1 : client_now() + (int64_t)timeout_ms * NS_PER_MS;
+}   /* client_deadline() */
+
+/*!
+* @brief Computes the frame CRC, CRC-16/CCITT-FALSE as the robot's CRC module
+* does it.
+* @param[in] crc The CRC so far, 0xFFFF to start.
+* @param[in] data The bytes.
+* @param[in] len The number of bytes.
+* @return The CRC.
+*/
+static uint16_t
+client_crc (uint16_t crc, const uint8_t *data, uint16_t len)
+{
+    uint8_t bit;
+
+    while (len--)
+    {
+        crc ^= (uint16_t)*data++ << 8;
+        for (bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}   /* client_crc() */
+
+/*!
+* @brief Writes bytes to the port, waiting for room if it has to.
+* @return 0, or -1 if the port fails.
+*/
+static int
+client_write (client_t *client, const uint8_t *data, size_t len)
+{
+    struct pollfd wait = { client->fd, POLLOUT, 0 };
+    ssize_t       written;
+
+    while (len)
+    {
+        written = write(client->fd, data, len);
+        if (written > 0)
+        {
+            data += written;
+            len  -= written;
+        }
+        else if ((written < 0) && (EAGAIN != errno) && (EINTR != errno))
+        {
+            return -1;
+        }
+        else
+        {
+            poll(&wait, 1, -1);
+        }
+    }
+    return 0;
+}   /* client_write() */
+
+/*!
+* @brief Sends one frame.
+* @param[in] op The instruction, ACK or NACK.
+* @param[in] seq The sequence number.
+* @param[in] data The payload.
+* @param[in] len The number of payload bytes.
+*/
+static int
+client_write_frame (client_t *client, uint8_t op, uint8_t seq, const uint8_t *data, uint8_t len)
+{
+    uint8_t  frame[4 + CLIENT_MAX_SEND + 2];
+    uint16_t crc;
+
+    frame[0] = SOF;
+    frame[1] = len;
+    frame[2] = seq;
+    frame[3] = op;
+    memcpy(&frame[4], data, len);
+    crc = client_crc(0xFFFF, &frame[1], 3 + len);
+    frame[4 + len] = crc & 0xFF;
+    frame[5 + len] = crc >> 8;
+
+    return client_write(client, frame, 6 + len);
+}   /* client_write_frame() */
+
+/*!
+* @brief Decodes an instruction from the robot and queues it.
+* @param[in] op The 1 byte instruction.
+* @param[in] data The payload, framed only.
+* @param[in] len The number of payload bytes.
+*/
+static void
+client_queue (client_t *client, uint8_t op, const uint8_t *data, uint8_t len)
+{
+    client_message_t *message;
+
+    if (CLIENT_QUEUE == client->queued)
+    {
+        client->stats.overflows++;
+        return;
+    }
+
+    message         = &client->queue[client->queued++];
+    message->op     = op;
+    message->column = op & 0x07;
+    message->len    = len;
+    message->time   = client_now();
+    memcpy(message->data, data, len);
+
+    if (0x70 == (op & 0xF8) && (op != 0x77))         // p,q,r,s,t,u,v
+    {
+        message->kind = CLIENT_MOVE;
+    }
+    else if (0x68 == (op & 0xF8) && (op != 0x6F))    // h,i,j,k,l,m,n
+    {
+        message->kind = CLIENT_HUMAN;
+    }
+    else if ('W' == op)
+    {
+        message->kind = CLIENT_NO_ERROR;
+    }
+    else if ('x' == op)
+    {
+        message->kind = CLIENT_WRONG_COLUMN;
+    }
+    else if ('y' == op)
+    {
+        message->kind = CLIENT_JAMMED;
+    }
+    else if ('z' == op)
+    {
+        message->kind = CLIENT_SENSOR_FAULT;
+    }
+    else if (OP_BUSY == op)
+    {
+        message->kind = CLIENT_BUSY;
+    }
+    else if (OP_NO_MOVE == op)
+    {
+        message->kind = CLIENT_NO_MOVE;
+    }
+    else if ((op >= 'X') && (op <= '_'))
+    {
+        message->kind = CLIENT_REPLY;
+    }
+    else
+    {
+        message->kind = CLIENT_OTHER;
+    }
+    client->stats.received++;
+}   /* client_queue() */
+
+/*!
+* @brief Handles a complete frame from the robot: checks it, acknowledges it
+* and queues it.
+*/
+static void
+client_accept (client_t *client)
+{
+    uint8_t len = client->rx_frame[0];
+    uint8_t seq = client->rx_frame[1];
+    uint8_t op  = client->rx_frame[2];
+
+    if (client->rx_crc != client_crc(0xFFFF, client->rx_frame, 3 + len))
+    {
+        client->stats.bad_frames++;
+        client_write_frame(client, OP_NACK, seq, 0, 0);
+        return;
+    }
+
+    // Reply to a frame sent by client_send()
+    if ((OP_ACK == op) || (OP_NACK == op))
+    {
+        if (seq == client->tx_seq)
+        {
+            client->tx_reply = op;
+        }
+        return;
+    }
+
+    client_write_frame(client, OP_ACK, seq, 0, 0);
+
+    // Repeat of the last frame because our ACK was lost
+    if (client->rx_seq_valid && (seq == client->rx_seq))
+    {
+        client->stats.repeats++;
+        return;
+    }
+    client->rx_seq       = seq;
+    client->rx_seq_valid = 1;
+    client_queue(client, op, &client->rx_frame[3], len);
+}   /* client_accept() */
+
+/*!
+* @brief Runs one received byte through the frame parser.
+* @param[in] byte The received byte.
+* @param[in] now client_now() when it was read.
+*/
+static void
+client_parse (client_t *client, uint8_t byte, int64_t now)
+{
+    // Resynchronize if a frame stalled part way through
+    if ((RX_SOF != client->rx_state) && ((now - client->rx_time) > BYTE_TIMEOUT_NS))
+    {
+        client->rx_state = RX_SOF;
+        client->stats.resyncs++;
+    }
+    client->rx_time = now;
+
+    switch ((rx_state_t)client->rx_state)
+    {
+    case RX_SOF:
+        if (client->framed && (SOF == byte))
+        {
+            client->rx_state = RX_LEN;
+        }
+        else if (0x40 == (byte & 0xC0)) // 01 header, legacy instruction
+        {
+            client_queue(client, byte, 0, 0);
+        }
+        else
+        {
+            client->stats.noise++;
+        }
+        break;
+
+    case RX_LEN:
+        client->rx_frame[0] = byte;
+        client->rx_count    = 1;
+        client->rx_state    = RX_BODY;
+        break;
+
+    case RX_BODY:
+        client->rx_frame[client->rx_count++] = byte;
+        if ((3 + client->rx_frame[0]) == client->rx_count)
+        {
+            client->rx_state = RX_CRC_L;
+        }
+        break;
+
+    case RX_CRC_L:
+        client->rx_crc   = byte;
+        client->rx_state = RX_CRC_H;
+        break;
+
+    case RX_CRC_H:
+        client->rx_crc  |= (uint16_t)byte << 8;
+        client->rx_state = RX_SOF;
+        client_accept(client);
+        break;
+    }
+}   /* client_parse() */
+
+/*!
+* @brief Opens the robot's serial port.
+* @param[out] client The connection.
+* @param[in] path The serial device, or the simulator's pseudo terminal.
+* @param[in] framed 1 to send frames, 0 for legacy 1 byte instructions.
+* @return 0, or -1 if the port can't be opened.
+*/
+int
+client_open (client_t *client, const char *path, uint8_t framed)
+{
+    struct termios     settings;
+    struct epoll_event event = {0};
+
+    memset(client, 0, sizeof(*client));
+    client->epoll       = -1;
+    client->framed      = framed;
+    client->ack_timeout = ACK_TIMEOUT_MS;
+    client->retries     = RETRIES;
+
+    client->fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (client->fd < 0)
+    {
+        return -1;
+    }
+    if (tcgetattr(client->fd, &settings) == 0)
+    {
+        cfmakeraw(&settings);
+        cfsetispeed(&settings, B115200);
+        cfsetospeed(&settings, B115200);
+        settings.c_cflag |= CLOCAL | CREAD;
+        tcsetattr(client->fd, TCSANOW, &settings);
+        tcflush(client->fd, TCIOFLUSH);
+    }
+
+    client->epoll    = epoll_create1(EPOLL_CLOEXEC);
+    event.events     = EPOLLIN;
+    event.data.fd    = client->fd;
+    if ((client->epoll < 0) || epoll_ctl(client->epoll, EPOLL_CTL_ADD, client->fd, &event))
+    {
+        client_close(client);
+        return -1;
+    }
+    return 0;
+}   /* client_open() */
+
+/*!
+* @brief Closes the connection.
+*/
+void
+client_close (client_t *client)
+{
+    if (client->epoll >= 0)
+    {
+        close(client->epoll);
+    }
+    if (client->fd >= 0)
+    {
+        close(client->fd);
+    }
+    client->epoll = -1;
+    client->fd    = -1;
+}   /* client_close() */
+
+/*!
+* @brief Gets a descriptor for a caller's own event loop, readable whenever
+* client_poll() has something to do.
+* @return The epoll instance.
+*/
+int
+client_fd (const client_t *client)
+{
+    return client->epoll;
+}   /* client_fd() */
+
+/*!
+* @brief Waits for bytes from the robot and runs them through the parser.
+* @param[in] timeout_ms How long to wait, 0 not to, -1 for ever.
+* @return The number of bytes taken, 0 if none came, -1 if the port fails.
+*/
+int
+client_poll (client_t *client, int timeout_ms)
+{
+    struct epoll_event event;
+    uint8_t            buffer[256];
+    ssize_t            count;
+    ssize_t            i;
+    int                taken = 0;
+    int64_t            now;
+
+    count = epoll_wait(client->epoll, &event, 1, timeout_ms);
+    if (count <= 0)
+    {
+        return ((count < 0) && (EINTR != errno)) ? -1 : 0;
+    }
+
+    for (;;)
+    {
+        count = read(client->fd, buffer, sizeof(buffer));
+        if (count <= 0)
+        {
+            break;
+        }
+        now = client_now();
+        for (i = 0; i < count; i++)
+        {
+            client_parse(client, buffer[i], now);
+        }
+        taken += count;
+    }
+    if ((count < 0) && (EAGAIN != errno) && (EINTR != errno))
+    {
+        return -1;
+    }
+    return taken;
+}   /* client_poll() */
+
+/*!
+* @brief Throws away everything received and not yet taken, and any frame
+* part way through, to start afresh after a timeout. Waits for the line to
+* go quiet first, so a late reply isn't taken for the next one.
+*/
+void
+client_resync (client_t *client)
+{
+    tcflush(client->fd, TCIFLUSH);
+    while (client_poll(client, BYTE_TIMEOUT_NS / NS_PER_MS) > 0)
+    {
+    }
+    client->rx_state = RX_SOF;
+    client->queued   = 0;
+    client->stats.resyncs++;
+}   /* client_resync() */
+
+/*!
+* @brief Sends an instruction, framed if the connection frames.
+* @param[in] op The 1 byte instruction.
+* @param[in] data The payload, frames only.
+* @param[in] len The number of payload bytes, up to CLIENT_MAX_SEND.
+* @return 0 once sent and acknowledged, -1 if the robot never acknowledged
+* it.
+*
+* @par
+* In framed mode this waits for the ACK, sending the frame again on a NACK
+* or a timeout. Instructions received meanwhile are queued. After a NACK
+* nothing is sent for NACK_QUIET_MS, so the robot listens again in time for
+* the frame sent again.
+*/
+int
+client_send (client_t *client, uint8_t op, const uint8_t *data, uint8_t len)
+{
+    int64_t deadline;
+    uint8_t tries;
+
+    if ((len > CLIENT_MAX_SEND) || (!client->framed && len))
+    {
+        errno = client->framed ? EINVAL : ENOTSUP;
+        return -1;
+    }
+    client->stats.sent++;
+    if (!client->framed)
+    {
+        return client_write(client, &op, 1);
+    }
+
+    client->tx_seq++;
+    for (tries = 0; tries <= client->retries; tries++)
+    {
+        if (tries)
+        {
+            client->stats.retries++;
+        }
+        client->tx_reply = 0;
+        if (client_write_frame(client, op, client->tx_seq, data, len))
+        {
+            return -1;
+        }
+
+        deadline = client_deadline(client->ack_timeout);
+        while (!client->tx_reply && client_left(deadline))
+        {
+            if (client_poll(client, client_left(deadline)) < 0)
+            {
+                return -1;
+            }
+        }
+
+        if (OP_ACK == client->tx_reply)
+        {
+            return 0;
+        }
+        if (OP_NACK == client->tx_reply)
+        {
+            usleep(NACK_QUIET_MS * 1000);
+        }
+    }
+
+    errno = ETIMEDOUT;
+    return -1;
+}   /* client_send() */
+
+/*!
+* @brief Takes the oldest queued instruction matching an op.
+* @param[in] op The op, or 0 for any.
+* @param[out] message The instruction.
+* @return 1 if one was taken, 0 if none match.
+*/
+static int
+client_take (client_t *client, uint8_t op, client_message_t *message)
+{
+    uint8_t i;
+
+    for (i = 0; i < client->queued; i++)
+    {
+        if (!op || (client->queue[i].op == op))
+        {
+            *message = client->queue[i];
+            client->queued--;
+            memmove(&client->queue[i], &client->queue[i + 1], (client->queued - i) * sizeof(client->queue[0]));
+            return 1;
+        }
+    }
+    return 0;
+}   /* client_take() */
+
+/*!
+* @brief Waits for an instruction from the robot matching an op.
+* @param[in] op The op, or 0 for any.
+* @param[out] message The instruction.
+* @param[in] deadline client_now() to give up at, -1 for never.
+* @return 1 if one was taken, 0 on timeout, -1 if the port fails.
+*/
+static int
+client_wait (client_t *client, uint8_t op, client_message_t *message, int64_t deadline)
+{
+    while (!client_take(client, op, message))
+    {
+        if (!client_left(deadline))
+        {
+            return 0;
+        }
+        if (client_poll(client, client_left(deadline)) < 0)
+        {
+            return -1;
+        }
+    }
+    return 1;
+}   /* client_wait() */
+
+/*!
+* @brief Waits for the next instruction from the robot.
+* @param[out] message The instruction.
+* @param[in] timeout_ms How long to wait, 0 not to, -1 for ever.
+* @return 1 if one was taken, 0 on timeout, -1 if the port fails.
+*/
+int
+client_receive (client_t *client, client_message_t *message, int timeout_ms)
+{
+    return client_wait(client, 0, message, client_deadline(timeout_ms));
+}   /* client_receive() */
+
+/*!
+* @brief Sends a maintenance instruction and waits for its reply.
+* @param[in] op The instruction, X to _.
+* @param[in] data The payload.
+* @param[in] len The number of payload bytes.
+* @param[out] reply The reply, the same op with its data.
+* @param[in] timeout_ms How long to wait for the reply once acknowledged.
+* @return 0, or -1 on failure, with errno EBUSY if the robot is in a game.
+*
+* @par
+* Instructions that aren't the reply stay queued for client_receive().
+*/
+int
+client_request (client_t *client, uint8_t op, const uint8_t *data, uint8_t len, client_message_t *reply,
+                int timeout_ms)
+{
+    int64_t deadline;
+
+    if (!client->framed)
+    {
+        errno = ENOTSUP;
+        return -1;
+    }
+    if (client_send(client, op, data, len))
+    {
+        return -1;
+    }
+
+    deadline = client_deadline(timeout_ms);
+    while (!client_take(client, op, reply))
+    {
+        // Maintenance is answered in order, so { is for the oldest request
+        if (client_take(client, OP_BUSY, reply))
+        {
+            errno = EBUSY;
+            return -1;
+        }
+        if (!client_left(deadline))
+        {
+            errno = ETIMEDOUT;
+            return -1;
+        }
+        if (client_poll(client, client_left(deadline)) < 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}   /* client_request() */
+
+/*!
+* @brief Starts a game.
+* @param[in] first Who goes first.
+* @return 0, or -1 on failure.
+*/
+int
+client_start (client_t *client, client_first_t first)
+{
+    return client_send(client, (CLIENT_ROBOT_FIRST == first) ? '@' : 'G', 0, 0);
+}   /* client_start() */
+
+/*!
+* @brief Tells the robot whether the game goes on after a chip.
+* @param[in] over 1 if the game is over, 0 if it goes on.
+* @return 0, or -1 on failure.
+*/
+int
+client_status (client_t *client, uint8_t over)
+{
+    return client_send(client, over ? 'O' : 'H', 0, 0);
+}   /* client_status() */
+
+/*!
+* @brief Hints at the robot's next column, so the carriage can head there.
+* @param[in] column The column 0-6, or CLIENT_NO_COLUMN to withdraw it.
+* @return 0, or -1 on failure.
+*/
+int
+client_hint (client_t *client, uint8_t column)
+{
+    return client_send(client, 0x60 | (column & 0x07), 0, 0); // `,a,b,c,d,e,f,g
+}   /* client_hint() */
+
+/*!
+* @brief Tells the robot which column to play, without waiting for it.
+* @param[in] column The column 0-6, or CLIENT_NO_COLUMN for the robot to
+* choose.
+* @return 0, or -1 on failure.
+*/
+int
+client_play (client_t *client, uint8_t column)
+{
+    return client_send(client, 0x70 | (column & 0x07), 0, 0); // p,q,r,s,t,u,v,w
+}   /* client_play() */
+
+/*!
+* @brief Plays a robot turn and waits for the chip to be placed.
+* @param[in] column The column 0-6, or CLIENT_NO_COLUMN for the robot to
+* choose.
+* @param[out] turn How it went.
+* @param[in] timeout_ms How long the whole turn may take.
+* @return 0 once the robot reports W or z, or -1 on failure.
+*
+* @par
+* x and y don't end the turn, the robot keeps trying and they are noted in
+* turn. A | for a full board fails it with EINVAL. Other instructions stay
+* queued.
+*/
+int
+client_turn (client_t *client, uint8_t column, client_turn_t *turn, int timeout_ms)
+{
+    int64_t          deadline = client_deadline(timeout_ms);
+    client_message_t message;
+    uint8_t          i;
+    int              result;
+
+    memset(turn, 0, sizeof(*turn));
+    turn->column = column;
+    if (client_play(client, column))
+    {
+        return -1;
+    }
+
+    for (;;)
+    {
+        // Look through what has come in for the turn's instructions
+        for (i = 0; i < client->queued; i++)
+        {
+            message = client->queue[i];
+            if ((CLIENT_MOVE == message.kind) && (CLIENT_NO_COLUMN == column) && !turn->chosen)
+            {
+                turn->column = message.column;
+                turn->chosen = message.time;
+            }
+            else if (CLIENT_WRONG_COLUMN == message.kind)
+            {
+                turn->wrong_column = 1;
+            }
+            else if (CLIENT_JAMMED == message.kind)
+            {
+                turn->jammed = 1;
+            }
+            else if ((CLIENT_NO_ERROR == message.kind) || (CLIENT_SENSOR_FAULT == message.kind))
+            {
+                turn->unseen = (CLIENT_SENSOR_FAULT == message.kind);
+            }
+            else if ((CLIENT_NO_MOVE == message.kind) && (CLIENT_NO_COLUMN == column))
+            {
+                client_take(client, message.op, &message);
+                errno = EINVAL;
+                return -1;
+            }
+            else
+            {
+                continue;
+            }
+
+            client_take(client, message.op, &message);
+            i--;
+            if ((CLIENT_NO_ERROR == message.kind) || (CLIENT_SENSOR_FAULT == message.kind))
+            {
+                return 0;
+            }
+        }
+
+        if (!client_left(deadline))
+        {
+            errno = ETIMEDOUT;
+            return -1;
+        }
+        result = client_poll(client, client_left(deadline));
+        if (result < 0)
+        {
+            return -1;
+        }
+    }
+}   /* client_turn() */
+
+/*!
+* @brief Waits for the robot to see the human's chip.
+* @param[out] column The column it was seen in.
+* @param[in] timeout_ms How long to wait.
+* @return 0, or -1 on failure.
+*
+* @par
+* A z sent at the start of the human's turn for a failed sensor is taken
+* on the way.
+*/
+int
+client_wait_human (client_t *client, uint8_t *column, int timeout_ms)
+{
+    int64_t          deadline = client_deadline(timeout_ms);
+    client_message_t message;
+    int              result;
+
+    do
+    {
+        while (client_take(client, 'z', &message))
+        {
+        }
+        for (result = 0; (result < client->queued) && (CLIENT_HUMAN != client->queue[result].kind); result++)
+        {
+        }
+        if (result < client->queued)
+        {
+            client_take(client, client->queue[result].op, &message);
+            *column = message.column;
+            return 0;
+        }
+
+        if (!client_left(deadline))
+        {
+            errno = ETIMEDOUT;
+            return -1;
+        }
+    }
+    while (client_poll(client, client_left(deadline)) >= 0);
+
+    return -1;
+}   /* client_wait_human() */
+
+/*!
+* @brief Has the robot echo a payload back, to time the link.
+* @param[in] data The payload.
+* @param[in] len The number of payload bytes, up to CLIENT_MAX_SEND - 1.
+* @param[in] timeout_ms How long to wait for the echo.
+* @return 0 if it came back unchanged, or -1 on failure.
+*/
+int
+client_echo (client_t *client, const uint8_t *data, uint8_t len, int timeout_ms)
+{
+    uint8_t          request[CLIENT_MAX_SEND];
+    client_message_t reply;
+
+    if (len >= CLIENT_MAX_SEND)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    request[0] = TEST_ECHO;
+    memcpy(&request[1], data, len);
+    if (client_request(client, OP_TEST, request, 1 + len, &reply, timeout_ms))
+    {
+        return -1;
+    }
+    if ((reply.len != 1 + len) || memcmp(reply.data, request, 1 + len))
+    {
+        errno = EPROTO;
+        return -1;
+    }
+    return 0;
+}   /* client_echo() */
+
+/*!
+* @brief Moves the carriage, or homes it.
+* @param[in] steps Steps away from home, negative towards it, 0 to home.
+* @param[out] position Where the carriage ended up, or 0 to ignore it.
+* @param[in] timeout_ms How long to wait for the move.
+* @return 0, or -1 on failure.
+*/
+int
+client_jog (client_t *client, int16_t steps, int16_t *position, int timeout_ms)
+{
+    uint8_t          request[3] = { TEST_JOG, (uint16_t)steps & 0xFF, (uint16_t)steps >> 8 };
+    client_message_t reply;
+
+    if (client_request(client, OP_TEST, request, sizeof(request), &reply, timeout_ms))
+    {
+        return -1;
+    }
+    if ((reply.len < 4) || (TEST_JOG != reply.data[0]))
+    {
+        errno = EPROTO;
+        return -1;
+    }
+    if (position)
+    {
+        *position = (int16_t)(reply.data[1] | (reply.data[2] << 8));
+    }
+    return 0;
+}   /* client_jog() */
+
+/*!
+* @brief Gets the robot's diagnostic dump.
+* @param[out] dump The dump.
+* @param[in] timeout_ms How long to wait for it.
+* @return 0, or -1 on failure.
+*/
+int
+client_dump (client_t *client, client_dump_t *dump, int timeout_ms)
+{
+    client_message_t reply;
+    const uint8_t   *data = reply.data;
+
+    if (client_request(client, OP_DUMP, 0, 0, &reply, timeout_ms))
+    {
+        return -1;
+    }
+    if (reply.len < 14)
+    {
+        errno = EPROTO;
+        return -1;
+    }
+    dump->beams     = data[0];
+    dump->bump      = data[1];
+    dump->position  = (int16_t)(data[2] | (data[3] << 8));
+    dump->overruns  = data[4];
+    dump->cause     = data[5] | (data[6] << 8);
+    dump->resets    = data[7] | (data[8] << 8);
+    dump->faults    = data[9] | (data[10] << 8);
+    dump->missed    = data[11];
+    dump->missing   = data[12];
+    dump->home_failed = data[13];
+    return 0;
+}   /* client_dump() */
+
+/*** end of file ***/
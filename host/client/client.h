@@ -0,0 +1,138 @@
+/******************************************************************************/
+
+/** @file client.h
+*
+* @brief Host side of the robot's UART protocol, over a serial port or the
+* simulator's pseudo terminal.
+*/
+
+#ifndef CLIENT_H
+#define CLIENT_H
+
+#include <stdint.h>
+
+#define CLIENT_MAX_SEND         8       // Largest payload the robot takes, PROTOCOL_MAX_DATA
+#define CLIENT_MAX_DATA         255     // Largest payload a frame can carry
+#define CLIENT_QUEUE            16      // Instructions received and not yet taken
+#define CLIENT_NO_COLUMN        7       // Robot chooses, no hint, or a chip never seen
+
+// Who goes first, @ or G
+typedef enum
+{
+    CLIENT_ROBOT_FIRST,
+    CLIENT_HUMAN_FIRST
+} client_first_t;
+
+// What an instruction from the robot means
+typedef enum
+{
+    CLIENT_MOVE,            // p-v, the column the robot chose
+    CLIENT_HUMAN,           // h-n, the human's chip was seen
+    CLIENT_NO_ERROR,        // W, the robot's chip was seen in its column
+    CLIENT_WRONG_COLUMN,    // x, it was seen in another
+    CLIENT_JAMMED,          // y, it wasn't seen after jam recovery
+    CLIENT_SENSOR_FAULT,    // z, a photo-interrupter has failed
+    CLIENT_BUSY,            // {, a maintenance instruction refused during a game
+    CLIENT_NO_MOVE,         // |, w refused with the board full
+    CLIENT_REPLY,           // X-_, a maintenance reply with its data
+    CLIENT_OTHER
+} client_kind_t;
+
+// An instruction from the robot
+typedef struct
+{
+    client_kind_t   kind;
+    uint8_t         op;
+    uint8_t         column;         // For CLIENT_MOVE and CLIENT_HUMAN
+    uint8_t         len;
+    uint8_t         data[CLIENT_MAX_DATA];
+    int64_t         time;           // client_now() when it arrived
+} client_message_t;
+
+// How a robot turn went
+typedef struct
+{
+    uint8_t         column;         // Played, the robot's choice if it chose
+    uint8_t         wrong_column;   // x reported on the way
+    uint8_t         jammed;         // y reported on the way
+    uint8_t         unseen;         // Ended with z, dropped over a failed sensor
+    int64_t         chosen;         // client_now() when the robot named its column, 0 if given
+} client_turn_t;
+
+// The robot's ^ diagnostic dump, see diag.c
+typedef struct
+{
+    uint8_t         beams;          // Blocked now, bit n = column n
+    uint8_t         bump;           // 1 if the switch is pressed
+    int16_t         position;       // Carriage steps from home
+    uint8_t         overruns;       // Bytes the robot's UART dropped
+    uint16_t        cause;          // SYSRSTIV of the last reset
+    uint16_t        resets;
+    uint16_t        faults;
+    uint8_t         missed;         // Watchdog clients stopped before the last fault
+    uint8_t         missing;        // Watchdog clients stopped since
+    uint8_t         home_failed;    // 1 if the last homing never found the switch
+} client_dump_t;
+
+// Link counters
+typedef struct
+{
+    uint32_t        sent;           // Frames or bytes sent, retries not counted
+    uint32_t        received;       // Instructions received
+    uint32_t        retries;        // Frames sent again for a NACK or a lost ACK
+    uint32_t        bad_frames;     // Failed their CRC, NACKed
+    uint32_t        repeats;        // Robot frames received again, ACKed and dropped
+    uint32_t        resyncs;        // Frames abandoned part way through
+    uint32_t        noise;          // Bytes outside frames that mean nothing
+    uint32_t        overflows;      // Instructions dropped with the queue full
+} client_stats_t;
+
+// One connection to a robot
+typedef struct
+{
+    int                 fd;
+    int                 epoll;
+    uint8_t             framed;     // Frames with CRCs, or 1 byte legacy instructions
+    uint8_t             rx_state;
+    uint8_t             rx_frame[3 + CLIENT_MAX_DATA];     // LEN, SEQ, OP, DATA
+    uint16_t            rx_count;
+    uint16_t            rx_crc;
+    int64_t             rx_time;    // When the last byte came in
+    uint8_t             rx_seq;
+    uint8_t             rx_seq_valid;
+    uint8_t             tx_seq;
+    uint8_t             tx_reply;   // ACK or NACK for tx_seq, 0 until one comes
+    client_message_t    queue[CLIENT_QUEUE];
+    uint8_t             queued;
+    int                 ack_timeout;    // ms before a frame is sent again
+    uint8_t             retries;
+    client_stats_t      stats;
+} client_t;
+
+int64_t client_now(void);
+
+int client_open(client_t *client, const char *path, uint8_t framed);
+void client_close(client_t *client);
+int client_fd(const client_t *client);
+int client_poll(client_t *client, int timeout_ms);
+void client_resync(client_t *client);
+
+int client_send(client_t *client, uint8_t op, const uint8_t *data, uint8_t len);
+int client_receive(client_t *client, client_message_t *message, int timeout_ms);
+int client_request(client_t *client, uint8_t op, const uint8_t *data, uint8_t len, client_message_t *reply,
+                   int timeout_ms);
+
+int client_start(client_t *client, client_first_t first);
+int client_status(client_t *client, uint8_t over);
+int client_hint(client_t *client, uint8_t column);
+int client_play(client_t *client, uint8_t column);
+int client_turn(client_t *client, uint8_t column, client_turn_t *turn, int timeout_ms);
+int client_wait_human(client_t *client, uint8_t *column, int timeout_ms);
+
+int client_echo(client_t *client, const uint8_t *data, uint8_t len, int timeout_ms);
+int client_jog(client_t *client, int16_t steps, int16_t *position, int timeout_ms);
+int client_dump(client_t *client, client_dump_t *dump, int timeout_ms);
+
+#endif /* CLIENT_H */
+
+/*** end of file ***/
@@ -0,0 +1,797 @@
+/******************************************************************************/
+
+/** @file driverlib.c
+*
+* @brief Host stand-in for the MSP430 DriverLib calls declared in driverlib.h,
+* working on the simulated registers in periph.c.
+*
+* @par
+* The real DriverLib sources cannot be reused here because HWREG16() casts
+* register addresses to 16 bits. Each call below does what the matching
+* DriverLib function does to the registers, with sim_lock() held so the
+* simulation thread sees whole updates.
+*/
+
+// Includes
+#include <stdint.h>
+#include <stdbool.h>
+#include "driverlib.h"
+#include "periph.h"
+
+/******************************************************************************/
+// Direct register access
+
+/*!
+* @brief Gets a port register for the PxXXX macros.
+* @param[in] port The port 1-3.
+* @param[in] reg One of SIM_PIN to SIM_PSEL1.
+* @return The register, with PxIN brought up to date.
+*/
+volatile uint8_t *
+sim_port_reg (uint8_t port, uint8_t reg)
+{
+    sim_lock();
+    periph_port_update(port);
+    sim_unlock();
+    return &periph_ports[port].reg[reg];
+}   /* sim_port_reg() */
+
+/*!
+* @brief Reads PxIV, clearing the flag it reports.
+* @param[in] port The port 1-2.
+* @return 2 * (pin + 1) for the lowest pin flagged and enabled, 0 if none.
+*/
+uint16_t
+sim_port_iv (uint8_t port)
+{
+    sim_port_t *p = &periph_ports[port];
+    uint16_t    iv = 0;
+    uint8_t     pin;
+
+    sim_lock();
+    for (pin = 0; pin < 8; pin++)
+    {
+        if (p->reg[SIM_PIFG] & p->reg[SIM_PIE] & (1 << pin))
+        {
+            p->reg[SIM_PIFG] &= ~(1 << pin);
+            iv = 2 * (pin + 1);
+            break;
+        }
+    }
+    sim_unlock();
+    return iv;
+}   /* sim_port_iv() */
+
+/*!
+* @brief Gets a timer register for the TAxXXX macros.
+* @param[in] base TIMER_A0_BASE to TIMER_A3_BASE.
+* @param[in] reg One of SIM_TACTL to SIM_TACCR2.
+* @return The register.
+*/
+volatile uint16_t *
+sim_timer_reg (uint16_t base, uint8_t reg)
+{
+    return &periph_timers[periph_timer_index(base)].reg[reg];
+}   /* sim_timer_reg() */
+
+/*!
+* @brief Reads UCAxIV, clearing the flag it reports.
+* @param[in] base EUSCI_A0_BASE or EUSCI_A1_BASE.
+* @return One of the USCI_UART_* vector values, USCI_NONE if none.
+*/
+uint16_t
+sim_uart_iv (uint16_t base)
+{
+    sim_uart_t *u       = &periph_uarts[periph_uart_index(base)];
+    uint16_t    pending;
+    uint16_t    iv      = USCI_NONE;
+    uint8_t     n;
+
+    sim_lock();
+    pending = u->ie & u->ifg;
+    for (n = 0; n < 4; n++)
+    {
+        if (pending & (1 << n))
+        {
+            u->ifg &= ~(1 << n);
+            iv = 2 * (n + 1);
+            break;
+        }
+    }
+    sim_unlock();
+    return iv;
+}   /* sim_uart_iv() */
+
+/******************************************************************************/
+// GPIO
+
+void
+GPIO_setAsOutputPin (uint8_t selectedPort, uint16_t selectedPins)
+{
+    sim_port_t *p = &periph_ports[selectedPort];
+
+    sim_lock();
+    p->reg[SIM_PSEL0] &= ~selectedPins;
+    p->reg[SIM_PSEL1] &= ~selectedPins;
+    p->reg[SIM_PDIR]  |= selectedPins;
+    sim_unlock();
+}
+
+void
+GPIO_setAsInputPin (uint8_t selectedPort, uint16_t selectedPins)
+{
+    sim_port_t *p = &periph_ports[selectedPort];
+
+    sim_lock();
+    p->reg[SIM_PSEL0] &= ~selectedPins;
+    p->reg[SIM_PSEL1] &= ~selectedPins;
+    p->reg[SIM_PDIR]  &= ~selectedPins;
+    p->reg[SIM_PREN]  &= ~selectedPins;
+    sim_unlock();
+}
+
+void
+GPIO_setAsPeripheralModuleFunctionOutputPin (uint8_t selectedPort, uint16_t selectedPins, uint8_t mode)
+{
+    sim_port_t *p = &periph_ports[selectedPort];
+
+    sim_lock();
+    p->reg[SIM_PDIR] |= selectedPins;
+    p->reg[SIM_PSEL0] = (mode & 0x01) ? (p->reg[SIM_PSEL0] | selectedPins) : (p->reg[SIM_PSEL0] & ~selectedPins);
+    p->reg[SIM_PSEL1] = (mode & 0x02) ? (p->reg[SIM_PSEL1] | selectedPins) : (p->reg[SIM_PSEL1] & ~selectedPins);
+    sim_unlock();
+}
+
+void
+GPIO_setAsPeripheralModuleFunctionInputPin (uint8_t selectedPort, uint16_t selectedPins, uint8_t mode)
+{
+    sim_port_t *p = &periph_ports[selectedPort];
+
+    sim_lock();
+    p->reg[SIM_PDIR] &= ~selectedPins;
+    p->reg[SIM_PSEL0] = (mode & 0x01) ? (p->reg[SIM_PSEL0] | selectedPins) : (p->reg[SIM_PSEL0] & ~selectedPins);
+    p->reg[SIM_PSEL1] = (mode & 0x02) ? (p->reg[SIM_PSEL1] | selectedPins) : (p->reg[SIM_PSEL1] & ~selectedPins);
+    sim_unlock();
+}
+
+void
+GPIO_setOutputHighOnPin (uint8_t selectedPort, uint16_t selectedPins)
+{
+    sim_lock();
+    periph_ports[selectedPort].reg[SIM_POUT] |= selectedPins;
+    sim_unlock();
+}
+
+void
+GPIO_setOutputLowOnPin (uint8_t selectedPort, uint16_t selectedPins)
+{
+    sim_lock();
+    periph_ports[selectedPort].reg[SIM_POUT] &= ~selectedPins;
+    sim_unlock();
+}
+
+void
+GPIO_toggleOutputOnPin (uint8_t selectedPort, uint16_t selectedPins)
+{
+    sim_lock();
+    periph_ports[selectedPort].reg[SIM_POUT] ^= selectedPins;
+    sim_unlock();
+}
+
+void
+GPIO_setAsInputPinWithPullDownResistor (uint8_t selectedPort, uint16_t selectedPins)
+{
+    sim_port_t *p = &periph_ports[selectedPort];
+
+    sim_lock();
+    p->reg[SIM_PSEL0] &= ~selectedPins;
+    p->reg[SIM_PSEL1] &= ~selectedPins;
+    p->reg[SIM_PDIR]  &= ~selectedPins;
+    p->reg[SIM_PREN]  |= selectedPins;
+    p->reg[SIM_POUT]  &= ~selectedPins;
+    sim_unlock();
+}
+
+void
+GPIO_setAsInputPinWithPullUpResistor (uint8_t selectedPort, uint16_t selectedPins)
+{
+    sim_port_t *p = &periph_ports[selectedPort];
+
+    sim_lock();
+    p->reg[SIM_PSEL0] &= ~selectedPins;
+    p->reg[SIM_PSEL1] &= ~selectedPins;
+    p->reg[SIM_PDIR]  &= ~selectedPins;
+    p->reg[SIM_PREN]  |= selectedPins;
+    p->reg[SIM_POUT]  |= selectedPins;
+    sim_unlock();
+}
+
+uint8_t
+GPIO_getInputPinValue (uint8_t selectedPort, uint16_t selectedPins)
+{
+    uint8_t value;
+
+    sim_lock();
+    periph_port_update(selectedPort);
+    value = (periph_ports[selectedPort].reg[SIM_PIN] & selectedPins) ? GPIO_INPUT_PIN_HIGH : GPIO_INPUT_PIN_LOW;
+    sim_unlock();
+    return value;
+}
+
+void
+GPIO_enableInterrupt (uint8_t selectedPort, uint16_t selectedPins)
+{
+    sim_lock();
+    periph_ports[selectedPort].reg[SIM_PIE] |= selectedPins;
+    sim_unlock();
+}
+
+void
+GPIO_disableInterrupt (uint8_t selectedPort, uint16_t selectedPins)
+{
+    sim_lock();
+    periph_ports[selectedPort].reg[SIM_PIE] &= ~selectedPins;
+    sim_unlock();
+}
+
+uint16_t
+GPIO_getInterruptStatus (uint8_t selectedPort, uint16_t selectedPins)
+{
+    uint16_t status;
+
+    sim_lock();
+    status = periph_ports[selectedPort].reg[SIM_PIFG] & selectedPins;
+    sim_unlock();
+    return status;
+}
+
+void
+GPIO_clearInterrupt (uint8_t selectedPort, uint16_t selectedPins)
+{
+    sim_lock();
+    periph_ports[selectedPort].reg[SIM_PIFG] &= ~selectedPins;
+    sim_unlock();
+}
+
+void
+GPIO_selectInterruptEdge (uint8_t selectedPort, uint16_t selectedPins, uint8_t edgeSelect)
+{
+    sim_port_t *p = &periph_ports[selectedPort];
+
+    sim_lock();
+    p->reg[SIM_PIES] = (GPIO_HIGH_TO_LOW_TRANSITION == edgeSelect) ? (p->reg[SIM_PIES] | selectedPins) : (p->reg[SIM_PIES] & ~selectedPins);
+    sim_unlock();
+}
+
+/******************************************************************************/
+// Timer_A
+
+/*!
+* @brief Sets the clock source, dividers and mode bits the way the DriverLib
+* init functions do, leaving the mode for the caller.
+*/
+static void
+timer_configure (sim_timer_t *t, uint16_t clockSource, uint16_t clockSourceDivider, uint16_t flags)
+{
+    t->reg[SIM_TACTL] &= ~(TASSEL_3 | MC_3 | TACLR | TAIE | ID_3);
+    t->reg[SIM_TAEX0]  = clockSourceDivider & TAIDEX_7;
+    t->reg[SIM_TACTL] |= clockSource | flags | ((clockSourceDivider >> 3) << 6);
+    if (t->reg[SIM_TACTL] & TACLR)
+    {
+        t->reg[SIM_TACTL] &= ~TACLR;
+        t->reg[SIM_TAR]    = 0;
+    }
+}   /* timer_configure() */
+
+void
+Timer_A_startCounter (uint16_t baseAddress, uint16_t timerMode)
+{
+    uint8_t index = periph_timer_index(baseAddress);
+
+    sim_lock();
+    periph_timers[index].reg[SIM_TACTL] = (periph_timers[index].reg[SIM_TACTL] & ~MC_3) | timerMode;
+    periph_timer_restart(index);
+    sim_unlock();
+}
+
+void
+Timer_A_initContinuousMode (uint16_t baseAddress, Timer_A_initContinuousModeParam *param)
+{
+    uint8_t      index = periph_timer_index(baseAddress);
+    sim_timer_t *t     = &periph_timers[index];
+
+    sim_lock();
+    timer_configure(t, param->clockSource, param->clockSourceDivider,
+                    param->timerClear | param->timerInterruptEnable_TAIE);
+    if (param->startTimer)
+    {
+        t->reg[SIM_TACTL] |= TIMER_A_CONTINUOUS_MODE;
+    }
+    periph_timer_restart(index);
+    sim_unlock();
+}
+
+void
+Timer_A_initUpMode (uint16_t baseAddress, Timer_A_initUpModeParam *param)
+{
+    uint8_t      index = periph_timer_index(baseAddress);
+    sim_timer_t *t     = &periph_timers[index];
+
+    sim_lock();
+    timer_configure(t, param->clockSource, param->clockSourceDivider,
+                    param->timerClear | param->timerInterruptEnable_TAIE);
+    if (param->startTimer)
+    {
+        t->reg[SIM_TACTL] |= TIMER_A_UP_MODE;
+    }
+    if (TIMER_A_CCIE_CCR0_INTERRUPT_ENABLE == param->captureCompareInterruptEnable_CCR0_CCIE)
+    {
+        t->reg[SIM_TACCTL0] |= CCIE;
+    }
+    else
+    {
+        t->reg[SIM_TACCTL0] &= ~CCIE;
+    }
+    t->reg[SIM_TACCR0] = param->timerPeriod;
+    periph_timer_restart(index);
+    sim_unlock();
+}
+
+void
+Timer_A_initCompareMode (uint16_t baseAddress, Timer_A_initCompareModeParam *param)
+{
+    sim_timer_t *t = &periph_timers[periph_timer_index(baseAddress)];
+    uint8_t      n = (param->compareRegister >> 1) - 1;
+
+    sim_lock();
+    t->reg[SIM_TACCTL0 + n] = (t->reg[SIM_TACCTL0 + n] & ~(CAP | CCIE | OUTMOD_7))
+                            | param->compareInterruptEnable | param->compareOutputMode;
+    t->reg[SIM_TACCR0 + n]  = param->compareValue;
+    sim_unlock();
+}
+
+void
+Timer_A_enableInterrupt (uint16_t baseAddress)
+{
+    sim_lock();
+    periph_timers[periph_timer_index(baseAddress)].reg[SIM_TACTL] |= TAIE;
+    sim_unlock();
+}
+
+void
+Timer_A_disableInterrupt (uint16_t baseAddress)
+{
+    sim_lock();
+    periph_timers[periph_timer_index(baseAddress)].reg[SIM_TACTL] &= ~TAIE;
+    sim_unlock();
+}
+
+uint32_t
+Timer_A_getInterruptStatus (uint16_t baseAddress)
+{
+    uint32_t status;
+
+    sim_lock();
+    status = periph_timers[periph_timer_index(baseAddress)].reg[SIM_TACTL] & TAIFG;
+    sim_unlock();
+    return status;
+}
+
+void
+Timer_A_enableCaptureCompareInterrupt (uint16_t baseAddress, uint16_t captureCompareRegister)
+{
+    sim_lock();
+    periph_timers[periph_timer_index(baseAddress)].reg[SIM_TACCTL0 + (captureCompareRegister >> 1) - 1] |= CCIE;
+    sim_unlock();
+}
+
+void
+Timer_A_disableCaptureCompareInterrupt (uint16_t baseAddress, uint16_t captureCompareRegister)
+{
+    sim_lock();
+    periph_timers[periph_timer_index(baseAddress)].reg[SIM_TACCTL0 + (captureCompareRegister >> 1) - 1] &= ~CCIE;
+    sim_unlock();
+}
+
+uint32_t
+Timer_A_getCaptureCompareInterruptStatus (uint16_t baseAddress, uint16_t captureCompareRegister, uint16_t mask)
+{
+    uint32_t status;
+
+    sim_lock();
+    status = periph_timers[periph_timer_index(baseAddress)].reg[SIM_TACCTL0 + (captureCompareRegister >> 1) - 1] & mask;
+    sim_unlock();
+    return status;
+}
+
+void
+Timer_A_clear (uint16_t baseAddress)
+{
+    uint8_t index = periph_timer_index(baseAddress);
+
+    sim_lock();
+    periph_timers[index].reg[SIM_TAR] = 0;
+    periph_timer_restart(index);
+    sim_unlock();
+}
+
+uint16_t
+Timer_A_getCaptureCompareCount (uint16_t baseAddress, uint16_t captureCompareRegister)
+{
+    uint16_t count;
+
+    sim_lock();
+    count = periph_timers[periph_timer_index(baseAddress)].reg[SIM_TACCR0 + (captureCompareRegister >> 1) - 1];
+    sim_unlock();
+    return count;
+}
+
+void
+Timer_A_outputPWM (uint16_t baseAddress, Timer_A_outputPWMParam *param)
+{
+    uint8_t      index = periph_timer_index(baseAddress);
+    sim_timer_t *t     = &periph_timers[index];
+    uint8_t      n     = (param->compareRegister >> 1) - 1;
+
+    sim_lock();
+    timer_configure(t, param->clockSource, param->clockSourceDivider, TIMER_A_UP_MODE | TIMER_A_DO_CLEAR);
+    t->reg[SIM_TACCR0]       = param->timerPeriod;
+    t->reg[SIM_TACCTL0]     &= ~(CCIE | OUTMOD_7);
+    t->reg[SIM_TACCTL0 + n] |= param->compareOutputMode;
+    t->reg[SIM_TACCR0 + n]   = param->dutyCycle;
+    periph_timer_restart(index);
+    sim_unlock();
+}
+
+void
+Timer_A_stop (uint16_t baseAddress)
+{
+    sim_lock();
+    periph_timers[periph_timer_index(baseAddress)].reg[SIM_TACTL] &= ~MC_3;
+    sim_unlock();
+}
+
+void
+Timer_A_setCompareValue (uint16_t baseAddress, uint16_t compareRegister, uint16_t compareValue)
+{
+    sim_lock();
+    periph_timers[periph_timer_index(baseAddress)].reg[SIM_TACCR0 + (compareRegister >> 1) - 1] = compareValue;
+    sim_unlock();
+}
+
+void
+Timer_A_setOutputMode (uint16_t baseAddress, uint16_t compareRegister, uint16_t compareOutputMode)
+{
+    sim_timer_t *t = &periph_timers[periph_timer_index(baseAddress)];
+    uint8_t      n = (compareRegister >> 1) - 1;
+
+    sim_lock();
+    t->reg[SIM_TACCTL0 + n] = (t->reg[SIM_TACCTL0 + n] & ~OUTMOD_7) | compareOutputMode;
+    sim_unlock();
+}
+
+void
+Timer_A_clearTimerInterrupt (uint16_t baseAddress)
+{
+    sim_lock();
+    periph_timers[periph_timer_index(baseAddress)].reg[SIM_TACTL] &= ~TAIFG;
+    sim_unlock();
+}
+
+void
+Timer_A_clearCaptureCompareInterrupt (uint16_t baseAddress, uint16_t captureCompareRegister)
+{
+    sim_lock();
+    periph_timers[periph_timer_index(baseAddress)].reg[SIM_TACCTL0 + (captureCompareRegister >> 1) - 1] &= ~CCIFG;
+    sim_unlock();
+}
+
+uint16_t
+Timer_A_getCounterValue (uint16_t baseAddress)
+{
+    uint16_t count;
+
+    sim_lock();
+    count = periph_timers[periph_timer_index(baseAddress)].reg[SIM_TAR];
+    sim_unlock();
+    return count;
+}
+
+/******************************************************************************/
+// eUSCI_A UART
+
+bool
+EUSCI_A_UART_init (uint16_t baseAddress, EUSCI_A_UART_initParam *param)
+{
+    sim_uart_t *u = &periph_uarts[periph_uart_index(baseAddress)];
+
+    sim_lock();
+    // Software reset clears the enables and every flag but UCTXIFG
+    u->ctlw0    = UCSWRST | param->selectClockSource | param->parity | param->msborLsbFirst
+                | param->numberofStopBits | param->uartMode;
+    u->brw      = param->clockPrescalar;
+    u->mctlw    = (param->secondModReg << 8) | (param->firstModReg << 4) | param->overSampling;
+    u->ie       = 0;
+    u->ifg      = UCTXIFG;
+    sim_unlock();
+    return STATUS_SUCCESS;
+}
+
+void
+EUSCI_A_UART_transmitData (uint16_t baseAddress, uint8_t transmitData)
+{
+    uint8_t     index = periph_uart_index(baseAddress);
+    sim_uart_t *u     = &periph_uarts[index];
+
+    sim_lock();
+    // Without the interrupt, wait for TXBUF to be free like DriverLib does
+    while (!(u->ie & UCTXIE) && !(u->ifg & UCTXIFG))
+    {
+        sim_unlock();
+        sim_wait();
+        sim_lock();
+    }
+    periph_uart_write(index, transmitData);
+    sim_unlock();
+}
+
+uint8_t
+EUSCI_A_UART_receiveData (uint16_t baseAddress)
+{
+    sim_uart_t *u = &periph_uarts[periph_uart_index(baseAddress)];
+    uint8_t     data;
+
+    sim_lock();
+    u->ifg &= ~UCRXIFG;
+    data = (uint8_t)u->rxbuf;
+    sim_unlock();
+    return data;
+}
+
+void
+EUSCI_A_UART_enableInterrupt (uint16_t baseAddress, uint8_t mask)
+{
+    sim_lock();
+    periph_uarts[periph_uart_index(baseAddress)].ie |= mask;
+    sim_unlock();
+}
+
+void
+EUSCI_A_UART_disableInterrupt (uint16_t baseAddress, uint8_t mask)
+{
+    sim_lock();
+    periph_uarts[periph_uart_index(baseAddress)].ie &= ~mask;
+    sim_unlock();
+}
+
+uint8_t
+EUSCI_A_UART_getInterruptStatus (uint16_t baseAddress, uint8_t mask)
+{
+    uint8_t status;
+
+    sim_lock();
+    status = periph_uarts[periph_uart_index(baseAddress)].ifg & mask;
+    sim_unlock();
+    return status;
+}
+
+void
+EUSCI_A_UART_clearInterrupt (uint16_t baseAddress, uint16_t mask)
+{
+    sim_lock();
+    periph_uarts[periph_uart_index(baseAddress)].ifg &= ~mask;
+    sim_unlock();
+}
+
+void
+EUSCI_A_UART_enable (uint16_t baseAddress)
+{
+    sim_lock();
+    periph_uarts[periph_uart_index(baseAddress)].ctlw0 &= ~UCSWRST;
+    sim_unlock();
+}
+
+void
+EUSCI_A_UART_disable (uint16_t baseAddress)
+{
+    sim_uart_t *u = &periph_uarts[periph_uart_index(baseAddress)];
+
+    sim_lock();
+    u->ctlw0   |= UCSWRST;
+    u->ie       = 0;
+    u->ifg      = UCTXIFG;
+    sim_unlock();
+}
+
+/******************************************************************************/
+// CS
+
+void
+CS_initClockSignal (uint8_t selectedClockSignal, uint16_t clockSource, uint16_t clockSourceDivider)
+{
+    sim_lock();
+    switch (selectedClockSignal)
+    {
+    case CS_MCLK:
+        periph_clocks.mclk_div = (uint8_t)clockSourceDivider;
+        break;
+
+    case CS_SMCLK:
+        // SMCLK is always divided down from MCLK
+        periph_clocks.smclk_div = (uint8_t)clockSourceDivider;
+        break;
+
+    default:
+        // ACLK and the FLL reference only run from REFO here
+        break;
+    }
+    periph_clocks_update();
+    sim_unlock();
+}
+
+bool
+CS_initFLLSettle (uint16_t fsystem, uint16_t ratio)
+{
+    uint8_t i;
+
+    sim_lock();
+    periph_clocks.dcoclkdiv = (uint32_t)fsystem * 1000;
+    periph_clocks_update();
+    for (i = 0; i < PERIPH_TIMERS; i++)
+    {
+        periph_timer_restart(i);
+    }
+    sim_unlock();
+    return true;
+}
+
+/******************************************************************************/
+// CRC
+
+/*!
+* @brief Feeds one byte MSB first into the CRC-16/CCITT register.
+*/
+static void
+crc_update (uint8_t data)
+{
+    uint8_t bit;
+
+    periph_crc ^= (uint16_t)data << 8;
+    for (bit = 0; bit < 8; bit++)
+    {
+        periph_crc = (periph_crc & 0x8000) ? (uint16_t)((periph_crc << 1) ^ 0x1021) : (uint16_t)(periph_crc << 1);
+    }
+}   /* crc_update() */
+
+/*!
+* @brief Reverses the bit order of a byte.
+*/
+static uint8_t
+crc_reverse (uint8_t data)
+{
+    uint8_t reversed = 0;
+    uint8_t bit;
+
+    for (bit = 0; bit < 8; bit++)
+    {
+        reversed = (reversed << 1) | ((data >> bit) & 1);
+    }
+    return reversed;
+}   /* crc_reverse() */
+
+void
+CRC_setSeed (uint16_t baseAddress, uint16_t seed)
+{
+    periph_crc = seed;
+}
+
+// CRCDI takes the LSB first
+void
+CRC_set8BitData (uint16_t baseAddress, uint8_t dataIn)
+{
+    crc_update(crc_reverse(dataIn));
+}
+
+// CRCDIRB takes the MSB first
+void
+CRC_set8BitDataReversed (uint16_t baseAddress, uint8_t dataIn)
+{
+    crc_update(dataIn);
+}
+
+uint16_t
+CRC_getResult (uint16_t baseAddress)
+{
+    return periph_crc;
+}
+
+/******************************************************************************/
+// FRAMCtl, FRAM is ordinary memory here, left out of the RAM sim.c restores
+// on a reset
+
+void
+FRAMCtl_write8 (uint8_t *dataPtr, uint8_t *framPtr, uint16_t numberOfBytes)
+{
+    while (numberOfBytes--)
+    {
+        *framPtr++ = *dataPtr++;
+    }
+}
+
+void
+FRAMCtl_write16 (uint16_t *dataPtr, uint16_t *framPtr, uint16_t numberOfWords)
+{
+    while (numberOfWords--)
+    {
+        *framPtr++ = *dataPtr++;
+    }
+}
+
+void
+FRAMCtl_write32 (uint32_t *dataPtr, uint32_t *framPtr, uint16_t count)
+{
+    while (count--)
+    {
+        *framPtr++ = *dataPtr++;
+    }
+}
+
+/******************************************************************************/
+// PMM, SYS and WDT_A
+
+void
+PMM_unlockLPM5 (void)
+{
+}
+
+/*!
+* @brief Reads SYSRSTIV, clearing the reset cause it reports.
+* @return The highest priority cause, SYSRSTIV_NONE once all are read.
+*/
+uint16_t
+sim_sysrstiv (void)
+{
+    uint16_t iv;
+
+    sim_lock();
+    iv = periph_reset_cause();
+    sim_unlock();
+    return iv;
+}   /* sim_sysrstiv() */
+
+void
+WDT_A_hold (uint16_t baseAddress)
+{
+    sim_lock();
+    periph_wdt.ctl |= WDTHOLD;
+    sim_unlock();
+}
+
+void
+WDT_A_start (uint16_t baseAddress)
+{
+    sim_lock();
+    periph_wdt.ctl &= ~WDTHOLD;
+    periph_wdt_clear();
+    sim_unlock();
+}
+
+void
+WDT_A_resetTimer (uint16_t baseAddress)
+{
+    sim_lock();
+    periph_wdt_clear();
+    sim_unlock();
+}
+
+// Leaves the watchdog held, like DriverLib
+void
+WDT_A_initWatchdogTimer (uint16_t baseAddress, uint8_t clockSelect, uint8_t clockDivider)
+{
+    sim_lock();
+    periph_wdt.ctl = WDTHOLD | clockSelect | clockDivider;
+    periph_wdt_clear();
+    sim_unlock();
+}
+
+/*** end of file ***/
@@ -0,0 +1,446 @@
+/******************************************************************************/
+
+/** @file driverlib.h
+*
+* @brief Host stand-in for MSP430 DriverLib backed by the simulated register
+* file in sim.h.
+*
+* @par
+* Only the parts of DriverLib, the device header and the compiler intrinsics
+* that the firmware uses are provided. Constant values follow DriverLib where
+* the firmware might depend on them.
+*/
+
+#ifndef SIM_DRIVERLIB_H
+#define SIM_DRIVERLIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sim.h"
+
+#define STATUS_SUCCESS                   0x01
+#define STATUS_FAIL                      0x00
+
+// Compiler keywords and intrinsics
+#define __interrupt
+#define __no_operation()                 ((void)0)
+#define __delay_cycles(cycles)           sim_delay_cycles(cycles)
+#define __even_in_range(value, range)    (value)
+#define __disable_interrupt()            sim_disable_interrupt()
+#define __enable_interrupt()             sim_enable_interrupt()
+#define __get_interrupt_state()          sim_get_interrupt_state()
+#define __set_interrupt_state(state)     sim_set_interrupt_state(state)
+#define __bis_SR_register(bits)          sim_bis_sr(bits)
+#define __bic_SR_register(bits)          sim_bic_sr(bits)
+#define __bic_SR_register_on_exit(bits)  sim_bic_sr_on_exit(bits)
+#define __bis_SR_register_on_exit(bits)  ((void)(bits))
+
+// Status register bits
+#define GIE                              (0x0008)
+#define CPUOFF                           (0x0010)
+#define OSCOFF                           (0x0020)
+#define SCG0                             (0x0040)
+#define SCG1                             (0x0080)
+#define LPM0_bits                        (CPUOFF)
+#define LPM1_bits                        (SCG0 | CPUOFF)
+#define LPM3_bits                        (SCG1 | SCG0 | CPUOFF)
+#define LPM4_bits                        (SCG1 | SCG0 | OSCOFF | CPUOFF)
+
+#define BIT0                             (0x0001)
+#define BIT1                             (0x0002)
+#define BIT2                             (0x0004)
+#define BIT3                             (0x0008)
+#define BIT4                             (0x0010)
+#define BIT5                             (0x0020)
+#define BIT6                             (0x0040)
+#define BIT7                             (0x0080)
+
+// Port registers
+#define P1IN                             (*sim_port_reg(1, SIM_PIN))
+#define P1OUT                            (*sim_port_reg(1, SIM_POUT))
+#define P1DIR                            (*sim_port_reg(1, SIM_PDIR))
+#define P1REN                            (*sim_port_reg(1, SIM_PREN))
+#define P1IES                            (*sim_port_reg(1, SIM_PIES))
+#define P1IE                             (*sim_port_reg(1, SIM_PIE))
+#define P1IFG                            (*sim_port_reg(1, SIM_PIFG))
+#define P2IN                             (*sim_port_reg(2, SIM_PIN))
+#define P2OUT                            (*sim_port_reg(2, SIM_POUT))
+#define P2DIR                            (*sim_port_reg(2, SIM_PDIR))
+#define P2REN                            (*sim_port_reg(2, SIM_PREN))
+#define P2IES                            (*sim_port_reg(2, SIM_PIES))
+#define P2IE                             (*sim_port_reg(2, SIM_PIE))
+#define P2IFG                            (*sim_port_reg(2, SIM_PIFG))
+#define P3IN                             (*sim_port_reg(3, SIM_PIN))
+#define P3OUT                            (*sim_port_reg(3, SIM_POUT))
+#define P3DIR                            (*sim_port_reg(3, SIM_PDIR))
+#define P3REN                            (*sim_port_reg(3, SIM_PREN))
+#define P1SEL0                           (*sim_port_reg(1, SIM_PSEL0))
+#define P1SEL1                           (*sim_port_reg(1, SIM_PSEL1))
+#define P2SEL0                           (*sim_port_reg(2, SIM_PSEL0))
+#define P2SEL1                           (*sim_port_reg(2, SIM_PSEL1))
+#define P3SEL0                           (*sim_port_reg(3, SIM_PSEL0))
+#define P3SEL1                           (*sim_port_reg(3, SIM_PSEL1))
+#define P1IV                             sim_port_iv(1)
+#define P2IV                             sim_port_iv(2)
+
+// Timer registers
+#define TA0CTL                           (*sim_timer_reg(TIMER_A0_BASE, SIM_TACTL))
+#define TA0R                             (*sim_timer_reg(TIMER_A0_BASE, SIM_TAR))
+#define TA0CCTL0                         (*sim_timer_reg(TIMER_A0_BASE, SIM_TACCTL0))
+#define TA0CCTL1                         (*sim_timer_reg(TIMER_A0_BASE, SIM_TACCTL1))
+#define TA0CCTL2                         (*sim_timer_reg(TIMER_A0_BASE, SIM_TACCTL2))
+#define TA0CCR0                          (*sim_timer_reg(TIMER_A0_BASE, SIM_TACCR0))
+#define TA0CCR1                          (*sim_timer_reg(TIMER_A0_BASE, SIM_TACCR1))
+#define TA0CCR2                          (*sim_timer_reg(TIMER_A0_BASE, SIM_TACCR2))
+#define TA1CTL                           (*sim_timer_reg(TIMER_A1_BASE, SIM_TACTL))
+#define TA1R                             (*sim_timer_reg(TIMER_A1_BASE, SIM_TAR))
+#define TA1CCTL0                         (*sim_timer_reg(TIMER_A1_BASE, SIM_TACCTL0))
+#define TA1CCTL1                         (*sim_timer_reg(TIMER_A1_BASE, SIM_TACCTL1))
+#define TA1CCTL2                         (*sim_timer_reg(TIMER_A1_BASE, SIM_TACCTL2))
+#define TA1CCR0                          (*sim_timer_reg(TIMER_A1_BASE, SIM_TACCR0))
+#define TA1CCR1                          (*sim_timer_reg(TIMER_A1_BASE, SIM_TACCR1))
+#define TA1CCR2                          (*sim_timer_reg(TIMER_A1_BASE, SIM_TACCR2))
+#define TA2CTL                           (*sim_timer_reg(TIMER_A2_BASE, SIM_TACTL))
+#define TA2R                             (*sim_timer_reg(TIMER_A2_BASE, SIM_TAR))
+#define TA2CCTL0                         (*sim_timer_reg(TIMER_A2_BASE, SIM_TACCTL0))
+#define TA2CCTL1                         (*sim_timer_reg(TIMER_A2_BASE, SIM_TACCTL1))
+#define TA2CCR0                          (*sim_timer_reg(TIMER_A2_BASE, SIM_TACCR0))
+#define TA2CCR1                          (*sim_timer_reg(TIMER_A2_BASE, SIM_TACCR1))
+#define TA3CTL                           (*sim_timer_reg(TIMER_A3_BASE, SIM_TACTL))
+#define TA3R                             (*sim_timer_reg(TIMER_A3_BASE, SIM_TAR))
+#define TA3CCTL0                         (*sim_timer_reg(TIMER_A3_BASE, SIM_TACCTL0))
+#define TA3CCTL1                         (*sim_timer_reg(TIMER_A3_BASE, SIM_TACCTL1))
+#define TA3CCR0                          (*sim_timer_reg(TIMER_A3_BASE, SIM_TACCR0))
+#define TA3CCR1                          (*sim_timer_reg(TIMER_A3_BASE, SIM_TACCR1))
+
+// Timer_A register bits
+#define TAIFG                            (0x0001)
+#define TAIE                             (0x0002)
+#define TACLR                            (0x0004)
+#define MC_3                             (0x0030)
+#define MC__STOP                         (0x0000)
+#define MC__UP                           (0x0010)
+#define MC__CONTINUOUS                   (0x0020)
+#define MC__UPDOWN                       (0x0030)
+#define ID_3                             (0x00C0)
+#define TASSEL_3                         (0x0300)
+#define TASSEL__ACLK                     (0x0100)
+#define TASSEL__SMCLK                    (0x0200)
+#define TAIDEX_7                         (0x0007)
+#define CCIFG                            (0x0001)
+#define COV                              (0x0002)
+#define OUT                              (0x0004)
+#define CCIE                             (0x0010)
+#define OUTMOD_7                         (0x00E0)
+#define CAP                              (0x0100)
+
+// eUSCI_A register bits
+#define UCSWRST                          (0x0001)
+#define UCSPB                            (0x0800)
+#define UCPEN                            (0x8000)
+#define UCSSEL_3                         (0x00C0)
+#define UCOS16                           (0x0001)
+#define UCRXIE                           (0x0001)
+#define UCTXIE                           (0x0002)
+#define UCRXIFG                          (0x0001)
+#define UCTXIFG                          (0x0002)
+#define UCSTTIFG                         (0x0004)
+#define UCTXCPTIFG                       (0x0008)
+
+/******************************************************************************/
+// GPIO
+
+#define GPIO_PORT_P1                     1
+#define GPIO_PORT_P2                     2
+#define GPIO_PORT_P3                     3
+
+#define GPIO_PIN0                        (0x0001)
+#define GPIO_PIN1                        (0x0002)
+#define GPIO_PIN2                        (0x0004)
+#define GPIO_PIN3                        (0x0008)
+#define GPIO_PIN4                        (0x0010)
+#define GPIO_PIN5                        (0x0020)
+#define GPIO_PIN6                        (0x0040)
+#define GPIO_PIN7                        (0x0080)
+#define GPIO_PIN_ALL8                    (0x00FF)
+
+#define GPIO_PRIMARY_MODULE_FUNCTION     (0x01)
+#define GPIO_SECONDARY_MODULE_FUNCTION   (0x02)
+#define GPIO_TERNARY_MODULE_FUNCTION     (0x03)
+
+#define GPIO_HIGH_TO_LOW_TRANSITION      (0x01)
+#define GPIO_LOW_TO_HIGH_TRANSITION      (0x00)
+
+#define GPIO_INPUT_PIN_HIGH              (0x01)
+#define GPIO_INPUT_PIN_LOW               (0x00)
+
+void GPIO_setAsOutputPin(uint8_t selectedPort, uint16_t selectedPins);
+void GPIO_setAsInputPin(uint8_t selectedPort, uint16_t selectedPins);
+void GPIO_setAsPeripheralModuleFunctionOutputPin(uint8_t selectedPort, uint16_t selectedPins, uint8_t mode);
+void GPIO_setAsPeripheralModuleFunctionInputPin(uint8_t selectedPort, uint16_t selectedPins, uint8_t mode);
+void GPIO_setOutputHighOnPin(uint8_t selectedPort, uint16_t selectedPins);
+void GPIO_setOutputLowOnPin(uint8_t selectedPort, uint16_t selectedPins);
+void GPIO_toggleOutputOnPin(uint8_t selectedPort, uint16_t selectedPins);
+void GPIO_setAsInputPinWithPullDownResistor(uint8_t selectedPort, uint16_t selectedPins);
+void GPIO_setAsInputPinWithPullUpResistor(uint8_t selectedPort, uint16_t selectedPins);
+uint8_t GPIO_getInputPinValue(uint8_t selectedPort, uint16_t selectedPins);
+void GPIO_enableInterrupt(uint8_t selectedPort, uint16_t selectedPins);
+void GPIO_disableInterrupt(uint8_t selectedPort, uint16_t selectedPins);
+uint16_t GPIO_getInterruptStatus(uint8_t selectedPort, uint16_t selectedPins);
+void GPIO_clearInterrupt(uint8_t selectedPort, uint16_t selectedPins);
+void GPIO_selectInterruptEdge(uint8_t selectedPort, uint16_t selectedPins, uint8_t edgeSelect);
+
+/******************************************************************************/
+// Timer_A
+
+#define TIMER_A0_BASE                    (0x0380)
+#define TIMER_A1_BASE                    (0x03C0)
+#define TIMER_A2_BASE                    (0x0400)
+#define TIMER_A3_BASE                    (0x0440)
+
+#define TIMER_A_CLOCKSOURCE_DIVIDER_1    0x00
+#define TIMER_A_CLOCKSOURCE_DIVIDER_2    0x08
+#define TIMER_A_CLOCKSOURCE_DIVIDER_4    0x10
+#define TIMER_A_CLOCKSOURCE_DIVIDER_8    0x18
+#define TIMER_A_CLOCKSOURCE_DIVIDER_16   0x0F
+#define TIMER_A_CLOCKSOURCE_DIVIDER_32   0x17
+#define TIMER_A_CLOCKSOURCE_DIVIDER_64   0x1F
+
+#define TIMER_A_STOP_MODE                (0x0000)
+#define TIMER_A_UP_MODE                  (0x0010)
+#define TIMER_A_CONTINUOUS_MODE          (0x0020)
+#define TIMER_A_UPDOWN_MODE              (0x0030)
+
+#define TIMER_A_DO_CLEAR                 (0x0004)
+#define TIMER_A_SKIP_CLEAR               (0x0000)
+
+#define TIMER_A_CLOCKSOURCE_EXTERNAL_TXCLK (0x0000)
+#define TIMER_A_CLOCKSOURCE_ACLK         (0x0100)
+#define TIMER_A_CLOCKSOURCE_SMCLK        (0x0200)
+
+#define TIMER_A_TAIE_INTERRUPT_ENABLE    (0x0002)
+#define TIMER_A_TAIE_INTERRUPT_DISABLE   (0x0000)
+#define TIMER_A_CCIE_CCR0_INTERRUPT_ENABLE  (0x0010)
+#define TIMER_A_CCIE_CCR0_INTERRUPT_DISABLE (0x0000)
+#define TIMER_A_CAPTURECOMPARE_INTERRUPT_ENABLE  (0x0010)
+#define TIMER_A_CAPTURECOMPARE_INTERRUPT_DISABLE (0x0000)
+
+#define TIMER_A_OUTPUTMODE_OUTBITVALUE   (0x0000)
+#define TIMER_A_OUTPUTMODE_SET           (0x0020)
+#define TIMER_A_OUTPUTMODE_TOGGLE_RESET  (0x0040)
+#define TIMER_A_OUTPUTMODE_SET_RESET     (0x0060)
+#define TIMER_A_OUTPUTMODE_TOGGLE        (0x0080)
+#define TIMER_A_OUTPUTMODE_RESET         (0x00A0)
+#define TIMER_A_OUTPUTMODE_TOGGLE_SET    (0x00C0)
+#define TIMER_A_OUTPUTMODE_RESET_SET     (0x00E0)
+
+#define TIMER_A_CAPTURECOMPARE_REGISTER_0 (0x0002)
+#define TIMER_A_CAPTURECOMPARE_REGISTER_1 (0x0004)
+#define TIMER_A_CAPTURECOMPARE_REGISTER_2 (0x0006)
+
+#define TIMER_A_INTERRUPT_NOT_PENDING    (0x00)
+#define TIMER_A_INTERRUPT_PENDING        (0x01)
+#define TIMER_A_CAPTURECOMPARE_INTERRUPT_FLAG (0x0001)
+
+typedef struct Timer_A_initContinuousModeParam {
+    uint16_t clockSource;
+    uint16_t clockSourceDivider;
+    uint16_t timerInterruptEnable_TAIE;
+    uint16_t timerClear;
+    bool startTimer;
+} Timer_A_initContinuousModeParam;
+
+typedef struct Timer_A_outputPWMParam {
+    uint16_t clockSource;
+    uint16_t clockSourceDivider;
+    uint16_t timerPeriod;
+    uint16_t compareRegister;
+    uint16_t compareOutputMode;
+    uint16_t dutyCycle;
+} Timer_A_outputPWMParam;
+
+typedef struct Timer_A_initUpModeParam {
+    uint16_t clockSource;
+    uint16_t clockSourceDivider;
+    uint16_t timerPeriod;
+    uint16_t timerInterruptEnable_TAIE;
+    uint16_t captureCompareInterruptEnable_CCR0_CCIE;
+    uint16_t timerClear;
+    bool startTimer;
+} Timer_A_initUpModeParam;
+
+typedef struct Timer_A_initCompareModeParam {
+    uint16_t compareRegister;
+    uint16_t compareInterruptEnable;
+    uint16_t compareOutputMode;
+    uint16_t compareValue;
+} Timer_A_initCompareModeParam;
+
+void Timer_A_startCounter(uint16_t baseAddress, uint16_t timerMode);
+void Timer_A_initContinuousMode(uint16_t baseAddress, Timer_A_initContinuousModeParam *param);
+void Timer_A_initUpMode(uint16_t baseAddress, Timer_A_initUpModeParam *param);
+void Timer_A_initCompareMode(uint16_t baseAddress, Timer_A_initCompareModeParam *param);
+void Timer_A_enableInterrupt(uint16_t baseAddress);
+void Timer_A_disableInterrupt(uint16_t baseAddress);
+uint32_t Timer_A_getInterruptStatus(uint16_t baseAddress);
+void Timer_A_enableCaptureCompareInterrupt(uint16_t baseAddress, uint16_t captureCompareRegister);
+void Timer_A_disableCaptureCompareInterrupt(uint16_t baseAddress, uint16_t captureCompareRegister);
+uint32_t Timer_A_getCaptureCompareInterruptStatus(uint16_t baseAddress, uint16_t captureCompareRegister, uint16_t mask);
+void Timer_A_clear(uint16_t baseAddress);
+uint16_t Timer_A_getCaptureCompareCount(uint16_t baseAddress, uint16_t captureCompareRegister);
+void Timer_A_outputPWM(uint16_t baseAddress, Timer_A_outputPWMParam *param);
+void Timer_A_stop(uint16_t baseAddress);
+void Timer_A_setCompareValue(uint16_t baseAddress, uint16_t compareRegister, uint16_t compareValue);
+void Timer_A_setOutputMode(uint16_t baseAddress, uint16_t compareRegister, uint16_t compareOutputMode);
+void Timer_A_clearTimerInterrupt(uint16_t baseAddress);
+void Timer_A_clearCaptureCompareInterrupt(uint16_t baseAddress, uint16_t captureCompareRegister);
+uint16_t Timer_A_getCounterValue(uint16_t baseAddress);
+
+/******************************************************************************/
+// eUSCI_A UART
+
+#define EUSCI_A0_BASE                    (0x0500)
+#define EUSCI_A1_BASE                    (0x0520)
+
+#define EUSCI_A_UART_NO_PARITY           0x00
+#define EUSCI_A_UART_ODD_PARITY          0x01
+#define EUSCI_A_UART_EVEN_PARITY         0x02
+#define EUSCI_A_UART_MSB_FIRST           0x2000
+#define EUSCI_A_UART_LSB_FIRST           0x00
+#define EUSCI_A_UART_MODE                0x0000
+#define EUSCI_A_UART_CLOCKSOURCE_SMCLK   0x0080
+#define EUSCI_A_UART_CLOCKSOURCE_ACLK    0x0040
+#define EUSCI_A_UART_ONE_STOP_BIT        0x00
+#define EUSCI_A_UART_TWO_STOP_BITS       0x0800
+#define EUSCI_A_UART_OVERSAMPLING_BAUDRATE_GENERATION 0x01
+#define EUSCI_A_UART_LOW_FREQUENCY_BAUDRATE_GENERATION 0x00
+
+#define EUSCI_A_UART_RECEIVE_INTERRUPT   (0x0001)
+#define EUSCI_A_UART_TRANSMIT_INTERRUPT  (0x0002)
+#define EUSCI_A_UART_RECEIVE_INTERRUPT_FLAG  (0x0001)
+#define EUSCI_A_UART_TRANSMIT_INTERRUPT_FLAG (0x0002)
+
+#define USCI_NONE                        (0x0000)
+#define USCI_UART_UCRXIFG                (0x0002)
+#define USCI_UART_UCTXIFG                (0x0004)
+#define USCI_UART_UCSTTIFG               (0x0006)
+#define USCI_UART_UCTXCPTIFG             (0x0008)
+
+#define UCA0IV                           sim_uart_iv(EUSCI_A0_BASE)
+#define UCA1IV                           sim_uart_iv(EUSCI_A1_BASE)
+
+typedef struct EUSCI_A_UART_initParam {
+    uint8_t selectClockSource;
+    uint16_t clockPrescalar;
+    uint8_t firstModReg;
+    uint8_t secondModReg;
+    uint8_t parity;
+    uint16_t msborLsbFirst;
+    uint16_t numberofStopBits;
+    uint16_t uartMode;
+    uint8_t overSampling;
+} EUSCI_A_UART_initParam;
+
+bool EUSCI_A_UART_init(uint16_t baseAddress, EUSCI_A_UART_initParam *param);
+void EUSCI_A_UART_transmitData(uint16_t baseAddress, uint8_t transmitData);
+uint8_t EUSCI_A_UART_receiveData(uint16_t baseAddress);
+void EUSCI_A_UART_enableInterrupt(uint16_t baseAddress, uint8_t mask);
+void EUSCI_A_UART_disableInterrupt(uint16_t baseAddress, uint8_t mask);
+uint8_t EUSCI_A_UART_getInterruptStatus(uint16_t baseAddress, uint8_t mask);
+void EUSCI_A_UART_clearInterrupt(uint16_t baseAddress, uint16_t mask);
+void EUSCI_A_UART_enable(uint16_t baseAddress);
+void EUSCI_A_UART_disable(uint16_t baseAddress);
+
+/******************************************************************************/
+// CS
+
+#define CS_ACLK                          0x01
+#define CS_MCLK                          0x02
+#define CS_SMCLK                         0x04
+#define CS_FLLREF                        0x08
+
+#define CS_REFOCLK_SELECT                0x0001
+#define CS_DCOCLKDIV_SELECT              0x0000
+
+#define CS_CLOCK_DIVIDER_1               0x0000
+#define CS_CLOCK_DIVIDER_2               0x0001
+#define CS_CLOCK_DIVIDER_4               0x0002
+#define CS_CLOCK_DIVIDER_8               0x0003
+
+void CS_initClockSignal(uint8_t selectedClockSignal, uint16_t clockSource, uint16_t clockSourceDivider);
+bool CS_initFLLSettle(uint16_t fsystem, uint16_t ratio);
+
+/******************************************************************************/
+// CRC
+
+#define CRC_BASE                         (0x01C0)
+
+void CRC_setSeed(uint16_t baseAddress, uint16_t seed);
+void CRC_set8BitData(uint16_t baseAddress, uint8_t dataIn);
+void CRC_set8BitDataReversed(uint16_t baseAddress, uint8_t dataIn);
+uint16_t CRC_getResult(uint16_t baseAddress);
+
+/******************************************************************************/
+// FRAMCtl
+
+void FRAMCtl_write8(uint8_t *dataPtr, uint8_t *framPtr, uint16_t numberOfBytes);
+void FRAMCtl_write16(uint16_t *dataPtr, uint16_t *framPtr, uint16_t numberOfWords);
+void FRAMCtl_write32(uint32_t *dataPtr, uint32_t *framPtr, uint16_t count);
+
+/******************************************************************************/
+// PMM
+
+void PMM_unlockLPM5(void);
+
+/******************************************************************************/
+// SYS
+
+#define SYSRSTIV                         (sim_sysrstiv())
+
+#define SYSRSTIV_NONE                    (0x0000)
+#define SYSRSTIV_BOR                     (0x0002)
+#define SYSRSTIV_RSTNMI                  (0x0004)
+#define SYSRSTIV_DOBOR                   (0x0006)
+#define SYSRSTIV_LPM5WU                  (0x0008)
+#define SYSRSTIV_SECYV                   (0x000A)
+#define SYSRSTIV_SVSHIFG                 (0x000E)
+#define SYSRSTIV_DOPOR                   (0x0014)
+#define SYSRSTIV_WDTTO                   (0x0016)
+#define SYSRSTIV_WDTKEY                  (0x0018)
+#define SYSRSTIV_FRCTLPW                 (0x001A)
+#define SYSRSTIV_UBDIFG                  (0x001C)
+#define SYSRSTIV_PERF                    (0x001E)
+#define SYSRSTIV_PMMPW                   (0x0020)
+#define SYSRSTIV_FLLUL                   (0x0024)
+
+/******************************************************************************/
+// WDT_A
+
+#define WDT_A_BASE                       (0x01CC)
+
+#define WDTIS_7                          (0x0007)
+#define WDTSSEL_3                        (0x0060)
+#define WDTHOLD                          (0x0080)
+
+#define WDT_A_CLOCKSOURCE_SMCLK          (0x00)
+#define WDT_A_CLOCKSOURCE_ACLK           (0x20)
+#define WDT_A_CLOCKSOURCE_VLOCLK         (0x40)
+#define WDT_A_CLOCKSOURCE_XCLK           (0x60)
+
+#define WDT_A_CLOCKDIVIDER_2G            (0x00)
+#define WDT_A_CLOCKDIVIDER_128M          (0x01)
+#define WDT_A_CLOCKDIVIDER_8192K         (0x02)
+#define WDT_A_CLOCKDIVIDER_512K          (0x03)
+#define WDT_A_CLOCKDIVIDER_32K           (0x04)
+#define WDT_A_CLOCKDIVIDER_8192          (0x05)
+#define WDT_A_CLOCKDIVIDER_512           (0x06)
+#define WDT_A_CLOCKDIVIDER_64            (0x07)
+
+void WDT_A_hold(uint16_t baseAddress);
+void WDT_A_start(uint16_t baseAddress);
+void WDT_A_resetTimer(uint16_t baseAddress);
+void WDT_A_initWatchdogTimer(uint16_t baseAddress, uint8_t clockSelect, uint8_t clockDivider);
+
+#endif /* SIM_DRIVERLIB_H */
+
+/*** end of file ***/
@@ -0,0 +1,1092 @@
+/******************************************************************************/
+
+/** @file host.c
+*
+* @brief Scripted game host and human opponent for the simulated robot.
+*
+* @par
+* Plays games over UART1 with the 1 byte instructions listed in uart.c, the
+* way the game PC does. The human picks random legal columns, and so does the
+* host for the robot unless the robot is asked to choose its own. Games alternate
+* between the robot and the human going first. Each robot turn is timed from
+* the column instruction to the no error reply, and each human turn from the
+* chip being dropped to the column instruction.
+*
+* @par
+* With diagnostics the host first runs the bench checks in diag.c, a dump
+* of the sensors, homing and a test drop into every column, the way the
+* robot is qualified before it goes out. With calibration the host then has
+* the robot find its columns with Y and checks each against where the
+* simulated column really is. Whenever the robot pauses with a column full
+* of test chips the board is emptied and Y sent again.
+*
+* @par
+* After each game the host asks for the firmware's turn phase trace and
+* adds up how long each phase took, and once the games are over for the
+* jam recovery counters.
+*
+* @par
+* With hangs to inject, the firmware is made to hang part way through robot
+* turns, while it is busy with the chip and nothing is on the line, so the
+* watchdog resets it and the turn has to carry on from FRAM.
+*
+* @par
+* When the robot reports a jammed chip someone comes over a few seconds
+* later and frees it, and the chip falls into the column under the carriage
+* for the robot to see. With nothing stuck and no chip dropped this turn,
+* which a reset part way through recovery can leave, they put the robot's
+* chip in by hand. If the chip went into the column past a failed sensor
+* instead, the game is abandoned and a new one started with @ or G.
+*
+* @par
+* The run fails if the firmware reports an error, reports the wrong column,
+* or goes quiet for longer than STALL_TIME.
+*/
+
+// Includes
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "driverlib.h"
+#include "trace.h"
+#include "periph.h"
+#include "robot.h"
+#include "host.h"
+
+#define HOST_UART               1
+#define ROWS                    6
+#define COLUMNS                 ROBOT_COLUMNS
+#define HUMAN_DELAY_MIN         2000            // Human thinking, in ms
+#define HUMAN_DELAY_RANGE       3000
+#define GAME_GAP                SIM_MS(500)
+#define CONNECT_DELAY           SIM_MS(500)     // Robot powering up before the host connects
+#define STALL_TIME              SIM_MS(45000)   // Longer than the firmware's jam recovery
+#define CALIBRATE_TIME          SIM_MS(600000)  // 42 test chips, some timing out
+#define CALIBRATE_BYTES         (1 + 1 + 2 * COLUMNS)   // Y failed positions
+#define CALIBRATE_FULL          0x80            // Y failed bit 7, the board needs emptying
+#define EMPTY_DELAY             SIM_MS(20000)   // Someone emptying the board
+#define JAM_BYTES               (1 + 2 * 5)     // Z jams reseat wiggle rehome hard
+#define FILTER_BYTES            (1 + 2 + 4 * COLUMNS)   // [ glitches filters
+#define HEALTH_BYTES            (1 + 3 + 4 * COLUMNS)   // \ stuck_blocked stuck_clear blocked sensors
+#define DUMP_BYTES              (1 + 14)        // ^ beams bump position overruns log homing
+#define HOME_BYTES              (1 + 4)         // ] 1 position bump
+#define DROP_BYTES              (1 + 4)         // _ column seen ms
+#define DIAG_BYTES              (DUMP_BYTES + HOME_BYTES + DROP_BYTES * COLUMNS)
+#define WATCHDOG_PERIOD         SIM_MS(1000)
+#define TRACE_PHASES            11
+#define TRACE_RECORD_BYTES      6
+#define TRACE_CHUNK             4               // Records per X instruction
+#define HANG_DELAY_MIN          10              // Column sent to hang, in ms
+#define HANG_DELAY_RANGE        1490
+#define CLEAR_DELAY_MIN         3000            // Someone coming over to a jam, in ms
+#define CLEAR_DELAY_RANGE       5000
+
+typedef enum
+{
+    WAIT_NOTHING,
+    WAIT_MOVE,          // Robot is choosing its column
+    WAIT_NO_ERROR,      // Robot is placing its chip
+    WAIT_COLUMN,        // Robot is watching for the human's chip
+    WAIT_TRACE,         // Robot is sending its trace
+    WAIT_DIAGNOSE,      // Robot is running its diagnostics
+    WAIT_CALIBRATE,     // Robot is calibrating its columns
+    WAIT_JAM,           // Robot is sending its jam recovery counters
+    WAIT_FILTER,        // Robot is sending its photo-interrupter filter
+    WAIT_HEALTH         // Robot is sending its photo-interrupter health
+} wait_t;
+
+typedef enum
+{
+    TRACE_IDLE,
+    TRACE_OP,           // X starting the dump
+    TRACE_COUNT_L,
+    TRACE_COUNT_H,
+    TRACE_CHUNK_OP,     // X starting a chunk of records
+    TRACE_RECORD
+} trace_state_t;
+
+typedef struct
+{
+    uint32_t    count;
+    double      total;
+    double      min;
+    double      max;
+} latency_t;
+
+// Local variables
+static uint32_t     games           = 0;
+static uint8_t      robot_chooses   = 0;
+static sim_time_t   think_time      = 0;        // Host thinking about the robot's move
+static uint8_t      pipeline        = 0;        // Send the game status with the robot's column
+static uint8_t      pipelined_over  = 0;        // Game status already sent was O
+static uint32_t     game            = 0;
+static uint32_t     turns           = 0;
+static uint8_t      board[ROWS][COLUMNS];       // 0 empty, 1 robot, 2 human
+static uint8_t      heights[COLUMNS];
+static uint8_t      moves           = 0;
+static wait_t       waiting         = WAIT_NOTHING;
+static uint8_t      column          = 0;
+static sim_time_t   started         = 0;
+static sim_time_t   progress        = 0;
+static int64_t      wall_start      = 0;
+static latency_t    robot_latency;
+static latency_t    human_latency;
+static uint32_t     wrong_column    = 0;
+static uint32_t     jammed          = 0;
+static uint32_t     turn_drops      = 0;        // Chips the robot had dropped before this turn
+static uint32_t     sensor_faults   = 0;
+static uint32_t     failures        = 0;
+static uint32_t     abandoned       = 0;
+static uint32_t     wins[3];                    // Draws, robot wins, human wins
+static uint8_t      diagnose        = 0;
+static uint8_t      diagnosis[DIAG_BYTES];      // ^ then ] then _ for each column
+static uint8_t      diagnose_index  = 0;
+static uint8_t      calibrate       = 0;
+static uint8_t      calibrated      = 0;
+static uint8_t      calibration[CALIBRATE_BYTES];
+static uint8_t      calibrate_index = 0;
+static uint32_t     emptied         = 0;
+static uint8_t      jam_stats[JAM_BYTES];
+static uint8_t      jam_index       = 0;
+static uint8_t      filter[FILTER_BYTES];
+static uint8_t      filter_index    = 0;
+static uint8_t      health[HEALTH_BYTES];
+static uint8_t      health_index    = 0;
+static uint32_t     hangs_left      = 0;        // Hangs still to inject
+static uint32_t     hangs           = 0;        // Hangs injected
+
+// Trace dump being received
+static trace_state_t    trace_state     = TRACE_IDLE;
+static uint16_t         trace_records   = 0;        // Still to come
+static uint8_t          trace_chunk     = 0;        // Records left in this chunk
+static uint8_t          trace_record[TRACE_RECORD_BYTES];
+static uint8_t          trace_index     = 0;
+static uint32_t         trace_begun[TRACE_PHASES];
+static uint8_t          trace_open[TRACE_PHASES];
+static latency_t        trace_latency[TRACE_PHASES];
+
+static const char *const trace_names[TRACE_PHASES] =
+{
+    "turn", "uart", "engine", "move", "drop", "detect", "park", "home", "recover",
+    "prepos", "boot"
+};
+
+static void human_turn(void *arg);
+static void robot_turn(void *arg);
+static void game_start(void *arg);
+static void host_think(void);
+static void trace_request(void);
+
+/*!
+* @brief Gets the wall clock time in ns.
+*/
+static int64_t
+wall_ns (void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}   /* wall_ns() */
+
+/*!
+* @brief Adds a turn time to a latency summary.
+*/
+static void
+latency_add (latency_t *latency, sim_time_t time)
+{
+    double ms = SIM_SECONDS(time) * 1000;
+
+    if ((0 == latency->count) || (ms < latency->min))
+    {
+        latency->min = ms;
+    }
+    if ((0 == latency->count) || (ms > latency->max))
+    {
+        latency->max = ms;
+    }
+    latency->total += ms;
+    latency->count++;
+}   /* latency_add() */
+
+/*!
+* @brief Prints a latency summary.
+*/
+static void
+latency_print (const char *name, const latency_t *latency)
+{
+    if (latency->count)
+    {
+        printf("%-14s n=%-5u min %8.1f ms  mean %8.1f ms  max %8.1f ms\n", name, latency->count,
+               latency->min, latency->total / latency->count, latency->max);
+    }
+}   /* latency_print() */
+
+/*!
+* @brief Prints what the diagnostics found.
+*/
+static void
+diagnose_print (void)
+{
+    const uint8_t *dump  = diagnosis;
+    const uint8_t *home  = diagnosis + DUMP_BYTES;
+    const uint8_t *drop  = home + HOME_BYTES;
+    uint32_t       total = 0;
+    uint8_t        col;
+
+    printf("diagnostics    beams 0x%02X, %u resets, homed to %d bump %u, drops seen in",
+           dump[1], dump[8] | (dump[9] << 8), (int16_t)(home[2] | (home[3] << 8)), home[4]);
+    for (col = 0; col < COLUMNS; col++, drop += DROP_BYTES)
+    {
+        printf(" %u", drop[2]);
+        total += drop[3] | (drop[4] << 8);
+    }
+    printf(", mean %u ms\n", total / COLUMNS);
+}   /* diagnose_print() */
+
+/*!
+* @brief Prints the results and ends the run.
+*/
+static void
+host_finish (void)
+{
+    const robot_stats_t *robot = robot_stats();
+    double               wall  = (wall_ns() - wall_start) / 1e9;
+    sim_time_t           lpm0;
+    sim_time_t           lpm3;
+    char                 name[32];
+    uint8_t              phase;
+    uint8_t              col;
+
+    printf("connect4_sim: %u games, %u turns in %.1f s simulated, %.1f s wall (%.1fx)\n",
+           game, turns, SIM_SECONDS(sim_now()), wall, SIM_SECONDS(sim_now()) / wall);
+    latency_print("robot turn", &robot_latency);
+    latency_print("human detect", &human_latency);
+    for (phase = 0; phase < TRACE_PHASES; phase++)
+    {
+        snprintf(name, sizeof(name), "trace %s", trace_names[phase]);
+        latency_print(name, &trace_latency[phase]);
+    }
+    printf("carriage       %u steps, %u stalled, %u chips dropped, %u missed, %u jammed\n",
+           robot->steps, robot->stalls, robot->drops, robot->misses, robot->jams);
+    if (DIAG_BYTES == diagnose_index)
+    {
+        diagnose_print();
+    }
+    if (calibrated)
+    {
+        printf("calibration    off by");
+        for (col = 0; col < COLUMNS; col++)
+        {
+            printf(" %+d", (int16_t)(calibration[2 + 2 * col] | (calibration[3 + 2 * col] << 8))
+                           - robot_column_center(col));
+        }
+        printf(" steps, board emptied %u times\n", emptied);
+    }
+    if (JAM_BYTES == jam_index)
+    {
+        printf("recovery       %u jams, %u reseated, %u wiggled, %u rehomed, %u hard\n",
+               jam_stats[1] | (jam_stats[2] << 8), jam_stats[3] | (jam_stats[4] << 8),
+               jam_stats[5] | (jam_stats[6] << 8), jam_stats[7] | (jam_stats[8] << 8),
+               jam_stats[9] | (jam_stats[10] << 8));
+    }
+    if (FILTER_BYTES == filter_index)
+    {
+        printf("noise          %u glitches, %u rejected\n",
+               robot->glitches, filter[1] | (filter[2] << 8));
+    }
+    if (HEALTH_BYTES == health_index)
+    {
+        printf("sensors        stuck blocked 0x%02X, stuck clear 0x%02X, toggles", health[1], health[2]);
+        for (col = 0; col < COLUMNS; col++)
+        {
+            printf(" %u", health[4 + 4 * col] | (health[5 + 4 * col] << 8));
+        }
+        printf("\n");
+    }
+    if (hangs || sim_resets())
+    {
+        printf("watchdog       %u hangs injected, %u resets\n", hangs, sim_resets());
+    }
+    sim_asleep(&lpm0, &lpm3);
+    printf("power          active %.1f%%, LPM0 %.1f%%, LPM3 %.1f%%\n",
+           100.0 * (sim_now() - lpm0 - lpm3) / sim_now(), 100.0 * lpm0 / sim_now(),
+           100.0 * lpm3 / sim_now());
+    printf("results        robot won %u, human won %u, %u drawn, %u abandoned\n",
+           wins[1], wins[2], wins[0], abandoned);
+    printf("errors         %u wrong column, %u chip jammed, %u sensor faults, %u failures\n",
+           wrong_column, jammed, sensor_faults, failures);
+    sim_exit(failures ? 1 : 0);
+}   /* host_finish() */
+
+/*!
+* @brief Records a failure and ends the run.
+*/
+static void
+host_fail (const char *message, uint8_t byte)
+{
+    sim_log("host: %s (0x%02X)", message, byte);
+    failures++;
+    host_finish();
+}   /* host_fail() */
+
+/*!
+* @brief Sends one byte to the firmware.
+*/
+static void
+host_send (uint8_t byte)
+{
+    if (sim_verbose)
+    {
+        sim_log("host: sent %c", byte);
+    }
+    periph_uart_receive(HOST_UART, byte);
+}   /* host_send() */
+
+/*!
+* @brief Picks a random column with room left.
+* @param[in] avoid Columns to keep out of while others have room, bit n =
+* column n.
+*/
+static uint8_t
+pick_column (uint8_t avoid)
+{
+    uint8_t choice;
+    uint8_t open = 0;
+
+    for (choice = 0; choice < COLUMNS; choice++)
+    {
+        if ((heights[choice] < ROWS) && !(avoid & (1 << choice)))
+        {
+            open = 1;
+        }
+    }
+    if (!open)
+    {
+        avoid = 0;
+    }
+
+    do
+    {
+        choice = (uint8_t)sim_random(COLUMNS);
+    }
+    while ((heights[choice] >= ROWS) || (avoid & (1 << choice)));
+
+    return choice;
+}   /* pick_column() */
+
+/*!
+* @brief Counts matching chips from a cell in one direction.
+*/
+static uint8_t
+count_line (uint8_t row, uint8_t col, int8_t d_row, int8_t d_col, uint8_t player)
+{
+    int8_t  r     = (int8_t)row + d_row;
+    int8_t  c     = (int8_t)col + d_col;
+    uint8_t count = 0;
+
+    while ((r >= 0) && (r < ROWS) && (c >= 0) && (c < COLUMNS) && (board[r][c] == player))
+    {
+        count++;
+        r += d_row;
+        c += d_col;
+    }
+    return count;
+}   /* count_line() */
+
+/*!
+* @brief Plays a chip and tells the firmware whether the game goes on.
+* @param[in] player 1 for the robot, 2 for the human.
+* @param[in] col The column played.
+* @return 1 if the game is over, 0 if it goes on.
+*/
+static uint8_t
+host_move (uint8_t player, uint8_t col)
+{
+    static const int8_t directions[4][2] = { {0, 1}, {1, 0}, {1, 1}, {1, -1} };
+    uint8_t             row = heights[col]++;
+    uint8_t             won = 0;
+    uint8_t             d;
+
+    board[row][col] = player;
+    moves++;
+    turns++;
+
+    for (d = 0; d < 4; d++)
+    {
+        if (1 + count_line(row, col, directions[d][0], directions[d][1], player)
+              + count_line(row, col, -directions[d][0], -directions[d][1], player) >= 4)
+        {
+            won = 1;
+        }
+    }
+
+    if (won || (ROWS * COLUMNS == moves))
+    {
+        wins[won ? player : 0]++;
+        if (sim_verbose)
+        {
+            sim_log("host: game %u over after %u moves", game + 1, moves);
+        }
+        host_send('O');
+        return 1;
+    }
+
+    host_send('H');
+    return 0;
+}   /* host_move() */
+
+/*!
+* @brief Moves on once a chip has been played and the firmware told.
+* @param[in] over 1 if the game is over.
+* @param[in] next The next turn if the game goes on.
+*/
+static void
+host_next (uint8_t over, sim_event_t next)
+{
+    if (over)
+    {
+        game++;
+        trace_request();
+    }
+    else if (robot_turn == next)
+    {
+        host_think();
+    }
+    else
+    {
+        sim_schedule(SIM_MS(HUMAN_DELAY_MIN + sim_random(HUMAN_DELAY_RANGE)), next, 0);
+    }
+}   /* host_next() */
+
+/*!
+* @brief Plays a chip, tells the firmware whether the game goes on and
+* moves on.
+* @param[in] player 1 for the robot, 2 for the human.
+* @param[in] col The column played.
+* @param[in] next The next turn if the game goes on.
+*/
+static void
+host_play (uint8_t player, uint8_t col, sim_event_t next)
+{
+    host_next(host_move(player, col), next);
+}   /* host_play() */
+
+/*!
+* @brief Picks the robot's column and hints it to the robot, then thinks it
+* over before sending it.
+*/
+static void
+host_think (void)
+{
+    if (!robot_chooses)
+    {
+        column = pick_column(0);
+        host_send(0x60 | column); // `,a,b,c,d,e,f
+    }
+    sim_schedule(think_time, robot_turn, 0);
+}   /* host_think() */
+
+/*!
+* @brief Hangs the firmware if the robot is still busy with its turn.
+*
+* @par
+* Only while it is asleep and sending nothing, so every instruction sent has
+* been queued and no reply is cut off by the reset.
+*/
+static void
+host_hang (void *arg)
+{
+    if (((WAIT_MOVE == waiting) || (WAIT_NO_ERROR == waiting)) && (sim_sleep_bits() & CPUOFF)
+        && !periph_uarts[HOST_UART].tx_active)
+    {
+        if (sim_verbose)
+        {
+            sim_log("host: hanging the firmware");
+        }
+        hangs_left--;
+        hangs++;
+        sim_hang();
+    }
+}   /* host_hang() */
+
+/*!
+* @brief Frees the robot's jammed chip, if it is still waiting for it.
+*/
+static void
+host_clear_jam (void *arg)
+{
+    if (WAIT_NO_ERROR != waiting)
+    {
+        return;
+    }
+    if (robot_clear_jam())
+    {
+        progress = sim_now();
+    }
+    else if (robot_stats()->drops + robot_stats()->misses == turn_drops)
+    {
+        if (sim_verbose)
+        {
+            sim_log("host: robot's chip put in column %u by hand", column);
+        }
+        progress = sim_now();
+        robot_human_drop(column);
+    }
+    else
+    {
+        abandoned++;
+        sim_log("host: robot's chip went in unseen, abandoning the game");
+        waiting = WAIT_NOTHING;
+        game_start(0);
+    }
+}   /* host_clear_jam() */
+
+/*!
+* @brief Tells the robot which column to play.
+*/
+static void
+robot_turn (void *arg)
+{
+    started    = sim_now();
+    progress   = started;
+    turn_drops = robot_stats()->drops + robot_stats()->misses;
+    if (robot_chooses)
+    {
+        waiting = WAIT_MOVE;
+        host_send('w');
+    }
+    else
+    {
+        waiting = WAIT_NO_ERROR;
+        host_send(0x70 | column); // p,q,r,s,t,u,v
+        if (pipeline)
+        {
+            pipelined_over = host_move(1, column);
+        }
+    }
+    if (hangs_left)
+    {
+        sim_schedule(SIM_MS(HANG_DELAY_MIN + sim_random(HANG_DELAY_RANGE)), host_hang, 0);
+    }
+}   /* robot_turn() */
+
+/*!
+* @brief Drops the human's chip.
+*/
+static void
+human_turn (void *arg)
+{
+    // The robot can't see a chip go past a failed sensor
+    column   = pick_column(robot_failed_sensors());
+    waiting  = WAIT_COLUMN;
+    started  = sim_now();
+    progress = started;
+    if (sim_verbose)
+    {
+        sim_log("host: human drops into column %u", column);
+    }
+    robot_human_drop(column);
+}   /* human_turn() */
+
+/*!
+* @brief Clears the board and starts a game.
+*/
+static void
+game_start (void *arg)
+{
+    uint8_t robot_first = !(game & 1);
+
+    memset(board, 0, sizeof(board));
+    memset(heights, 0, sizeof(heights));
+    moves = 0;
+
+    host_send(robot_first ? '@' : 'G');
+    if (robot_first)
+    {
+        host_think();
+    }
+    else
+    {
+        sim_schedule(SIM_MS(HUMAN_DELAY_MIN + sim_random(HUMAN_DELAY_RANGE)), human_turn, 0);
+    }
+}   /* game_start() */
+
+/*!
+* @brief Pairs a trace record with the start of its phase.
+*/
+static void
+trace_add (const uint8_t *record)
+{
+    uint32_t time  = record[0] | (record[1] << 8) | (record[2] << 16) | ((uint32_t)record[3] << 24);
+    uint8_t  phase = record[4] & ~TRACE_END;
+
+    if (phase >= TRACE_PHASES)
+    {
+        return;
+    }
+    if (!(record[4] & TRACE_END))
+    {
+        // The timebase starts again from zero after a reset
+        if (TRACE_BOOT == phase)
+        {
+            memset(trace_open, 0, sizeof(trace_open));
+        }
+        trace_begun[phase] = time;
+        trace_open[phase]  = 1;
+    }
+    else if (trace_open[phase])
+    {
+        trace_open[phase] = 0;
+        latency_add(&trace_latency[phase],
+                    (sim_time_t)(time - trace_begun[phase]) * (SIM_HZ / TRACE_TICKS_PER_SECOND));
+    }
+}   /* trace_add() */
+
+/*!
+* @brief Asks the firmware for its trace after a game.
+*/
+static void
+trace_request (void)
+{
+    waiting     = WAIT_TRACE;
+    progress    = sim_now();
+    trace_state = TRACE_OP;
+    memset(trace_open, 0, sizeof(trace_open));
+    host_send('X');
+}   /* trace_request() */
+
+/*!
+* @brief Starts the next game, or ends the run, once the trace is in.
+*/
+static void
+trace_done (void)
+{
+    if (sim_verbose)
+    {
+        sim_log("host: received the trace");
+    }
+    trace_state = TRACE_IDLE;
+    waiting     = WAIT_NOTHING;
+    if (game >= games)
+    {
+        // Finish with the jam recovery counters
+        waiting     = WAIT_JAM;
+        progress    = sim_now();
+        host_send('Z');
+        return;
+    }
+    sim_schedule(GAME_GAP, game_start, 0);
+}   /* trace_done() */
+
+/*!
+* @brief Takes a byte of a trace dump.
+* @return 1 if the byte was part of the dump, 0 if no dump is expected.
+*/
+static uint8_t
+trace_receive (uint8_t byte)
+{
+    switch (trace_state)
+    {
+    case TRACE_IDLE:
+        return 0;
+
+    case TRACE_OP:
+    case TRACE_CHUNK_OP:
+        if ('X' != byte)
+        {
+            host_fail("trace dump out of step", byte);
+        }
+        trace_index = 0;
+        trace_state = (TRACE_OP == trace_state) ? TRACE_COUNT_L : TRACE_RECORD;
+        break;
+
+    case TRACE_COUNT_L:
+        trace_records = byte;
+        trace_state   = TRACE_COUNT_H;
+        break;
+
+    case TRACE_COUNT_H:
+        trace_records |= byte << 8;
+        trace_chunk    = TRACE_CHUNK;
+        trace_state    = TRACE_CHUNK_OP;
+        if (sim_verbose)
+        {
+            sim_log("host: receiving %u trace records", trace_records);
+        }
+        if (0 == trace_records)
+        {
+            trace_done();
+        }
+        break;
+
+    case TRACE_RECORD:
+        trace_record[trace_index++] = byte;
+        if (TRACE_RECORD_BYTES == trace_index)
+        {
+            trace_add(trace_record);
+            trace_index = 0;
+            trace_records--;
+            if (0 == trace_records)
+            {
+                trace_done();
+            }
+            else if (0 == --trace_chunk)
+            {
+                trace_chunk = TRACE_CHUNK;
+                trace_state = TRACE_CHUNK_OP;
+            }
+        }
+        break;
+    }
+    return 1;
+}   /* trace_receive() */
+
+/*!
+* @brief Has the robot carry on calibrating once the board is emptied.
+*/
+static void
+calibrate_resume (void *arg)
+{
+    progress = sim_now();
+    host_send('Y');
+}   /* calibrate_resume() */
+
+/*!
+* @brief Takes a byte of the calibration reply and starts the games once it
+* is all in, or empties the board if the robot paused for that.
+*/
+static void
+calibrate_receive (uint8_t byte)
+{
+    if ((0 == calibrate_index) && ('Y' != byte))
+    {
+        host_fail("unexpected byte from the robot", byte);
+    }
+    calibration[calibrate_index++] = byte;
+    if (CALIBRATE_BYTES != calibrate_index)
+    {
+        return;
+    }
+
+    if (calibration[1] & CALIBRATE_FULL)
+    {
+        emptied++;
+        calibrate_index = 0;
+        sim_log("host: a column is full of test chips, emptying the board");
+        sim_schedule(EMPTY_DELAY, calibrate_resume, 0);
+        return;
+    }
+
+    waiting     = WAIT_NOTHING;
+    calibrated  = 1;
+    if (calibration[1])
+    {
+        host_fail("robot could not calibrate some columns", calibration[1]);
+    }
+    if (sim_verbose)
+    {
+        sim_log("host: robot calibrated");
+    }
+    sim_schedule(GAME_GAP, game_start, 0);
+}   /* calibrate_receive() */
+
+/*!
+* @brief Takes a byte of the jam recovery counters and ends the run once
+* they are all in.
+*/
+static void
+jam_receive (uint8_t byte)
+{
+    if ((0 == jam_index) && ('Z' != byte))
+    {
+        host_fail("unexpected byte from the robot", byte);
+    }
+    jam_stats[jam_index++] = byte;
+    if (JAM_BYTES == jam_index)
+    {
+        // Then the glitches the filter threw away
+        waiting     = WAIT_FILTER;
+        progress    = sim_now();
+        host_send('[');
+    }
+}   /* jam_receive() */
+
+/*!
+* @brief Takes a byte of the photo-interrupter filter report and ends the
+* run once it is all in.
+*/
+static void
+filter_receive (uint8_t byte)
+{
+    if ((0 == filter_index) && ('[' != byte))
+    {
+        host_fail("unexpected byte from the robot", byte);
+    }
+    filter[filter_index++] = byte;
+    if (FILTER_BYTES == filter_index)
+    {
+        // Then how the sensors are doing
+        waiting     = WAIT_HEALTH;
+        progress    = sim_now();
+        host_send('\\');
+    }
+}   /* filter_receive() */
+
+/*!
+* @brief Takes a byte of the photo-interrupter health report and ends the
+* run once it is all in.
+*/
+static void
+health_receive (uint8_t byte)
+{
+    if ((0 == health_index) && ('\\' != byte))
+    {
+        host_fail("unexpected byte from the robot", byte);
+    }
+    health[health_index++] = byte;
+    if (HEALTH_BYTES == health_index)
+    {
+        host_finish();
+    }
+}   /* health_receive() */
+
+/*!
+* @brief Starts the games, calibrating the robot first if asked to.
+*/
+static void
+host_ready (void)
+{
+    if (!calibrate)
+    {
+        game_start(0);
+        return;
+    }
+
+    waiting     = WAIT_CALIBRATE;
+    progress    = sim_now();
+    host_send('Y');
+}   /* host_ready() */
+
+/*!
+* @brief Takes a byte of the diagnostics' replies and moves on once they
+* are all in.
+*/
+static void
+diagnose_receive (uint8_t byte)
+{
+    uint8_t op = '_';
+
+    if (0 == diagnose_index)
+    {
+        op = '^';
+    }
+    else if (DUMP_BYTES == diagnose_index)
+    {
+        op = ']';
+    }
+    else if ((diagnose_index < DUMP_BYTES + HOME_BYTES)
+             || ((diagnose_index - DUMP_BYTES - HOME_BYTES) % DROP_BYTES))
+    {
+        op = 0;
+    }
+    if (op && (op != byte))
+    {
+        host_fail("diagnostics out of step", byte);
+    }
+
+    diagnosis[diagnose_index++] = byte;
+    if (DIAG_BYTES != diagnose_index)
+    {
+        return;
+    }
+
+    waiting = WAIT_NOTHING;
+    if (diagnosis[DUMP_BYTES + 2] || diagnosis[DUMP_BYTES + 3] || !diagnosis[DUMP_BYTES + 4])
+    {
+        host_fail("robot didn't home", diagnosis[DUMP_BYTES + 4]);
+    }
+    if (sim_verbose)
+    {
+        sim_log("host: robot diagnosed");
+    }
+    host_ready();
+}   /* diagnose_receive() */
+
+/*!
+* @brief Connects to the robot, running its diagnostics first if asked to.
+*
+* @par
+* The three instructions go at once and are answered in turn: the sensor
+* dump, homing, and a test drop into every column.
+*/
+static void
+host_connect (void *arg)
+{
+    if (!diagnose)
+    {
+        host_ready();
+        return;
+    }
+
+    waiting     = WAIT_DIAGNOSE;
+    progress    = sim_now();
+    host_send('^');
+    host_send(']');
+    host_send('_');
+}   /* host_connect() */
+
+/*!
+* @brief Handles a byte from the firmware.
+*/
+static void
+host_receive (uint8_t uart, uint8_t byte)
+{
+    if (HOST_UART != uart)
+    {
+        return;
+    }
+    progress = sim_now();
+    if (trace_receive(byte))
+    {
+        return;
+    }
+    if (WAIT_DIAGNOSE == waiting)
+    {
+        diagnose_receive(byte);
+        return;
+    }
+    if (WAIT_CALIBRATE == waiting)
+    {
+        calibrate_receive(byte);
+        return;
+    }
+    if (WAIT_JAM == waiting)
+    {
+        jam_receive(byte);
+        return;
+    }
+    if (WAIT_FILTER == waiting)
+    {
+        filter_receive(byte);
+        return;
+    }
+    if (WAIT_HEALTH == waiting)
+    {
+        health_receive(byte);
+        return;
+    }
+    if (sim_verbose)
+    {
+        sim_log("host: received %c", byte);
+    }
+
+    if ((WAIT_MOVE == waiting) && ((byte & 0xF8) == 0x70)) // p,q,r,s,t,u,v
+    {
+        column  = byte & 0x07;
+        waiting = WAIT_NO_ERROR;
+        if ((column >= COLUMNS) || (heights[column] >= ROWS))
+        {
+            host_fail("robot chose a column it can't play", byte);
+        }
+    }
+    else if ((WAIT_NO_ERROR == waiting) && (('W' == byte) || ('z' == byte)))
+    {
+        // z, the robot dropped its chip but can't see it land
+        if ('z' == byte)
+        {
+            sensor_faults++;
+            sim_log("host: robot reports a failed sensor over its column");
+        }
+        waiting = WAIT_NOTHING;
+        latency_add(&robot_latency, sim_now() - started);
+        if (pipeline && !robot_chooses)
+        {
+            host_next(pipelined_over, human_turn);
+        }
+        else
+        {
+            host_play(1, column, human_turn);
+        }
+    }
+    else if ((WAIT_NO_ERROR == waiting) && ('x' == byte))
+    {
+        wrong_column++;
+        sim_log("host: robot reports a chip in the wrong column");
+    }
+    else if ((WAIT_NO_ERROR == waiting) && ('y' == byte))
+    {
+        jammed++;
+        progress = sim_now();
+        sim_log("host: robot reports a jammed chip");
+        sim_schedule(SIM_MS(CLEAR_DELAY_MIN + sim_random(CLEAR_DELAY_RANGE)), host_clear_jam, 0);
+    }
+    else if ('z' == byte)
+    {
+        sensor_faults++;
+        if (sim_verbose)
+        {
+            sim_log("host: robot reports a failed sensor");
+        }
+    }
+    else if ((WAIT_COLUMN == waiting) && ((byte & 0xF8) == 0x68)) // h,i,j,k,l,m,n
+    {
+        waiting = WAIT_NOTHING;
+        if ((byte & 0x07) != column)
+        {
+            host_fail("robot saw the human's chip in the wrong column", byte);
+        }
+        latency_add(&human_latency, sim_now() - started);
+        host_play(2, column, robot_turn);
+    }
+    else
+    {
+        host_fail("unexpected byte from the robot", byte);
+    }
+}   /* host_receive() */
+
+/*!
+* @brief Fails the run if the robot has gone quiet.
+*/
+static void
+host_watchdog (void *arg)
+{
+    sim_time_t limit = (WAIT_CALIBRATE == waiting) ? CALIBRATE_TIME : STALL_TIME;
+
+    if ((WAIT_NOTHING != waiting) && (sim_now() - progress > limit))
+    {
+        host_fail("robot stopped responding", column);
+    }
+    sim_schedule(WATCHDOG_PERIOD, host_watchdog, 0);
+}   /* host_watchdog() */
+
+/*!
+* @brief Sets up the host to play a number of games.
+* @param[in] count The number of games.
+* @param[in] engine 1 to have the robot choose its own moves, 0 to pick them.
+* @param[in] diagnose_first 1 to have the robot run its diagnostics first.
+* @param[in] calibrate_first 1 to have the robot calibrate its columns first.
+* @param[in] think_ms How long the host thinks about each robot move, in ms.
+* @param[in] pipelined 1 to send the game status along with the robot's column.
+* @param[in] hang_count How many times to hang the firmware during robot turns.
+*/
+void
+host_init (uint32_t count, uint8_t engine, uint8_t diagnose_first, uint8_t calibrate_first, uint32_t think_ms,
+           uint8_t pipelined, uint32_t hang_count)
+{
+    games           = count;
+    robot_chooses   = engine;
+    diagnose        = diagnose_first;
+    calibrate       = calibrate_first;
+    think_time      = SIM_MS(think_ms);
+    pipeline        = pipelined;
+    hangs_left      = hang_count;
+    wall_start      = wall_ns();
+
+    periph_uart_transmit = host_receive;
+    sim_schedule(CONNECT_DELAY, host_connect, 0);
+    sim_schedule(WATCHDOG_PERIOD, host_watchdog, 0);
+}   /* host_init() */
+
+/*** end of file ***/
@@ -0,0 +1,17 @@
+/******************************************************************************/
+
+/** @file host.h
+*
+* @brief Scripted game host and human opponent for the simulated robot.
+*/
+
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdint.h>
+
+void host_init(uint32_t games, uint8_t engine, uint8_t diagnose, uint8_t calibrate, uint32_t think, uint8_t pipeline, uint32_t hangs);
+
+#endif /* HOST_H */
+
+/*** end of file ***/
@@ -0,0 +1,193 @@
+/******************************************************************************/
+
+/** @file main.c
+*
+* @brief Runs the firmware against the simulated robot and a scripted host.
+*
+* @par
+* With -P the robot is connected to a pseudo terminal instead of the
+* scripted host, for a host program to drive, see pty.c.
+*
+* @par
+* Usage: connect4_sim [-g games] [-s seed] [-x speed] [-p position] [-j jam%] [-n rate] [-b column] [-u column] [-t steps] [-d ms] [-f hangs] [-D] [-c] [-e] [-q] [-P link] [-v]
+*/
+
+// Includes
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "periph.h"
+#include "robot.h"
+#include "host.h"
+#include "pty.h"
+
+#define DEFAULT_GAMES           5
+#define DEFAULT_SPEED           50.0
+#define DEFAULT_POSITION        900
+#define DEFAULT_THINK           5
+
+// The firmware's main(), renamed by the build
+void firmware_main(void);
+
+/*!
+* @brief Prints the command line options.
+*/
+static void
+usage (const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -g games     games to play (%d)\n"
+            "  -s seed      random seed for the moves and jams\n"
+            "  -x speed     simulated seconds per wall second while awake (%.0f, 1 with -P)\n"
+            "  -p position  carriage start position in steps (%d)\n"
+            "  -j percent   chance of a chip jamming in the dispenser (0)\n"
+            "  -n rate      noise glitches per second on the beams (0)\n"
+            "  -b column    sensor stuck blocked\n"
+            "  -u column    sensor stuck clear\n"
+            "  -t steps     most steps each column is off the nominal geometry (0)\n"
+            "  -d ms        host thinking time before each robot move (%d)\n"
+            "  -f hangs     firmware hangs to inject during robot turns (0)\n"
+            "  -D           run the bench diagnostics before the first game\n"
+            "  -c           calibrate the columns before the first game\n"
+            "  -e           have the robot choose its own moves\n"
+            "  -q           send the game status along with each robot column\n"
+            "  -P link      connect the robot to a pseudo terminal linked here, no host\n"
+            "  -v           log every instruction and chip\n",
+            name, DEFAULT_GAMES, DEFAULT_SPEED, DEFAULT_POSITION, DEFAULT_THINK);
+    exit(2);
+}   /* usage() */
+
+int
+main (int argc, char **argv)
+{
+    uint32_t games      = DEFAULT_GAMES;
+    uint32_t seed       = 1;
+    double   speed      = 0;
+    int32_t  position   = DEFAULT_POSITION;
+    uint32_t jam        = 0;
+    uint32_t noise      = 0;
+    int      blocked    = -1;
+    int      clear      = -1;
+    uint32_t tolerance  = 0;
+    uint32_t think      = DEFAULT_THINK;
+    uint32_t hangs      = 0;
+    uint8_t  diagnose   = 0;
+    uint8_t  calibrate  = 0;
+    uint8_t  engine     = 0;
+    uint8_t  pipeline   = 0;
+    char    *pty        = 0;
+    int      option;
+
+    while ((option = getopt(argc, argv, "g:s:x:p:j:n:b:u:t:d:f:DceqP:vh")) != -1)
+    {
+        switch (option)
+        {
+        case 'g':
+            games = (uint32_t)strtoul(optarg, 0, 0);
+            break;
+
+        case 's':
+            seed = (uint32_t)strtoul(optarg, 0, 0);
+            break;
+
+        case 'x':
+            speed = strtod(optarg, 0);
+            break;
+
+        case 'p':
+            position = (int32_t)strtol(optarg, 0, 0);
+            break;
+
+        case 'j':
+            jam = (uint32_t)strtoul(optarg, 0, 0);
+            break;
+
+        case 'n':
+            noise = (uint32_t)strtoul(optarg, 0, 0);
+            break;
+
+        case 'b':
+            blocked = atoi(optarg);
+            break;
+
+        case 'u':
+            clear = atoi(optarg);
+            break;
+
+        case 't':
+            tolerance = (uint32_t)strtoul(optarg, 0, 0);
+            break;
+
+        case 'd':
+            think = (uint32_t)strtoul(optarg, 0, 0);
+            break;
+
+        case 'f':
+            hangs = (uint32_t)strtoul(optarg, 0, 0);
+            break;
+
+        case 'D':
+            diagnose = 1;
+            break;
+
+        case 'c':
+            calibrate = 1;
+            break;
+
+        case 'e':
+            engine = 1;
+            break;
+
+        case 'q':
+            pipeline = 1;
+            break;
+
+        case 'P':
+            pty = optarg;
+            break;
+
+        case 'v':
+            sim_verbose = 1;
+            break;
+
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (0 == speed)
+    {
+        speed = pty ? 1.0 : DEFAULT_SPEED;
+    }
+    if ((0 == games) || (speed <= 0) || (blocked >= ROBOT_COLUMNS) || (clear >= ROBOT_COLUMNS))
+    {
+        usage(argv[0]);
+    }
+
+    sim_seed(seed);
+    periph_init();
+    robot_init(position, jam, tolerance, noise);
+    if (blocked >= 0)
+    {
+        robot_fail_sensor((uint8_t)blocked, 1);
+    }
+    if (clear >= 0)
+    {
+        robot_fail_sensor((uint8_t)clear, 0);
+    }
+    if (pty)
+    {
+        pty_init(pty);
+    }
+    else
+    {
+        host_init(games, engine, diagnose, calibrate, think, pipeline, hangs);
+    }
+
+    sim_start(speed, pty ? 1 : 0);
+    sim_run(firmware_main);
+    return 0;
+}
+
+/*** end of file ***/
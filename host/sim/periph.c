@@ -0,0 +1,772 @@
+/******************************************************************************/
+
+/** @file periph.c
+*
+* @brief Simulated peripherals of the MSP430FR2433.
+*
+* @par
+* Counters are stepped arithmetically. periph_next_event() finds the next count
+* at which anything happens on any timer (a compare match, CCR0 or the wrap to
+* zero) and the next UART byte boundary, and periph_advance() moves everything
+* straight to that time. Timers clocked from SMCLK stop while the CPU is in
+* LPM3, the UART keeps its clock request like the real eUSCI.
+*
+* @par
+* The watchdog only needs to say when it runs out, sim.c checks
+* periph_wdt_expired() and resets the firmware with periph_reset().
+*/
+
+// Includes
+#include <stdint.h>
+#include <string.h>
+#include "driverlib.h"
+#include "periph.h"
+
+// Register state
+sim_port_t      periph_ports[PERIPH_PORTS];
+sim_timer_t     periph_timers[PERIPH_TIMERS];
+sim_uart_t      periph_uarts[PERIPH_UARTS];
+sim_clocks_t    periph_clocks;
+uint16_t        periph_crc;
+sim_wdt_t       periph_wdt;
+
+// Hooks for the virtual robot and host
+void (*periph_timer_output)(uint8_t timer, uint8_t ccr, uint8_t level) = 0;
+void (*periph_uart_transmit)(uint8_t uart, uint8_t byte) = 0;
+
+// Local variables
+static uint32_t reset_causes = 0;   // Bit n = SYSRSTIV 2n not read yet
+
+/*!
+* @brief Resets every peripheral to its power on state.
+*/
+void
+periph_init (void)
+{
+    memset(periph_ports, 0, sizeof(periph_ports));
+    memset(periph_timers, 0, sizeof(periph_timers));
+    memset(periph_uarts, 0, sizeof(periph_uarts));
+    reset_causes = 0;
+    periph_reset(SYSRSTIV_BOR);
+}   /* periph_init() */
+
+/*!
+* @brief Recomputes the clock rates after the clock system is configured.
+*/
+void
+periph_clocks_update (void)
+{
+    periph_clocks.mclk  = periph_clocks.dcoclkdiv >> periph_clocks.mclk_div;
+    periph_clocks.smclk = periph_clocks.mclk >> periph_clocks.smclk_div;
+    periph_clocks.aclk  = periph_clocks.refoclk;
+}   /* periph_clocks_update() */
+
+/******************************************************************************/
+// GPIO
+
+/*!
+* @brief Recomputes PxIN from the outputs, pull resistors and outside drivers.
+* @param[in] port The port 1-3.
+*
+* @par
+* Floating inputs keep the last level read.
+*/
+void
+periph_port_update (uint8_t port)
+{
+    sim_port_t *p       = &periph_ports[port];
+    uint8_t     dir     = p->reg[SIM_PDIR];
+    uint8_t     pulled  = ~dir & ~p->driven & p->reg[SIM_PREN];
+    uint8_t     loose   = ~dir & ~p->driven & ~p->reg[SIM_PREN];
+
+    p->reg[SIM_PIN] = (dir & p->reg[SIM_POUT])
+                    | (~dir & p->driven & p->ext)
+                    | (pulled & p->reg[SIM_POUT])
+                    | (loose & p->reg[SIM_PIN]);
+}   /* periph_port_update() */
+
+/*!
+* @brief Drives port pins from outside the chip, e.g. a sensor output.
+* @param[in] port The port 1-3.
+* @param[in] pins The pins to drive.
+* @param[in] level 1 to drive them high, 0 to drive them low.
+*
+* @par
+* Input edges set PxIFG according to PxIES. Only P1 and P2 have interrupts.
+*/
+void
+periph_port_drive (uint8_t port, uint8_t pins, uint8_t level)
+{
+    sim_port_t *p = &periph_ports[port];
+    uint8_t     before;
+    uint8_t     edges;
+
+    periph_port_update(port);
+    before = p->reg[SIM_PIN];
+
+    p->driven |= pins;
+    p->ext     = level ? (p->ext | pins) : (p->ext & ~pins);
+    periph_port_update(port);
+
+    edges = (before ^ p->reg[SIM_PIN]) & ~p->reg[SIM_PDIR];
+    if (port <= 2)
+    {
+        p->reg[SIM_PIFG] |= (edges & p->reg[SIM_PIN] & ~p->reg[SIM_PIES])
+                          | (edges & ~p->reg[SIM_PIN] & p->reg[SIM_PIES]);
+    }
+}   /* periph_port_drive() */
+
+/******************************************************************************/
+// Timer_A
+
+/*!
+* @brief Gets the timer number from its base address.
+* @param[in] base TIMER_A0_BASE to TIMER_A3_BASE.
+* @return The timer 0-3.
+*/
+uint8_t
+periph_timer_index (uint16_t base)
+{
+    return (uint8_t)((base - TIMER_A0_BASE) >> 6);
+}   /* periph_timer_index() */
+
+/*!
+* @brief Gets the time between counts from the clock source and dividers.
+* @return The count period, 0 if the clock source is not simulated.
+*/
+static sim_time_t
+timer_tick (const sim_timer_t *t)
+{
+    uint32_t hz;
+    uint32_t div;
+
+    switch (t->reg[SIM_TACTL] & TASSEL_3)
+    {
+    case TASSEL__ACLK:
+        hz = periph_clocks.aclk;
+        break;
+
+    case TASSEL__SMCLK:
+        hz = periph_clocks.smclk;
+        break;
+
+    default:
+        // TAxCLK and INCLK pins are not connected
+        return 0;
+    }
+
+    div = (1u << ((t->reg[SIM_TACTL] & ID_3) >> 6)) * ((t->reg[SIM_TAEX0] & TAIDEX_7) + 1);
+    return (SIM_HZ / hz) * div;
+}   /* timer_tick() */
+
+/*!
+* @brief Checks whether a timer is counting.
+*/
+static int
+timer_running (const sim_timer_t *t)
+{
+    uint16_t ctl   = t->reg[SIM_TACTL];
+    uint16_t sleep = sim_sleep_bits();
+
+    if (!(ctl & MC_3) || !timer_tick(t))
+    {
+        return 0;
+    }
+    if (((ctl & TASSEL_3) == TASSEL__SMCLK) && (sleep & SCG1))
+    {
+        return 0;
+    }
+    if (((ctl & TASSEL_3) == TASSEL__ACLK) && (sleep & OSCOFF))
+    {
+        return 0;
+    }
+    return 1;
+}   /* timer_running() */
+
+/*!
+* @brief Gets the count after which the timer rolls to zero.
+*
+* @par
+* Up/down mode is treated as up mode.
+*/
+static uint16_t
+timer_top (const sim_timer_t *t)
+{
+    return ((t->reg[SIM_TACTL] & MC_3) == MC__CONTINUOUS) ? 0xFFFF : t->reg[SIM_TACCR0];
+}   /* timer_top() */
+
+/*!
+* @brief Counts how many ticks until the timer reaches a count that does
+* something: zero, or any CCR value it will reach.
+*/
+static uint32_t
+timer_ticks_to_event (const sim_timer_t *t)
+{
+    uint32_t top    = timer_top(t);
+    uint32_t length = top + 1;
+    uint32_t count  = t->reg[SIM_TAR];
+    uint32_t best   = length;
+    uint32_t target;
+    uint32_t ticks;
+    uint8_t  n;
+
+    // In up mode a count above CCR0 rolls to zero on the next tick
+    if (count > top)
+    {
+        return 1;
+    }
+
+    for (n = 0; n < 4; n++)
+    {
+        target = n ? t->reg[SIM_TACCR0 + n - 1] : 0;
+        if (target > top)
+        {
+            continue;
+        }
+        ticks = (target + length - count) % length;
+        if (0 == ticks)
+        {
+            ticks = length;
+        }
+        if (ticks < best)
+        {
+            best = ticks;
+        }
+    }
+
+    return best;
+}   /* timer_ticks_to_event() */
+
+/*!
+* @brief Changes an output unit level and reports it.
+*/
+static void
+timer_output (sim_timer_t *t, uint8_t timer, uint8_t ccr, uint8_t level)
+{
+    if (t->out[ccr] != level)
+    {
+        t->out[ccr] = level;
+        if (periph_timer_output)
+        {
+            periph_timer_output(timer, ccr, level);
+        }
+    }
+}   /* timer_output() */
+
+/*!
+* @brief Sets the flags and output levels for the count TAR just reached.
+*/
+static void
+timer_count (sim_timer_t *t, uint8_t timer)
+{
+    uint16_t count = t->reg[SIM_TAR];
+    uint16_t mode;
+    uint8_t  n;
+
+    if (0 == count)
+    {
+        t->reg[SIM_TACTL] |= TAIFG;
+    }
+
+    for (n = 0; n < 3; n++)
+    {
+        if (count != t->reg[SIM_TACCR0 + n])
+        {
+            continue;
+        }
+        t->reg[SIM_TACCTL0 + n] |= CCIFG;
+        if (0 == n)
+        {
+            continue;
+        }
+
+        mode = t->reg[SIM_TACCTL0 + n] & OUTMOD_7;
+        switch (mode)
+        {
+        case TIMER_A_OUTPUTMODE_SET:
+        case TIMER_A_OUTPUTMODE_SET_RESET:
+            timer_output(t, timer, n, 1);
+            break;
+
+        case TIMER_A_OUTPUTMODE_RESET:
+        case TIMER_A_OUTPUTMODE_RESET_SET:
+            timer_output(t, timer, n, 0);
+            break;
+
+        case TIMER_A_OUTPUTMODE_TOGGLE:
+        case TIMER_A_OUTPUTMODE_TOGGLE_RESET:
+        case TIMER_A_OUTPUTMODE_TOGGLE_SET:
+            timer_output(t, timer, n, !t->out[n]);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    // The two part output modes take their second action at CCR0
+    if (count == t->reg[SIM_TACCR0])
+    {
+        for (n = 1; n < 3; n++)
+        {
+            mode = t->reg[SIM_TACCTL0 + n] & OUTMOD_7;
+            if ((TIMER_A_OUTPUTMODE_TOGGLE_RESET == mode) || (TIMER_A_OUTPUTMODE_SET_RESET == mode))
+            {
+                timer_output(t, timer, n, 0);
+            }
+            else if ((TIMER_A_OUTPUTMODE_TOGGLE_SET == mode) || (TIMER_A_OUTPUTMODE_RESET_SET == mode))
+            {
+                timer_output(t, timer, n, 1);
+            }
+        }
+    }
+}   /* timer_count() */
+
+/*!
+* @brief Starts counting from the current time, after the timer is started or
+* its clock changes.
+* @param[in] timer The timer 0-3.
+*/
+void
+periph_timer_restart (uint8_t timer)
+{
+    periph_timers[timer].next_tick = sim_now() + timer_tick(&periph_timers[timer]);
+}   /* periph_timer_restart() */
+
+/*!
+* @brief Moves a timer up to a time no later than its next event.
+*/
+static void
+timer_advance (uint8_t timer, sim_time_t now)
+{
+    sim_timer_t *t      = &periph_timers[timer];
+    sim_time_t   tick   = timer_tick(t);
+    uint32_t     length = (uint32_t)timer_top(t) + 1;
+    uint64_t     ticks;
+
+    if (!timer_running(t))
+    {
+        t->next_tick = now + tick;
+        return;
+    }
+    if (t->next_tick > now)
+    {
+        return;
+    }
+
+    ticks         = 1 + (now - t->next_tick) / tick;
+    t->next_tick += ticks * tick;
+
+    if (t->reg[SIM_TAR] >= length)
+    {
+        t->reg[SIM_TAR] = (uint16_t)((ticks - 1) % length);
+    }
+    else
+    {
+        t->reg[SIM_TAR] = (uint16_t)((t->reg[SIM_TAR] + ticks) % length);
+    }
+    timer_count(t, timer);
+}   /* timer_advance() */
+
+/******************************************************************************/
+// eUSCI_A UART
+
+/*!
+* @brief Gets the UART number from its base address.
+* @param[in] base EUSCI_A0_BASE or EUSCI_A1_BASE.
+* @return The UART 0-1.
+*/
+uint8_t
+periph_uart_index (uint16_t base)
+{
+    return (uint8_t)((base - EUSCI_A0_BASE) >> 5);
+}   /* periph_uart_index() */
+
+/*!
+* @brief Gets the time one character takes on the wire.
+*
+* @par
+* Only the prescaler is used, the modulation stages change the baud rate by
+* a few percent at most.
+*/
+static sim_time_t
+uart_byte_time (const sim_uart_t *u)
+{
+    uint32_t hz     = ((u->ctlw0 & UCSSEL_3) == EUSCI_A_UART_CLOCKSOURCE_ACLK) ? periph_clocks.aclk : periph_clocks.smclk;
+    uint32_t bits   = 10 + ((u->ctlw0 & UCPEN) ? 1 : 0) + ((u->ctlw0 & UCSPB) ? 1 : 0);
+    uint32_t cycles = u->brw * ((u->mctlw & UCOS16) ? 16 : 1);
+
+    if (0 == cycles)
+    {
+        cycles = 1;
+    }
+    return (SIM_HZ / hz) * cycles * bits;
+}   /* uart_byte_time() */
+
+/*!
+* @brief Writes TXBUF.
+* @param[in] uart The UART 0-1.
+* @param[in] byte The byte to transmit.
+*/
+void
+periph_uart_write (uint8_t uart, uint8_t byte)
+{
+    sim_uart_t *u = &periph_uarts[uart];
+
+    u->ifg &= ~(UCTXIFG | UCTXCPTIFG);
+    if (u->ctlw0 & UCSWRST)
+    {
+        return;
+    }
+
+    if (!u->tx_active)
+    {
+        // Straight into the shift register, TXBUF is free again
+        u->tx_shift     = byte;
+        u->tx_active    = 1;
+        u->tx_done      = sim_now() + uart_byte_time(u);
+        u->ifg         |= UCTXIFG;
+    }
+    else
+    {
+        u->txbuf    = byte;
+        u->tx_full  = 1;
+    }
+}   /* periph_uart_write() */
+
+/*!
+* @brief Starts sending a byte to the firmware from the other end of the line.
+* @param[in] uart The UART 0-1.
+* @param[in] byte The byte to receive.
+*
+* @par
+* Bytes are queued and arrive back to back, one character time apart.
+*/
+void
+periph_uart_receive (uint8_t uart, uint8_t byte)
+{
+    sim_uart_t *u = &periph_uarts[uart];
+
+    if ((uint16_t)(u->rx_head - u->rx_tail) >= PERIPH_RX_FIFO)
+    {
+        return;
+    }
+
+    u->rx_fifo[u->rx_head++ % PERIPH_RX_FIFO] = byte;
+    if (!u->rx_done)
+    {
+        u->rx_done = sim_now() + uart_byte_time(u);
+    }
+}   /* periph_uart_receive() */
+
+/*!
+* @brief Finishes any characters due by a time.
+*/
+static void
+uart_advance (uint8_t uart, sim_time_t now)
+{
+    sim_uart_t *u = &periph_uarts[uart];
+    uint8_t     byte;
+
+    while (u->tx_active && (u->tx_done <= now))
+    {
+        byte = u->tx_shift;
+        if (u->tx_full)
+        {
+            u->tx_shift     = (uint8_t)u->txbuf;
+            u->tx_full      = 0;
+            u->tx_done     += uart_byte_time(u);
+            u->ifg         |= UCTXIFG;
+        }
+        else
+        {
+            u->tx_active    = 0;
+            u->ifg         |= UCTXCPTIFG;
+        }
+        if (periph_uart_transmit)
+        {
+            periph_uart_transmit(uart, byte);
+        }
+    }
+
+    while (u->rx_done && (u->rx_done <= now))
+    {
+        if (!(u->ctlw0 & UCSWRST))
+        {
+            if (u->ifg & UCRXIFG)
+            {
+                u->rx_overruns++;
+            }
+            u->rxbuf    = u->rx_fifo[u->rx_tail % PERIPH_RX_FIFO];
+            u->ifg     |= UCRXIFG;
+        }
+        u->rx_tail++;
+        u->rx_done = (u->rx_head != u->rx_tail) ? u->rx_done + uart_byte_time(u) : 0;
+    }
+}   /* uart_advance() */
+
+/******************************************************************************/
+// Reset and watchdog
+
+/*!
+* @brief Puts every register back to its reset state, as a PUC does.
+* @param[in] cause The SYSRSTIV value to report for it.
+*
+* @par
+* Whatever drives the pins from outside keeps doing so, and characters on
+* their way in keep coming, though the UART ignores them until it is set up
+* again. Timer outputs fall low and a character being sent is cut off.
+*/
+void
+periph_reset (uint16_t cause)
+{
+    uint8_t i;
+    uint8_t n;
+
+    for (i = 0; i < PERIPH_PORTS; i++)
+    {
+        memset(periph_ports[i].reg, 0, sizeof(periph_ports[i].reg));
+        periph_port_update(i);
+    }
+
+    for (i = 0; i < PERIPH_TIMERS; i++)
+    {
+        for (n = 0; n < 3; n++)
+        {
+            timer_output(&periph_timers[i], i, n, 0);
+        }
+        memset(periph_timers[i].reg, 0, sizeof(periph_timers[i].reg));
+        periph_timers[i].next_tick = 0;
+    }
+
+    for (i = 0; i < PERIPH_UARTS; i++)
+    {
+        sim_uart_t *u = &periph_uarts[i];
+
+        u->ctlw0        = UCSWRST;
+        u->brw          = 0;
+        u->mctlw        = 0;
+        u->ie           = 0;
+        u->ifg          = UCTXIFG;
+        u->tx_active    = 0;
+        u->tx_full      = 0;
+    }
+
+    // DCO at 1MHz feeds MCLK and SMCLK, REFO feeds ACLK
+    periph_clocks.dcoclkdiv = 1000000;
+    periph_clocks.refoclk   = 32768;
+    periph_clocks.mclk_div  = 0;
+    periph_clocks.smclk_div = 0;
+    periph_clocks_update();
+    periph_crc = 0xFFFF;
+
+    // The watchdog comes out of reset running from SMCLK, 32ms at 1MHz,
+    // until main() holds it. Nothing before main() takes simulated time, so
+    // here it starts out held
+    periph_wdt.ctl = WDTHOLD | WDT_A_CLOCKSOURCE_SMCLK | WDT_A_CLOCKDIVIDER_32K;
+    periph_wdt_clear();
+
+    reset_causes |= 1u << (cause >> 1);
+}   /* periph_reset() */
+
+/*!
+* @brief Takes the highest priority reset cause not read yet, as reading
+* SYSRSTIV does.
+* @return The cause, SYSRSTIV_NONE once all are read.
+*/
+uint16_t
+periph_reset_cause (void)
+{
+    uint8_t n;
+
+    for (n = 1; n < 32; n++)
+    {
+        if (reset_causes & (1u << n))
+        {
+            reset_causes &= ~(1u << n);
+            return 2 * n;
+        }
+    }
+    return SYSRSTIV_NONE;
+}   /* periph_reset_cause() */
+
+/*!
+* @brief Starts the watchdog count again from zero.
+*/
+void
+periph_wdt_clear (void)
+{
+    static const uint8_t bits[8] = { 31, 27, 23, 19, 15, 13, 9, 6 };
+    uint32_t             hz;
+
+    switch (periph_wdt.ctl & WDTSSEL_3)
+    {
+    case WDT_A_CLOCKSOURCE_SMCLK:
+        hz = periph_clocks.smclk;
+        break;
+
+    case WDT_A_CLOCKSOURCE_ACLK:
+        hz = periph_clocks.aclk;
+        break;
+
+    case WDT_A_CLOCKSOURCE_VLOCLK:
+        hz = 10000;
+        break;
+
+    default:
+        // Nothing is connected to XCLK
+        periph_wdt.expiry = UINT64_MAX;
+        return;
+    }
+
+    periph_wdt.expiry = sim_now() + (SIM_HZ / hz) * ((sim_time_t)1 << bits[periph_wdt.ctl & WDTIS_7]);
+}   /* periph_wdt_clear() */
+
+/*!
+* @brief Checks whether the watchdog has run out and should reset the MCU.
+*/
+uint8_t
+periph_wdt_expired (void)
+{
+    return !(periph_wdt.ctl & WDTHOLD) && (sim_now() >= periph_wdt.expiry);
+}   /* periph_wdt_expired() */
+
+/******************************************************************************/
+// Events and interrupts
+
+/*!
+* @brief Finds when the next peripheral event happens.
+* @param[in] now The current time.
+* @return The time of the next event, or UINT64_MAX if nothing is running.
+*/
+sim_time_t
+periph_next_event (sim_time_t now)
+{
+    sim_time_t  next = UINT64_MAX;
+    sim_time_t  time;
+    uint8_t     i;
+
+    for (i = 0; i < PERIPH_TIMERS; i++)
+    {
+        sim_timer_t *t = &periph_timers[i];
+
+        if (timer_running(t))
+        {
+            time = t->next_tick + (timer_ticks_to_event(t) - 1) * timer_tick(t);
+            if (time < now)
+            {
+                time = now;
+            }
+            if (time < next)
+            {
+                next = time;
+            }
+        }
+    }
+
+    for (i = 0; i < PERIPH_UARTS; i++)
+    {
+        sim_uart_t *u = &periph_uarts[i];
+
+        if (u->tx_active && (u->tx_done < next))
+        {
+            next = u->tx_done;
+        }
+        if (u->rx_done && (u->rx_done < next))
+        {
+            next = u->rx_done;
+        }
+    }
+
+    if (!(periph_wdt.ctl & WDTHOLD) && (periph_wdt.expiry < next))
+    {
+        next = (periph_wdt.expiry > now) ? periph_wdt.expiry : now;
+    }
+
+    return next;
+}   /* periph_next_event() */
+
+/*!
+* @brief Moves every peripheral to a time no later than periph_next_event().
+* @param[in] now The new time.
+*/
+void
+periph_advance (sim_time_t now)
+{
+    uint8_t i;
+
+    for (i = 0; i < PERIPH_TIMERS; i++)
+    {
+        timer_advance(i, now);
+    }
+    for (i = 0; i < PERIPH_UARTS; i++)
+    {
+        uart_advance(i, now);
+    }
+}   /* periph_advance() */
+
+/*!
+* @brief Finds the highest priority interrupt that is flagged and enabled.
+* @return The vector, or VECTOR_NONE.
+*/
+vector_t
+periph_pending (void)
+{
+    uint8_t i;
+    uint8_t n;
+
+    for (i = 0; i < PERIPH_TIMERS; i++)
+    {
+        sim_timer_t *t = &periph_timers[i];
+
+        if ((t->reg[SIM_TACCTL0] & CCIE) && (t->reg[SIM_TACCTL0] & CCIFG))
+        {
+            return (vector_t)(VECTOR_TIMER0_A0 + 2 * i);
+        }
+        if ((t->reg[SIM_TACTL] & TAIE) && (t->reg[SIM_TACTL] & TAIFG))
+        {
+            return (vector_t)(VECTOR_TIMER0_A1 + 2 * i);
+        }
+        for (n = 1; n < 3; n++)
+        {
+            if ((t->reg[SIM_TACCTL0 + n] & CCIE) && (t->reg[SIM_TACCTL0 + n] & CCIFG))
+            {
+                return (vector_t)(VECTOR_TIMER0_A1 + 2 * i);
+            }
+        }
+    }
+
+    for (i = 0; i < PERIPH_UARTS; i++)
+    {
+        if (periph_uarts[i].ie & periph_uarts[i].ifg & (UCRXIFG | UCTXIFG | UCSTTIFG | UCTXCPTIFG))
+        {
+            return (vector_t)(VECTOR_USCI_A0 + i);
+        }
+    }
+
+    for (i = 1; i <= 2; i++)
+    {
+        if (periph_ports[i].reg[SIM_PIE] & periph_ports[i].reg[SIM_PIFG])
+        {
+            return (vector_t)(VECTOR_PORT1 + i - 1);
+        }
+    }
+
+    return VECTOR_NONE;
+}   /* periph_pending() */
+
+/*!
+* @brief Does what the hardware does when it starts an ISR. Only CCR0 flags
+* are cleared automatically.
+* @param[in] vector The vector being serviced.
+*/
+void
+periph_acknowledge (vector_t vector)
+{
+    if ((vector <= VECTOR_TIMER3_A1) && !((vector - VECTOR_TIMER0_A0) & 1))
+    {
+        periph_timers[(vector - VECTOR_TIMER0_A0) >> 1].reg[SIM_TACCTL0] &= ~CCIFG;
+    }
+}   /* periph_acknowledge() */
+
+/*** end of file ***/
@@ -0,0 +1,132 @@
+/******************************************************************************/
+
+/** @file periph.h
+*
+* @brief Simulated peripherals of the MSP430FR2433: GPIO ports, Timer_A,
+* eUSCI_A UART, CRC, the clock system, the watchdog and the reset causes.
+*
+* @par
+* Register state is shared with driverlib.c, which implements the DriverLib
+* calls on top of it. Everything here must be used with sim_lock() held.
+*/
+
+#ifndef PERIPH_H
+#define PERIPH_H
+
+#include <stdint.h>
+#include "sim.h"
+
+#define PERIPH_PORTS            4   // P1-P3, index 0 unused
+#define PERIPH_TIMERS           4
+#define PERIPH_UARTS            2
+#define PERIPH_RX_FIFO          256
+
+// Interrupt vectors from highest to lowest priority
+typedef enum
+{
+    VECTOR_TIMER0_A0,
+    VECTOR_TIMER0_A1,
+    VECTOR_TIMER1_A0,
+    VECTOR_TIMER1_A1,
+    VECTOR_TIMER2_A0,
+    VECTOR_TIMER2_A1,
+    VECTOR_TIMER3_A0,
+    VECTOR_TIMER3_A1,
+    VECTOR_USCI_A0,
+    VECTOR_USCI_A1,
+    VECTOR_PORT1,
+    VECTOR_PORT2,
+    VECTOR_COUNT,
+    VECTOR_NONE = VECTOR_COUNT
+} vector_t;
+
+typedef struct
+{
+    uint8_t     reg[SIM_PORT_REGS];
+    uint8_t     ext;                // Level driven onto the pins from outside
+    uint8_t     driven;             // Pins with something driving them from outside
+} sim_port_t;
+
+typedef struct
+{
+    uint16_t    reg[SIM_TIMER_REGS];
+    uint8_t     out[3];             // Output unit levels
+    sim_time_t  next_tick;          // When TAR next counts
+} sim_timer_t;
+
+typedef struct
+{
+    uint16_t    ctlw0;
+    uint16_t    brw;
+    uint16_t    mctlw;
+    uint16_t    ie;
+    uint16_t    ifg;
+    uint16_t    rxbuf;
+    uint16_t    txbuf;
+    uint8_t     tx_shift;
+    uint8_t     tx_active;          // Shift register busy
+    uint8_t     tx_full;            // TXBUF waiting for the shift register
+    sim_time_t  tx_done;
+    uint8_t     rx_fifo[PERIPH_RX_FIFO];
+    uint16_t    rx_head;
+    uint16_t    rx_tail;
+    sim_time_t  rx_done;            // When the byte on the wire finishes, 0 if idle
+    uint32_t    rx_overruns;
+} sim_uart_t;
+
+typedef struct
+{
+    uint32_t    dcoclkdiv;
+    uint32_t    refoclk;
+    uint8_t     mclk_div;
+    uint8_t     smclk_div;
+    uint32_t    mclk;
+    uint32_t    smclk;
+    uint32_t    aclk;
+} sim_clocks_t;
+
+typedef struct
+{
+    uint16_t    ctl;                // WDTHOLD, WDTSSEL and WDTIS
+    sim_time_t  expiry;             // When the count runs out, unless held
+} sim_wdt_t;
+
+extern sim_port_t      periph_ports[PERIPH_PORTS];
+extern sim_timer_t     periph_timers[PERIPH_TIMERS];
+extern sim_uart_t      periph_uarts[PERIPH_UARTS];
+extern sim_clocks_t    periph_clocks;
+extern uint16_t        periph_crc;
+extern sim_wdt_t       periph_wdt;
+
+// Called with each change of a timer output unit, e.g. the stepper step pin
+extern void (*periph_timer_output)(uint8_t timer, uint8_t ccr, uint8_t level);
+
+// Called with each byte the firmware finishes transmitting
+extern void (*periph_uart_transmit)(uint8_t uart, uint8_t byte);
+
+void periph_init(void);
+sim_time_t periph_next_event(sim_time_t now);
+void periph_advance(sim_time_t now);
+vector_t periph_pending(void);
+void periph_acknowledge(vector_t vector);
+
+void periph_port_update(uint8_t port);
+void periph_port_drive(uint8_t port, uint8_t pins, uint8_t level);
+
+uint8_t periph_timer_index(uint16_t base);
+void periph_timer_restart(uint8_t timer);
+
+uint8_t periph_uart_index(uint16_t base);
+void periph_uart_write(uint8_t uart, uint8_t byte);
+void periph_uart_receive(uint8_t uart, uint8_t byte);
+
+void periph_clocks_update(void);
+
+void periph_reset(uint16_t cause);
+uint16_t periph_reset_cause(void);
+void periph_wdt_clear(void);
+uint8_t periph_wdt_expired(void);
+
+#endif /* PERIPH_H */
+
+/*** end of file ***/
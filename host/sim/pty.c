@@ -0,0 +1,164 @@
+/******************************************************************************/
+
+/** @file pty.c
+*
+* @brief Connects the simulated robot's UART to a pseudo terminal, so a real
+* host program can talk to it the way it would over the serial port.
+*
+* @par
+* Bytes written to the terminal are fed to UART1 as they arrive, one
+* character time apart, and everything the firmware sends is written back.
+* The terminal is raw, so nothing is translated on the way. The slave side
+* is kept open here as well, so the master doesn't see a hang up between
+* one host program closing it and the next opening it.
+*
+* @par
+* There is no scripted host or human on this side, and the simulation keeps
+* pace with the wall clock even while the firmware sleeps, so the host's
+* timeouts mean what they do against a robot.
+*/
+
+#define _GNU_SOURCE
+
+// Includes
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+#include "periph.h"
+#include "pty.h"
+
+#define PTY_UART                1
+#define POLL_PERIOD             SIM_MS(1)
+
+// Local variables
+static int          master      = -1;
+static int          slave       = -1;
+static const char  *link_path   = 0;
+
+/*!
+* @brief Removes the link to the terminal when the simulation exits.
+*/
+static void
+pty_unlink (void)
+{
+    if (link_path)
+    {
+        unlink(link_path);
+    }
+}   /* pty_unlink() */
+
+/*!
+* @brief Removes the link and exits when the simulation is told to stop.
+*/
+static void
+pty_stop (int signal)
+{
+    (void)signal;
+    pty_unlink();
+    _exit(0);
+}   /* pty_stop() */
+
+/*!
+* @brief Writes a byte the firmware sent to the terminal.
+*/
+static void
+pty_transmit (uint8_t uart, uint8_t byte)
+{
+    if (PTY_UART != uart)
+    {
+        return;
+    }
+    if ((write(master, &byte, 1) != 1) && sim_verbose)
+    {
+        sim_log("pty: dropped 0x%02X, %s", byte, strerror(errno));
+    }
+}   /* pty_transmit() */
+
+/*!
+* @brief Feeds whatever the host has written to the UART, as far as the
+* receive FIFO has room.
+*/
+static void
+pty_poll (void *arg)
+{
+    sim_uart_t *u    = &periph_uarts[PTY_UART];
+    uint8_t     buffer[64];
+    size_t      room = PERIPH_RX_FIFO - (uint16_t)(u->rx_head - u->rx_tail);
+    ssize_t     count;
+    ssize_t     i;
+
+    if (room > sizeof(buffer))
+    {
+        room = sizeof(buffer);
+    }
+    count = room ? read(master, buffer, room) : 0;
+    for (i = 0; i < count; i++)
+    {
+        if (sim_verbose)
+        {
+            sim_log("pty: received 0x%02X", buffer[i]);
+        }
+        periph_uart_receive(PTY_UART, buffer[i]);
+    }
+    sim_schedule(POLL_PERIOD, pty_poll, 0);
+}   /* pty_poll() */
+
+/*!
+* @brief Opens the terminal and connects it to the robot's UART.
+* @param[in] path Where to link the terminal's slave device, or 0 to only
+* print its name.
+*/
+void
+pty_init (const char *path)
+{
+    struct termios   settings;
+    struct sigaction action = {0};
+    const char      *name;
+
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if ((master < 0) || grantpt(master) || unlockpt(master) || !(name = ptsname(master)))
+    {
+        perror("pty: cannot open a pseudo terminal");
+        exit(2);
+    }
+    slave = open(name, O_RDWR | O_NOCTTY);
+    if ((slave < 0) || tcgetattr(slave, &settings))
+    {
+        perror("pty: cannot open the slave side");
+        exit(2);
+    }
+    cfmakeraw(&settings);
+    cfsetispeed(&settings, B115200);
+    cfsetospeed(&settings, B115200);
+    tcsetattr(slave, TCSANOW, &settings);
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+    if (path)
+    {
+        unlink(path);
+        if (symlink(name, path))
+        {
+            perror("pty: cannot link the terminal");
+            exit(2);
+        }
+        link_path = path;
+        atexit(pty_unlink);
+        action.sa_handler = pty_stop;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGTERM, &action, 0);
+        sigaction(SIGINT, &action, 0);
+    }
+    printf("connect4_sim: robot on %s\n", path ? path : name);
+    fflush(stdout);
+
+    periph_uart_transmit = pty_transmit;
+    sim_schedule(POLL_PERIOD, pty_poll, 0);
+}   /* pty_init() */
+
+/*** end of file ***/
@@ -0,0 +1,15 @@
+/******************************************************************************/
+
+/** @file pty.h
+*
+* @brief Connects the simulated robot's UART to a pseudo terminal.
+*/
+
+#ifndef PTY_H
+#define PTY_H
+
+void pty_init(const char *path);
+
+#endif /* PTY_H */
+
+/*** end of file ***/
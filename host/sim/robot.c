@@ -0,0 +1,386 @@
+/******************************************************************************/
+
+/** @file robot.c
+*
+* @brief Simulated mechanics around the firmware.
+*
+* @par
+* The carriage moves one step on each rising edge of TA0.1 while nENABLE is
+* low, in the direction set on the DIR pin, and closes the bump switch at
+* position 0 and below. The servo follows the TA1.2 pulse width at a limited
+* slew rate. A loaded chip drops when the dispenser extends, and blocks the
+* photo-interrupter of the column it lands in on its way down. The next chip
+* only loads once the dispenser is all the way back. A chip that jams stays
+* in the dispenser until it backs off part way or someone frees it.
+*
+* @par
+* Each column can sit a random number of steps off the nominal board
+* geometry, the tolerance stack-up calibration has to find.
+*
+* @par
+* Noise, electrical pickup from the stepper driver, breaks a random clear
+* beam for a few microseconds at random times. A failed sensor reads blocked
+* or clear whatever goes past it.
+*/
+
+// Includes
+#include <stdint.h>
+#include "driverlib.h"
+#include "defines.h"
+#include "periph.h"
+#include "robot.h"
+
+// Board geometry in steps from the point where the bump switch closes
+#define BOARD_OFFSET            319
+#define COLUMN_PITCH            248
+#define COLUMN_WINDOW           60      // Steps off center a chip still lands in the column
+#define END_STOP                (-30)   // Travel past the switch before the carriage stalls
+
+// Chips
+#define DISPENSER_FALL_TIME     SIM_MS(120)     // Dispenser down to the sensors
+#define HUMAN_FALL_TIME         SIM_MS(80)      // Top of the board down to the sensors
+#define BLOCK_TIME              SIM_MS(15)      // Beam interrupted by a passing chip
+#define GLITCH_MAX_US           200             // Longest noise pulse on a beam
+
+// Servo
+#define SERVO_SLEW              4000    // Pulse width us per second, 500-2300us in 0.45s
+#define SERVO_RELEASE           600     // Chip drops below this pulse width in us
+#define SERVO_RELOAD            2200    // Next chip loads above this pulse width in us
+#define SERVO_RESEAT            1400    // A stuck chip drops back into place above this
+#define SERVO_MAX_GAP           SIM_MS(40)  // Longer gaps between pulses move nothing
+
+static const struct
+{
+    uint8_t port;
+    uint8_t pin;
+} sensors[ROBOT_COLUMNS] =
+{
+    { GPIO_PORT_P2, PHOTO1 },
+    { GPIO_PORT_P2, PHOTO2 },
+    { GPIO_PORT_P2, PHOTO3 },
+    { GPIO_PORT_P2, PHOTO4 },
+    { GPIO_PORT_P2, PHOTO5 },
+    { GPIO_PORT_P1, PHOTO6 },
+    { GPIO_PORT_P1, PHOTO7 }
+};
+
+// Local variables
+static robot_stats_t    stats;
+static uint32_t         jam_chance  = 0;    // Percent
+static int32_t          offsets[ROBOT_COLUMNS];     // Steps each column is off nominal
+static sim_time_t       pulse_start = 0;
+static sim_time_t       pulse_last  = 0;
+static int32_t          servo       = SERVO_RELOAD;    // Pulse width the servo is at in us
+static uint8_t          loaded      = 1;
+static uint8_t          jammed      = 0;
+static uint32_t         noise_rate  = 0;    // Glitches per second
+static uint8_t          chips[ROBOT_COLUMNS];   // Chips in each beam
+static uint8_t          failed      = 0;    // Sensors that have failed, bit n = column n
+
+/*!
+* @brief Interrupts a column's beam.
+*/
+static void
+beam_block (void *arg)
+{
+    if (failed & (1 << (intptr_t)arg))
+    {
+        return;
+    }
+    chips[(intptr_t)arg]++;
+    periph_port_drive(sensors[(intptr_t)arg].port, sensors[(intptr_t)arg].pin, 0);
+}   /* beam_block() */
+
+/*!
+* @brief Restores a column's beam.
+*/
+static void
+beam_clear (void *arg)
+{
+    if (failed & (1 << (intptr_t)arg))
+    {
+        return;
+    }
+    if (0 == --chips[(intptr_t)arg])
+    {
+        periph_port_drive(sensors[(intptr_t)arg].port, sensors[(intptr_t)arg].pin, 1);
+    }
+}   /* beam_clear() */
+
+/*!
+* @brief Ends a noise pulse, unless a chip has got into the beam meanwhile.
+*/
+static void
+glitch_clear (void *arg)
+{
+    if (0 == chips[(intptr_t)arg])
+    {
+        periph_port_drive(sensors[(intptr_t)arg].port, sensors[(intptr_t)arg].pin, 1);
+    }
+}   /* glitch_clear() */
+
+/*!
+* @brief Breaks a random clear beam for a moment and schedules the next pulse.
+*/
+static void
+glitch (void *arg)
+{
+    intptr_t column = sim_random(ROBOT_COLUMNS);
+
+    if ((0 == chips[column]) && !(failed & (1 << column)))
+    {
+        stats.glitches++;
+        periph_port_drive(sensors[column].port, sensors[column].pin, 0);
+        sim_schedule(SIM_US(1 + sim_random(GLITCH_MAX_US)), glitch_clear, (void *)column);
+    }
+    sim_schedule(SIM_US(1 + sim_random(2000000 / noise_rate)), glitch, 0);
+}   /* glitch() */
+
+/*!
+* @brief Sends a chip past a column's sensor.
+*/
+static void
+chip_fall (uint8_t column, sim_time_t delay)
+{
+    sim_schedule(delay, beam_block, (void *)(intptr_t)column);
+    sim_schedule(delay + BLOCK_TIME, beam_clear, (void *)(intptr_t)column);
+}   /* chip_fall() */
+
+/*!
+* @brief Gets where the carriage has to be to drop a chip into a column.
+* @param[in] column The column 0-6.
+* @return The center of the column in steps from the bump switch.
+*/
+int32_t
+robot_column_center (uint8_t column)
+{
+    return BOARD_OFFSET + COLUMN_PITCH * (ROBOT_COLUMNS - 1 - column) + offsets[column];
+}   /* robot_column_center() */
+
+/*!
+* @brief Drops the loaded chip from wherever the carriage is.
+*/
+static void
+dispenser_release (void)
+{
+    int32_t center;
+    uint8_t column;
+
+    for (column = 0; column < ROBOT_COLUMNS; column++)
+    {
+        center = robot_column_center(column);
+        if ((stats.position >= center - COLUMN_WINDOW) && (stats.position <= center + COLUMN_WINDOW))
+        {
+            stats.drops++;
+            if (sim_verbose)
+            {
+                sim_log("robot: chip dropped into column %u at %d steps", column, stats.position);
+            }
+            chip_fall(column, DISPENSER_FALL_TIME);
+            return;
+        }
+    }
+
+    stats.misses++;
+    sim_log("robot: chip dropped between columns at %d steps", stats.position);
+}   /* dispenser_release() */
+
+/*!
+* @brief Moves the servo towards a new pulse width and works the dispenser.
+*/
+static void
+servo_pulse (int32_t width)
+{
+    sim_time_t gap  = sim_now() - pulse_last;
+    int32_t    move;
+
+    pulse_last = sim_now();
+    if (gap > SERVO_MAX_GAP)
+    {
+        gap = SERVO_MAX_GAP;
+    }
+
+    move = (int32_t)(SERVO_SLEW * SIM_SECONDS(gap));
+    if (width > servo + move)
+    {
+        servo += move;
+    }
+    else if (width < servo - move)
+    {
+        servo -= move;
+    }
+    else
+    {
+        servo = width;
+    }
+
+    if (loaded && (servo <= SERVO_RELEASE))
+    {
+        loaded = 0;
+        if (sim_random(100) < jam_chance)
+        {
+            // Stuck until the dispenser backs off or someone frees it
+            jammed = 1;
+            stats.jams++;
+            sim_log("robot: chip jammed in the dispenser");
+        }
+        else
+        {
+            dispenser_release();
+        }
+    }
+    else if (jammed && (servo >= SERVO_RESEAT))
+    {
+        loaded = 1;
+        jammed = 0;
+    }
+    else if (!loaded && (servo >= SERVO_RELOAD))
+    {
+        loaded = 1;
+    }
+}   /* servo_pulse() */
+
+/*!
+* @brief Takes one step if the driver is enabled.
+*/
+static void
+carriage_step (void)
+{
+    sim_port_t *p1 = &periph_ports[GPIO_PORT_P1];
+    sim_port_t *p3 = &periph_ports[GPIO_PORT_P3];
+
+    if (!(p3->reg[SIM_PDIR] & NENABLE_PIN) || (p3->reg[SIM_POUT] & NENABLE_PIN))
+    {
+        return;
+    }
+
+    stats.steps++;
+    stats.position += (p1->reg[SIM_POUT] & DIR_PIN) ? 1 : -1;
+    if (stats.position < END_STOP)
+    {
+        stats.position = END_STOP;
+        stats.stalls++;
+    }
+
+    periph_port_drive(GPIO_PORT_P3, BUMP_PIN, stats.position > 0);
+}   /* carriage_step() */
+
+/*!
+* @brief Watches the timer outputs wired to the stepper driver and servo.
+*/
+static void
+timer_output (uint8_t timer, uint8_t ccr, uint8_t level)
+{
+    if ((0 == timer) && (1 == ccr) && level)
+    {
+        carriage_step();
+    }
+    else if ((1 == timer) && (2 == ccr))
+    {
+        if (level)
+        {
+            pulse_start = sim_now();
+        }
+        else
+        {
+            servo_pulse((int32_t)((sim_now() - pulse_start) / SIM_US(1)));
+        }
+    }
+}   /* timer_output() */
+
+/*!
+* @brief Sets up the mechanics.
+* @param[in] position Where the carriage starts, in steps from the bump switch.
+* @param[in] jam_percent The chance of a chip sticking in the dispenser.
+* @param[in] tolerance Most steps a column can be off the nominal geometry.
+* @param[in] noise Glitches per second on the beams, on average.
+*/
+void
+robot_init (int32_t position, uint32_t jam_percent, uint32_t tolerance, uint32_t noise)
+{
+    uint8_t column;
+
+    stats.position  = position;
+    jam_chance      = jam_percent;
+    noise_rate      = noise;
+    for (column = 0; column < ROBOT_COLUMNS; column++)
+    {
+        offsets[column] = (int32_t)sim_random(2 * tolerance + 1) - (int32_t)tolerance;
+    }
+
+    periph_port_drive(GPIO_PORT_P3, BUMP_PIN, stats.position > 0);
+    for (column = 0; column < ROBOT_COLUMNS; column++)
+    {
+        periph_port_drive(sensors[column].port, sensors[column].pin, 1);
+    }
+
+    periph_timer_output = timer_output;
+    if (noise_rate)
+    {
+        sim_schedule(SIM_US(1 + sim_random(2000000 / noise_rate)), glitch, 0);
+    }
+}   /* robot_init() */
+
+/*!
+* @brief Has the human drop a chip into a column.
+* @param[in] column The column 0-6.
+*/
+void
+robot_human_drop (uint8_t column)
+{
+    chip_fall(column, HUMAN_FALL_TIME);
+}   /* robot_human_drop() */
+
+/*!
+* @brief Has someone free a chip stuck in the dispenser, letting it fall
+* from wherever the carriage is.
+* @return 1 if a chip was stuck, 0 if there was nothing to clear.
+*/
+uint8_t
+robot_clear_jam (void)
+{
+    if (!jammed)
+    {
+        return 0;
+    }
+    jammed = 0;
+    if (sim_verbose)
+    {
+        sim_log("robot: jammed chip cleared by hand");
+    }
+    dispenser_release();
+    return 1;
+}   /* robot_clear_jam() */
+
+/*!
+* @brief Fails a column's sensor.
+* @param[in] column The column 0-6.
+* @param[in] blocked 1 to have it read blocked, 0 to have it read clear.
+*/
+void
+robot_fail_sensor (uint8_t column, uint8_t blocked)
+{
+    failed |= 1 << column;
+    periph_port_drive(sensors[column].port, sensors[column].pin, !blocked);
+}   /* robot_fail_sensor() */
+
+/*!
+* @brief Gets the sensors that have failed.
+* @return Bit n = column n.
+*/
+uint8_t
+robot_failed_sensors (void)
+{
+    return failed;
+}   /* robot_failed_sensors() */
+
+/*!
+* @brief Gets the mechanics counters.
+*/
+const robot_stats_t *
+robot_stats (void)
+{
+    return &stats;
+}   /* robot_stats() */
+
+/*** end of file ***/
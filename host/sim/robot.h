@@ -0,0 +1,37 @@
+/******************************************************************************/
+
+/** @file robot.h
+*
+* @brief Simulated mechanics around the firmware: the carriage and bump switch,
+* the chip dispenser servo and the photo-interrupters over the columns.
+*/
+
+#ifndef ROBOT_H
+#define ROBOT_H
+
+#include <stdint.h>
+
+#define ROBOT_COLUMNS           7
+
+typedef struct
+{
+    int32_t     position;       // Carriage steps from the bump switch
+    uint32_t    steps;          // Steps taken
+    uint32_t    stalls;         // Steps lost against the end stop
+    uint32_t    drops;          // Chips dropped into a column
+    uint32_t    misses;         // Chips dropped between columns
+    uint32_t    jams;           // Chips stuck in the dispenser
+    uint32_t    glitches;       // Noise pulses on the beams
+} robot_stats_t;
+
+void robot_init(int32_t position, uint32_t jam_percent, uint32_t tolerance, uint32_t noise);
+int32_t robot_column_center(uint8_t column);
+void robot_human_drop(uint8_t column);
+uint8_t robot_clear_jam(void);
+void robot_fail_sensor(uint8_t column, uint8_t blocked);
+uint8_t robot_failed_sensors(void);
+const robot_stats_t *robot_stats(void);
+
+#endif /* ROBOT_H */
+
+/*** end of file ***/
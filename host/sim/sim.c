@@ -0,0 +1,860 @@
+/******************************************************************************/
+
+/** @file sim.c
+*
+* @brief Simulated MSP430FR2433 core: simulated time, interrupt dispatch, the
+* status register intrinsics, scheduled events and resets.
+*
+* @par
+* ISRs run on the simulation thread. As on the real core the firmware must
+* not run alongside them, so while it is awake it is stopped with SIGUSR1
+* for as long as they take. A firmware thread inside sim_lock() stops once it
+* lets go, so an ISR never waits on peripheral state held by a stopped thread.
+*
+* @par
+* When the watchdog runs out the firmware thread is sent SIGUSR2 and starts
+* over from sim_run(), with the firmware's RAM as it was at power up and its
+* FRAM as it was left, see firmware.ld.in. Inside the simulation, e.g. holding
+* sim_lock() or asleep, it finishes what it is doing first, so the reset
+* never leaves a mutex held.
+*
+* @par
+* While the firmware is awake simulated time keeps pace with the CPU time
+* the firmware thread gets, or with the wall clock for a host that runs on
+* it, so a firmware thread the OS leaves waiting does not see time run on.
+*/
+
+#define _GNU_SOURCE
+
+// Includes
+#include <stdint.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <errno.h>
+#include <setjmp.h>
+#include <string.h>
+#include <time.h>
+#include "driverlib.h"
+#include "periph.h"
+
+#define MAX_EVENTS          64
+#define AWAKE_STEP          SIM_US(100)     // Longest step while the firmware runs
+#define ASLEEP_STEP         SIM_MS(10)      // Longest step while the firmware sleeps
+#define PACE_SLACK_NS       1000000         // Time the simulation may get ahead of run_ns() by
+#define PACE_RESYNC_NS      50000000        // Time behind before giving up catching up
+#define PACE_SLACK          SIM_MS(1)       // The same in simulated time, when sped up
+#define PACE_RESYNC         SIM_MS(10)
+#define STORM_LIMIT         100000          // ISRs in a row without time passing
+
+// The firmware's RAM, placed by firmware.ld.in
+extern char firmware_ram_start[];
+extern char firmware_ram_end[];
+
+// ISRs are found by name, eUSCI_A goes to uart_isr() whichever UART is in use
+#define ISR(name) extern void name(void) __attribute__((weak));
+ISR(timer0_a0_isr) ISR(timer0_a1_isr) ISR(timer1_a0_isr) ISR(timer1_a1_isr)
+ISR(timer2_a0_isr) ISR(timer2_a1_isr) ISR(timer3_a0_isr) ISR(timer3_a1_isr)
+ISR(uart_isr) ISR(port1_isr) ISR(port2_isr)
+#undef ISR
+
+typedef struct
+{
+    sim_time_t  time;
+    sim_event_t event;
+    void       *arg;
+} event_t;
+
+static const char *const vector_names[VECTOR_COUNT] =
+{
+    "TIMER0_A0", "TIMER0_A1", "TIMER1_A0", "TIMER1_A1",
+    "TIMER2_A0", "TIMER2_A1", "TIMER3_A0", "TIMER3_A1",
+    "USCI_A0", "USCI_A1", "PORT1", "PORT2"
+};
+
+// Local variables
+static void               (*vectors[VECTOR_COUNT])(void);
+static pthread_mutex_t      lock        = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;  // Peripheral state
+static pthread_mutex_t      cpu         = PTHREAD_MUTEX_INITIALIZER;    // Held by the firmware while GIE is clear
+static pthread_cond_t       wake        = PTHREAD_COND_INITIALIZER;
+static pthread_t            thread;
+static pthread_t            firmware;
+static sem_t                stopped;                                    // Firmware has stopped for ISRs
+static sem_t                resume;                                     // ISRs are done
+static sem_t                rebooted;                                   // Firmware has reset
+static sigjmp_buf           boot;                                       // Where sim_run() calls the firmware
+static char                *ram_image   = 0;                            // Firmware RAM at power up
+static _Thread_local int    in_isr      = 0;
+static _Thread_local int    lock_depth  = 0;
+static _Thread_local int    on_firmware = 0;
+static _Thread_local volatile sig_atomic_t in_sim = 0;                  // Firmware inside the simulation
+static _Thread_local volatile sig_atomic_t stop_deferred = 0;
+static atomic_int           resetting   = 0;
+static atomic_int           hang        = 0;                            // Firmware hangs at its next wake
+static uint32_t             resets      = 0;
+static atomic_int           gie         = 0;
+static atomic_ushort        sleep_bits  = 0;                            // CPUOFF, OSCOFF, SCG0 and SCG1
+static _Atomic sim_time_t   now         = 0;
+static sim_time_t           asleep[2]   = {0};                          // Time spent in LPM0, LPM3
+static event_t              events[MAX_EVENTS];
+static int                  num_events  = 0;
+static double               speed       = 1.0;
+static int64_t              slack_ns    = PACE_SLACK_NS;
+static int64_t              resync_ns   = PACE_RESYNC_NS;
+static uint8_t              paced       = 0;                            // Keep pace while asleep too
+static clockid_t            firmware_clock;                             // CPU time of the firmware thread
+static uint32_t             random_state = 1;
+
+int sim_verbose = 0;
+
+/*!
+* @brief Gets the wall clock time.
+* @return The time in ns.
+*/
+static int64_t
+wall_ns (void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}   /* wall_ns() */
+
+/*!
+* @brief Gets the clock that simulated time keeps pace with while the
+* firmware runs: the wall clock when paced, else the firmware's CPU time.
+* @return The time in ns.
+*/
+static int64_t
+run_ns (void)
+{
+    struct timespec ts;
+
+    if (paced)
+    {
+        return wall_ns();
+    }
+    clock_gettime(firmware_clock, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}   /* run_ns() */
+
+/*!
+* @brief Prints a message stamped with the simulated time.
+*/
+void
+sim_log (const char *format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    printf("[%11.6f] ", SIM_SECONDS(now));
+    vprintf(format, args);
+    printf("\n");
+    va_end(args);
+}   /* sim_log() */
+
+/*!
+* @brief Ends the simulation.
+* @param[in] status The process exit status.
+*/
+void
+sim_exit (int status)
+{
+    fflush(stdout);
+    exit(status);
+}   /* sim_exit() */
+
+/*!
+* @brief Resets the firmware. Runs on the firmware thread, outside the
+* simulation, and doesn't return.
+*
+* @par
+* Outside the simulation the firmware holds the CPU mutex exactly while GIE
+* is clear, and the reset leaves it held with GIE clear.
+*/
+static void
+firmware_reset (void)
+{
+    in_sim++;
+    if (gie)
+    {
+        pthread_mutex_lock(&cpu);
+    }
+    gie         = 0;
+    sleep_bits  = 0;
+
+    pthread_mutex_lock(&lock);
+    memcpy(firmware_ram_start, ram_image, firmware_ram_end - firmware_ram_start);
+    periph_reset(SYSRSTIV_WDTTO);
+    pthread_mutex_unlock(&lock);
+
+    lock_depth      = 0;
+    stop_deferred   = 0;
+    in_sim          = 0;
+    resets++;
+    resetting       = 0;
+    sem_post(&rebooted);
+    siglongjmp(boot, 1);
+}   /* firmware_reset() */
+
+/*!
+* @brief Marks the firmware thread as inside the simulation, where a reset
+* has to wait.
+*/
+static void
+sim_enter (void)
+{
+    if (on_firmware)
+    {
+        in_sim++;
+    }
+}   /* sim_enter() */
+
+/*!
+* @brief Marks the firmware thread as leaving the simulation, and resets it
+* if the watchdog ran out meanwhile.
+*/
+static void
+sim_leave (void)
+{
+    if (on_firmware && (0 == --in_sim) && resetting)
+    {
+        firmware_reset();
+    }
+}   /* sim_leave() */
+
+/*!
+* @brief SIGUSR2 handler, runs on the firmware thread.
+*/
+static void
+reset_handler (int signal)
+{
+    int saved = errno;
+
+    (void)signal;
+    if (resetting && !in_sim)
+    {
+        firmware_reset();
+    }
+    errno = saved;
+}   /* reset_handler() */
+
+/*!
+* @brief Parks the firmware thread until the ISRs are done.
+*/
+static void
+firmware_stop (void)
+{
+    sem_post(&stopped);
+    while (sem_wait(&resume) && (EINTR == errno))
+    {
+    }
+}   /* firmware_stop() */
+
+/*!
+* @brief SIGUSR1 handler, runs on the firmware thread.
+*/
+static void
+stop_handler (int signal)
+{
+    int saved = errno;
+
+    (void)signal;
+    sim_enter();
+    if (lock_depth)
+    {
+        stop_deferred = 1;
+    }
+    else
+    {
+        firmware_stop();
+    }
+    errno = saved;
+    sim_leave();
+}   /* stop_handler() */
+
+void
+sim_lock (void)
+{
+    sim_enter();
+    lock_depth++;
+    pthread_mutex_lock(&lock);
+}
+
+void
+sim_unlock (void)
+{
+    pthread_mutex_unlock(&lock);
+    if ((0 == --lock_depth) && stop_deferred)
+    {
+        stop_deferred = 0;
+        firmware_stop();
+    }
+    sim_leave();
+}
+
+sim_time_t
+sim_now (void)
+{
+    return now;
+}
+
+uint16_t
+sim_sleep_bits (void)
+{
+    return sleep_bits;
+}
+
+/*!
+* @brief Counts the watchdog resets so far.
+*/
+uint32_t
+sim_resets (void)
+{
+    return resets;
+}   /* sim_resets() */
+
+/*!
+* @brief Makes the firmware hang, waking it if it is asleep. It spins with
+* interrupts enabled, as a stuck main loop would, until the watchdog resets it.
+*/
+void
+sim_hang (void)
+{
+    hang = 1;
+    if (0 == pthread_mutex_trylock(&cpu))
+    {
+        pthread_cond_signal(&wake);
+        pthread_mutex_unlock(&cpu);
+    }
+}   /* sim_hang() */
+
+/*!
+* @brief Gets how long the firmware has slept so far.
+* @param[out] lpm0 Time in LPM0, with SMCLK running.
+* @param[out] lpm3 Time in LPM3, with SMCLK stopped.
+*/
+void
+sim_asleep (sim_time_t *lpm0, sim_time_t *lpm3)
+{
+    *lpm0 = asleep[0];
+    *lpm3 = asleep[1];
+}   /* sim_asleep() */
+
+/*!
+* @brief Seeds sim_random() so a run can be repeated.
+* @param[in] seed Any value.
+*/
+void
+sim_seed (uint32_t seed)
+{
+    random_state = seed ? seed : 1;
+}   /* sim_seed() */
+
+/*!
+* @brief Gets a pseudo random number from a xorshift generator.
+* @param[in] range The number of possible values.
+* @return A number from 0 to range - 1.
+*/
+uint32_t
+sim_random (uint32_t range)
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return range ? random_state % range : 0;
+}   /* sim_random() */
+
+/*!
+* @brief Lets the simulation thread run while the firmware polls a flag.
+*/
+void
+sim_wait (void)
+{
+    sim_enter();
+    sched_yield();
+    sim_leave();
+}   /* sim_wait() */
+
+/*!
+* @brief Schedules a call from the simulation thread.
+* @param[in] delay How long from now.
+* @param[in] event The function to call.
+* @param[in] arg Passed to the function.
+*/
+void
+sim_schedule (sim_time_t delay, sim_event_t event, void *arg)
+{
+    sim_lock();
+    if (num_events >= MAX_EVENTS)
+    {
+        fprintf(stderr, "sim: too many scheduled events\n");
+        sim_exit(2);
+    }
+    events[num_events].time     = now + delay;
+    events[num_events].event    = event;
+    events[num_events].arg      = arg;
+    num_events++;
+    sim_unlock();
+}   /* sim_schedule() */
+
+/*!
+* @brief Gets the time of the earliest scheduled event.
+*/
+static sim_time_t
+events_next (void)
+{
+    sim_time_t next = UINT64_MAX;
+    int        i;
+
+    for (i = 0; i < num_events; i++)
+    {
+        if (events[i].time < next)
+        {
+            next = events[i].time;
+        }
+    }
+    return next;
+}   /* events_next() */
+
+/*!
+* @brief Runs every scheduled event that is due, earliest first.
+*/
+static void
+events_run (void)
+{
+    event_t due;
+    int     first;
+    int     i;
+
+    for (;;)
+    {
+        first = -1;
+        for (i = 0; i < num_events; i++)
+        {
+            if ((events[i].time <= now) && ((first < 0) || (events[i].time < events[first].time)))
+            {
+                first = i;
+            }
+        }
+        if (first < 0)
+        {
+            return;
+        }
+
+        due = events[first];
+        events[first] = events[--num_events];
+        due.event(due.arg);
+    }
+}   /* events_run() */
+
+/******************************************************************************/
+// Status register
+
+/*!
+* @brief Clears GIE, the firmware takes the CPU mutex so no ISR can run.
+*/
+void
+sim_disable_interrupt (void)
+{
+    sim_enter();
+    if (!in_isr && gie)
+    {
+        pthread_mutex_lock(&cpu);
+        gie = 0;
+    }
+    sim_leave();
+}   /* sim_disable_interrupt() */
+
+/*!
+* @brief Sets GIE, the firmware lets go of the CPU mutex.
+*/
+void
+sim_enable_interrupt (void)
+{
+    sim_enter();
+    if (!in_isr && !gie)
+    {
+        gie = 1;
+        pthread_mutex_unlock(&cpu);
+    }
+    sim_leave();
+}   /* sim_enable_interrupt() */
+
+uint16_t
+sim_get_interrupt_state (void)
+{
+    return (!in_isr && gie) ? GIE : 0;
+}
+
+void
+sim_set_interrupt_state (uint16_t state)
+{
+    if (state & GIE)
+    {
+        sim_enable_interrupt();
+    }
+    else
+    {
+        sim_disable_interrupt();
+    }
+}
+
+/*!
+* @brief Sets status register bits. With CPUOFF the firmware sleeps until an
+* ISR clears it with __bic_SR_register_on_exit(), or a reset. A hang from
+* sim_hang() stops it here for good.
+*/
+void
+sim_bis_sr (uint16_t bits)
+{
+    sim_time_t start;
+
+    if (in_isr)
+    {
+        return;
+    }
+
+    if (!(bits & CPUOFF))
+    {
+        if (bits & GIE)
+        {
+            sim_enable_interrupt();
+        }
+        return;
+    }
+
+    if (!(bits & GIE) && !gie)
+    {
+        fprintf(stderr, "sim: low power mode entered with interrupts disabled\n");
+        sim_exit(2);
+    }
+
+    sim_enter();
+    sim_disable_interrupt();
+    start       = now;
+    sleep_bits  = bits & (CPUOFF | OSCOFF | SCG0 | SCG1);
+    gie         = 1;
+    while ((sleep_bits & CPUOFF) && !resetting && !hang)
+    {
+        pthread_cond_wait(&wake, &cpu);
+    }
+    asleep[(bits & SCG1) ? 1 : 0] += now - start;
+
+    if (hang)
+    {
+        hang        = 0;
+        sleep_bits  = 0;
+        pthread_mutex_unlock(&cpu);
+        if (sim_verbose)
+        {
+            sim_log("sim: firmware hangs");
+        }
+        while (!resetting)
+        {
+            sched_yield();
+        }
+    }
+    else
+    {
+        pthread_mutex_unlock(&cpu);
+    }
+    sim_leave();
+}   /* sim_bis_sr() */
+
+void
+sim_bic_sr (uint16_t bits)
+{
+    if (bits & GIE)
+    {
+        sim_disable_interrupt();
+    }
+}
+
+/*!
+* @brief Clears bits from the status register an ISR returns to.
+*/
+void
+sim_bic_sr_on_exit (uint16_t bits)
+{
+    if (in_isr)
+    {
+        sleep_bits &= ~bits;
+    }
+}   /* sim_bic_sr_on_exit() */
+
+/*!
+* @brief Burns MCLK cycles.
+*
+* @par
+* Inside an ISR simulated time cannot move, so the delay is skipped.
+*/
+void
+sim_delay_cycles (uint32_t cycles)
+{
+    sim_time_t until = now + (SIM_HZ / periph_clocks.mclk) * cycles;
+
+    sim_enter();
+    while (!in_isr && (now < until) && !resetting)
+    {
+        sched_yield();
+    }
+    sim_leave();
+}   /* sim_delay_cycles() */
+
+/******************************************************************************/
+// Simulation thread
+
+/*!
+* @brief Runs the ISRs for every pending interrupt while GIE is set.
+*/
+static void
+dispatch (void)
+{
+    vector_t vector;
+    uint32_t storm  = 0;
+    int      halted = 0;
+
+    while (gie)
+    {
+        pthread_mutex_lock(&cpu);
+
+        sim_lock();
+        vector = periph_pending();
+        if (VECTOR_NONE != vector)
+        {
+            periph_acknowledge(vector);
+        }
+        sim_unlock();
+
+        if (VECTOR_NONE == vector)
+        {
+            pthread_mutex_unlock(&cpu);
+            break;
+        }
+        if (!vectors[vector])
+        {
+            fprintf(stderr, "sim: no ISR for %s\n", vector_names[vector]);
+            sim_exit(2);
+        }
+        if (++storm > STORM_LIMIT)
+        {
+            fprintf(stderr, "sim: %s ISR does not clear its flag\n", vector_names[vector]);
+            sim_exit(2);
+        }
+
+        // Asleep the firmware is parked on the condition variable already
+        if (!halted && !(sleep_bits & CPUOFF))
+        {
+            pthread_kill(firmware, SIGUSR1);
+            while (sem_wait(&stopped) && (EINTR == errno))
+            {
+            }
+            halted = 1;
+        }
+
+        in_isr = 1;
+        vectors[vector]();
+        in_isr = 0;
+
+        if (!(sleep_bits & CPUOFF))
+        {
+            pthread_cond_signal(&wake);
+        }
+        pthread_mutex_unlock(&cpu);
+    }
+
+    if (halted)
+    {
+        sem_post(&resume);
+    }
+}   /* dispatch() */
+
+/*!
+* @brief Resets the firmware once the watchdog has run out, waiting while it
+* finishes anything it is doing inside the simulation.
+*/
+static void
+sim_reset (void)
+{
+    if (sim_verbose)
+    {
+        sim_log("sim: watchdog reset");
+    }
+    resetting = 1;
+    pthread_kill(firmware, SIGUSR2);
+    while (sem_trywait(&rebooted))
+    {
+        // Asleep it only sees the reset once woken
+        if (0 == pthread_mutex_trylock(&cpu))
+        {
+            if (sleep_bits & CPUOFF)
+            {
+                pthread_cond_signal(&wake);
+            }
+            pthread_mutex_unlock(&cpu);
+        }
+        sched_yield();
+    }
+}   /* sim_reset() */
+
+/*!
+* @brief Advances simulated time from event to event.
+*/
+static void *
+sim_thread (void *arg)
+{
+    int64_t     run_start   = run_ns();
+    sim_time_t  sim_start   = now;
+    sim_time_t  next;
+    sim_time_t  time;
+    int64_t     ahead;
+    int         expired;
+
+    (void)arg;
+    for (;;)
+    {
+        sim_lock();
+        next = now + ((sleep_bits & CPUOFF) ? ASLEEP_STEP : AWAKE_STEP);
+
+        // An interrupt raised as the firmware went to sleep is taken at once
+        if ((sleep_bits & CPUOFF) && (VECTOR_NONE != periph_pending()))
+        {
+            next = now;
+        }
+        time = periph_next_event(now);
+        if (time < next)
+        {
+            next = time;
+        }
+        time = events_next();
+        if (time < next)
+        {
+            next = (time > now) ? time : now;
+        }
+        now = next;
+        periph_advance(now);
+        events_run();
+        expired = periph_wdt_expired();
+        sim_unlock();
+
+        if (expired)
+        {
+            sim_reset();
+            continue;
+        }
+        dispatch();
+
+        // Skip ahead while asleep, otherwise keep pace with run_ns()
+        if ((sleep_bits & CPUOFF) && !paced)
+        {
+            run_start   = run_ns();
+            sim_start   = now;
+            continue;
+        }
+        ahead = (int64_t)(SIM_SECONDS(now - sim_start) * 1e9 / speed) - (run_ns() - run_start);
+        if (ahead > slack_ns)
+        {
+            struct timespec ts = { ahead / 1000000000, ahead % 1000000000 };
+            nanosleep(&ts, 0);
+        }
+        else if (ahead < -resync_ns)
+        {
+            run_start   = run_ns();
+            sim_start   = now;
+        }
+    }
+
+    return 0;
+}   /* sim_thread() */
+
+/*!
+* @brief Starts the simulation thread. The caller goes on to sim_run().
+* @param[in] rate Simulated seconds per wall clock second while the firmware
+* is awake.
+* @param[in] always 1 to keep to rate while it sleeps as well, for a host
+* that runs on the wall clock, 0 to skip ahead.
+*
+* @par
+* The caller takes the CPU mutex first since GIE is clear out of reset.
+*/
+void
+sim_start (double rate, uint8_t always)
+{
+    struct sigaction action = {0};
+
+    vectors[VECTOR_TIMER0_A0] = timer0_a0_isr;
+    vectors[VECTOR_TIMER0_A1] = timer0_a1_isr;
+    vectors[VECTOR_TIMER1_A0] = timer1_a0_isr;
+    vectors[VECTOR_TIMER1_A1] = timer1_a1_isr;
+    vectors[VECTOR_TIMER2_A0] = timer2_a0_isr;
+    vectors[VECTOR_TIMER2_A1] = timer2_a1_isr;
+    vectors[VECTOR_TIMER3_A0] = timer3_a0_isr;
+    vectors[VECTOR_TIMER3_A1] = timer3_a1_isr;
+    vectors[VECTOR_USCI_A0]   = uart_isr;
+    vectors[VECTOR_USCI_A1]   = uart_isr;
+    vectors[VECTOR_PORT1]     = port1_isr;
+    vectors[VECTOR_PORT2]     = port2_isr;
+
+    action.sa_handler   = stop_handler;
+    action.sa_flags     = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGUSR1, &action, 0);
+    action.sa_handler   = reset_handler;
+    sigaction(SIGUSR2, &action, 0);
+    sem_init(&stopped, 0, 0);
+    sem_init(&resume, 0, 0);
+    sem_init(&rebooted, 0, 0);
+    firmware = pthread_self();
+    pthread_getcpuclockid(firmware, &firmware_clock);
+
+    ram_image = malloc(firmware_ram_end - firmware_ram_start);
+    if (!ram_image)
+    {
+        fprintf(stderr, "sim: out of memory\n");
+        exit(2);
+    }
+    memcpy(ram_image, firmware_ram_start, firmware_ram_end - firmware_ram_start);
+
+    // Sped up, a millisecond either way would be seconds of simulated time
+    // run through without the firmware, and the watchdog would bite
+    speed       = rate;
+    paced       = always;
+    slack_ns    = (int64_t)(SIM_SECONDS(PACE_SLACK) * 1e9 / speed);
+    resync_ns   = (int64_t)(SIM_SECONDS(PACE_RESYNC) * 1e9 / speed);
+    if (slack_ns > PACE_SLACK_NS)
+    {
+        slack_ns = PACE_SLACK_NS;
+    }
+    if (resync_ns > PACE_RESYNC_NS)
+    {
+        resync_ns = PACE_RESYNC_NS;
+    }
+    pthread_mutex_lock(&cpu);
+    gie = 0;
+    if (pthread_create(&thread, 0, sim_thread, 0))
+    {
+        fprintf(stderr, "sim: cannot start the simulation thread\n");
+        exit(2);
+    }
+}   /* sim_start() */
+
+/*!
+* @brief Runs the firmware on the calling thread, and again from the start
+* after every reset.
+* @param[in] entry The firmware's main().
+*/
+void
+sim_run (void (*entry)(void))
+{
+    on_firmware = 1;
+    sigsetjmp(boot, 1);
+    entry();
+}   /* sim_run() */
+
+/*** end of file ***/
@@ -0,0 +1,102 @@
+/******************************************************************************/
+
+/** @file sim.h
+*
+* @brief Simulated MSP430FR2433 core for running the firmware on a Linux host.
+*
+* @par
+* The firmware runs on the main thread. A simulation thread owns simulated
+* time: it advances the peripherals in periph.c from one event to the next,
+* runs scheduled events for the virtual robot and host, and calls the
+* firmware's ISRs when their flags and enables are set.
+*
+* @par
+* Clearing GIE is modelled by the firmware thread holding a CPU mutex, so an
+* ISR never runs inside a critical section. Entering a low power mode waits on
+* a condition variable until an ISR clears the sleep bits on exit. While the
+* firmware is asleep simulated time skips straight to the next event, and while
+* it is awake simulated time is paced at a multiple of wall clock time.
+*/
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+
+// Simulated time in ticks of 512MHz, a common multiple of every clock rate used
+typedef uint64_t sim_time_t;
+
+#define SIM_HZ                  512000000ULL
+#define SIM_US(us)              ((sim_time_t)(us) * (SIM_HZ / 1000000))
+#define SIM_MS(ms)              ((sim_time_t)(ms) * (SIM_HZ / 1000))
+#define SIM_SECONDS(t)          ((double)(t) / SIM_HZ)
+
+// Register selectors for sim_port_reg()
+enum
+{
+    SIM_PIN,
+    SIM_POUT,
+    SIM_PDIR,
+    SIM_PREN,
+    SIM_PIES,
+    SIM_PIE,
+    SIM_PIFG,
+    SIM_PSEL0,
+    SIM_PSEL1,
+    SIM_PORT_REGS
+};
+
+// Register selectors for sim_timer_reg()
+enum
+{
+    SIM_TACTL,
+    SIM_TAR,
+    SIM_TAEX0,
+    SIM_TACCTL0,
+    SIM_TACCTL1,
+    SIM_TACCTL2,
+    SIM_TACCR0,
+    SIM_TACCR1,
+    SIM_TACCR2,
+    SIM_TIMER_REGS
+};
+
+typedef void (*sim_event_t)(void *arg);
+
+// Register access and intrinsics, used through driverlib.h by the firmware
+volatile uint8_t *sim_port_reg(uint8_t port, uint8_t reg);
+uint16_t sim_port_iv(uint8_t port);
+volatile uint16_t *sim_timer_reg(uint16_t base, uint8_t reg);
+uint16_t sim_uart_iv(uint16_t base);
+uint16_t sim_sysrstiv(void);
+void sim_delay_cycles(uint32_t cycles);
+void sim_disable_interrupt(void);
+void sim_enable_interrupt(void);
+uint16_t sim_get_interrupt_state(void);
+void sim_set_interrupt_state(uint16_t state);
+void sim_bis_sr(uint16_t bits);
+void sim_bic_sr(uint16_t bits);
+void sim_bic_sr_on_exit(uint16_t bits);
+
+// Simulation control, used by the virtual robot and host
+void sim_start(double speed, uint8_t always);
+void sim_run(void (*entry)(void));
+void sim_exit(int status);
+void sim_lock(void);
+void sim_unlock(void);
+sim_time_t sim_now(void);
+uint16_t sim_sleep_bits(void);
+void sim_asleep(sim_time_t *lpm0, sim_time_t *lpm3);
+uint32_t sim_resets(void);
+void sim_hang(void);
+void sim_schedule(sim_time_t delay, sim_event_t event, void *arg);
+void sim_wait(void);
+void sim_log(const char *format, ...);
+void sim_seed(uint32_t seed);
+uint32_t sim_random(uint32_t range);
+
+extern int sim_verbose;
+
+#endif /* SIM_H */
+
+/*** end of file ***/
@@ -0,0 +1,358 @@
+/******************************************************************************/
+
+/** @file jam.c
+*
+* @brief This module recovers from chips jammed in the dispenser.
+*
+* @par
+* A chip that is never seen after the dispenser extends is taken to be stuck
+* in it. jam_start() works through the strategies in the recovery table,
+* mildest first, each followed by another drop and another wait for the
+* chip: reseating the dispenser, wiggling the carriage around the column
+* with the dispenser backed off, and homing the carriage in case it lost
+* steps. Only once the table is exhausted is the jam reported to the host,
+* for someone to clear.
+*
+* @par
+* The chip may have gone into the column past a sensor that didn't see it.
+* So a try never retracts the dispenser far enough for the next chip to
+* load, only to SERVO_RESEAT_DUTY, and an empty dispenser drops nothing
+* more into a column that already has the lost chip.
+*
+* @par
+* Recovery takes up to half a minute, so it runs on the scheduler's events
+* like the game does. While jam_busy() the game hands every event to
+* jam_event(), which starts each servo move, settling delay, carriage move and
+* drop as the last one finishes, and the host's frames are still answered
+* meanwhile.
+*
+* @par
+* How many jams each strategy cleared is kept in FRAM and sent by
+* jam_report() for the Z maintenance instruction, see uart.c, as
+* Z jams_l jams_h reseat_l reseat_h wiggle_l wiggle_h rehome_l rehome_h
+* hard_l hard_h.
+*/
+
+// Includes
+#include <stdint.h>
+#include "driverlib.h"
+#include "Board.h"
+#include "defines.h"
+#include "sched.h"
+#include "jam.h"
+#include "stepper.h"
+#include "servo.h"
+#include "photo.h"
+#include "protocol.h"
+#include "trace.h"
+
+#define WIGGLE_STEPS        20      // Carriage travel either side of the column
+#define OP_JAM              0x5A    // Z
+
+typedef enum
+{
+    JAM_RESEAT,         // Retract and extend again
+    JAM_WIGGLE,         // Retract, shake the carriage, extend again
+    JAM_REHOME,         // Retract, home, return, extend again
+    JAM_STRATEGIES
+} jam_strategy_t;
+
+// What the try under way is waiting for
+typedef enum
+{
+    JAM_IDLE,
+    JAM_RETRACT,        // Dispenser backing off
+    JAM_SETTLE,         // Chip dropping back into place, SCHED_TIMER_RELOAD
+    JAM_WIGGLE_OUT,     // Carriage past the column
+    JAM_WIGGLE_BACK,    // Carriage short of the column
+    JAM_HOME,           // Carriage homing
+    JAM_RETURN,         // Carriage back over the column
+    JAM_WATCH           // Dispenser out, chip seen or timed out
+} jam_phase_t;
+
+typedef struct
+{
+    jam_strategy_t  strategy;
+    uint8_t         tries;
+} jam_step_t;
+
+// Mildest first, tried in order until the chip is seen
+static const jam_step_t recovery[] =
+{
+    { JAM_RESEAT, 2 },
+    { JAM_WIGGLE, 2 },
+    { JAM_REHOME, 1 }
+};
+
+typedef struct
+{
+    uint16_t    jams;                       // Times a chip wasn't seen
+    uint16_t    cleared[JAM_STRATEGIES];    // Jams cleared by each strategy
+    uint16_t    hard;                       // Jams left for the host
+} jam_stats_t;
+
+// FRAM, kept through resets and written with FRAMCtl
+#pragma PERSISTENT(stats)
+static jam_stats_t stats = {0};
+
+static jam_phase_t  phase       = JAM_IDLE;
+static int16_t      target      = 0;    // Carriage position over the column
+static uint8_t      step        = 0;    // Entry in the recovery table being tried
+static uint8_t      tries       = 0;    // Tries of it so far
+
+/*!
+* @brief Adds one to a counter in FRAM.
+*/
+static void
+jam_count (uint16_t *counter)
+{
+    uint16_t count = *counter + 1;
+
+    FRAMCtl_write16(&count, counter, 1);
+}   /* jam_count() */
+
+/*!
+* @brief Starts the next try, backing the dispenser off first.
+*/
+static void
+jam_try (void)
+{
+    phase = JAM_RETRACT;
+    servo_move_async(SERVO_RESEAT_DUTY, SERVO_RATE);
+}   /* jam_try() */
+
+/*!
+* @brief Starts a carriage move for the try under way.
+* @param[in] next The phase the move belongs to.
+* @param[in] position Where the carriage goes.
+*/
+static void
+jam_move (jam_phase_t next, int16_t position)
+{
+    phase = next;
+    stepper_move_async(position);
+}   /* jam_move() */
+
+/*!
+* @brief Drops again and watches for the chip.
+*/
+static void
+jam_watch (void)
+{
+    phase = JAM_WATCH;
+    servo_write_min();
+    photo_disarm();
+    photo_arm(1);
+}   /* jam_watch() */
+
+/*!
+* @brief Goes on once the chip has dropped back into place, shaking or
+* homing the carriage first if the strategy calls for it.
+*/
+static void
+jam_settled (void)
+{
+    switch (recovery[step].strategy)
+    {
+    case JAM_WIGGLE:
+        stepper_enable();
+        jam_move(JAM_WIGGLE_OUT, target + WIGGLE_STEPS);
+        break;
+
+    case JAM_REHOME:
+        stepper_enable();
+        phase = JAM_HOME;
+        stepper_home_async();
+        break;
+
+    default:
+        jam_watch();
+        break;
+    }
+}   /* jam_settled() */
+
+/*!
+* @brief Handles the carriage coming to a stop during a try.
+*/
+static void
+jam_stopped (void)
+{
+    switch (phase)
+    {
+    case JAM_WIGGLE_OUT:
+        jam_move(JAM_WIGGLE_BACK, target - WIGGLE_STEPS);
+        break;
+
+    case JAM_WIGGLE_BACK:
+    case JAM_HOME:
+        jam_move(JAM_RETURN, target);
+        break;
+
+    case JAM_RETURN:
+        stepper_disable();
+        jam_watch();
+        break;
+
+    default:
+        break;
+    }
+}   /* jam_stopped() */
+
+/*!
+* @brief Finishes a try, starting the next one if the chip still wasn't seen.
+* @param[in] columns The beams the chip broke, 0 if it timed out.
+* @return 1 if recovery is over, 0 if it goes on.
+*/
+static uint8_t
+jam_tried (uint8_t columns)
+{
+    photo_disarm();
+
+    if (columns)
+    {
+        jam_count(&stats.cleared[recovery[step].strategy]);
+    }
+    else if (++tries < recovery[step].tries)
+    {
+        jam_try();
+        return 0;
+    }
+    else if (++step < sizeof(recovery) / sizeof(recovery[0]))
+    {
+        tries = 0;
+        jam_try();
+        return 0;
+    }
+    else
+    {
+        jam_count(&stats.hard);
+    }
+
+    phase = JAM_IDLE;
+    trace_end(TRACE_RECOVER, photo_column(columns));
+    return 1;
+}   /* jam_tried() */
+
+/*!
+* @brief Starts clearing a jammed chip. The game hands its events to
+* jam_event() until it is done.
+* @param[in] position The carriage position over the column.
+*/
+void
+jam_start (int16_t position)
+{
+    trace_begin(TRACE_RECOVER);
+    jam_count(&stats.jams);
+
+    photo_disarm();
+    target = position;
+    step   = 0;
+    tries  = 0;
+    jam_try();
+}   /* jam_start() */
+
+/*!
+* @brief Checks whether recovery is under way.
+* @return 1 if it is, 0 if not.
+*/
+uint8_t
+jam_busy (void)
+{
+    return JAM_IDLE != phase;
+}   /* jam_busy() */
+
+/*!
+* @brief Gives up on recovery, for a game that is being abandoned. A
+* carriage or dispenser move under way is left to finish.
+*/
+void
+jam_stop (void)
+{
+    if (JAM_IDLE == phase)
+    {
+        return;
+    }
+
+    phase = JAM_IDLE;
+    sched_timer_stop(SCHED_TIMER_RELOAD);
+    photo_disarm();
+    trace_end(TRACE_RECOVER, 7);
+}   /* jam_stop() */
+
+/*!
+* @brief Takes recovery a step further on a scheduler event.
+* @param[in] event The event.
+* @param[in] arg Its argument, listed in sched_event_t.
+* @param[out] columns Once it is over, the beams the chip finally broke, bit
+* n = column n, or 0 for a hard jam.
+* @return 1 once recovery is over, 0 while it goes on. The dispenser is
+* left extended.
+*/
+uint8_t
+jam_event (sched_event_t event, uint8_t arg, uint8_t *columns)
+{
+    photo_drop_t drop;
+
+    switch (event)
+    {
+    case SCHED_EV_SERVO:
+        if ((JAM_RETRACT == phase) && !servo_is_busy())
+        {
+            phase = JAM_SETTLE;
+            sched_timer_start(SCHED_TIMER_RELOAD, SERVO_RELOAD_TICKS);
+        }
+        break;
+
+    case SCHED_EV_STEPPER:
+        if (!stepper_is_busy())
+        {
+            jam_stopped();
+        }
+        break;
+
+    case SCHED_EV_TIMER:
+        if ((SCHED_TIMER_RELOAD == arg) && (JAM_SETTLE == phase) && sched_timer_expired(SCHED_TIMER_RELOAD))
+        {
+            jam_settled();
+        }
+        else if ((SCHED_TIMER_PHOTO == arg) && (JAM_WATCH == phase) && photo_timed_out())
+        {
+            *columns = 0;
+            return jam_tried(0);
+        }
+        break;
+
+    case SCHED_EV_CHIP:
+        if ((JAM_WATCH == phase) && photo_take_drop(&drop))
+        {
+            *columns = drop.columns;
+            return jam_tried(drop.columns);
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return 0;
+}   /* jam_event() */
+
+/*!
+* @brief Sends the recovery counters over UART.
+*/
+void
+jam_report (void)
+{
+    uint8_t  reply[sizeof(stats)];
+    uint16_t *counter = (uint16_t *)&stats;
+    uint8_t  i;
+
+    for (i = 0; i < sizeof(stats) / 2; i++)
+    {
+        reply[2 * i]     = counter[i] & 0xFF;
+        reply[2 * i + 1] = counter[i] >> 8;
+    }
+    protocol_send(OP_JAM, reply, sizeof(reply));
+}   /* jam_report() */
+
+/*** end of file ***/
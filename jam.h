@@ -0,0 +1,23 @@
+/******************************************************************************/
+
+/** @file jam.h
+*
+* @brief This module recovers from chips jammed in the dispenser.
+*/
+
+#ifndef JAM_H
+#define JAM_H
+
+void jam_start(int16_t position);
+
+uint8_t jam_busy(void);
+
+void jam_stop(void);
+
+uint8_t jam_event(sched_event_t event, uint8_t arg, uint8_t *columns);
+
+void jam_report(void);
+
+#endif /* JAM_H */
+
+/*** end of file ***/
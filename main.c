@@ -38,266 +38,997 @@
 #include "servo.h"
 #include "uart.h"
 #include "photo.h"
+#include "engine.h"
+#include "trace.h"
+#include "sched.h"
+#include "calib.h"
+#include "jam.h"
+#include "state.h"
+#include "power.h"
+#include "watchdog.h"
+#include "protocol.h"
 
-// 1 or 0 of these should be uncommented, all commented for production robot
-//#define bump_testing
-//#define photo_testing
-//#define uart_testing
-//#define servo_testing
-//#define stepper_testing // only test after testing bump switch
-//#define mechanical_testing
+// Where the game is, each state waits for one kind of event
+typedef enum
+{
+    GAME_WAIT_START,    // Instruction @ or G
+    ROBOT_WAIT_COLUMN,  // Instruction p-w
+    ROBOT_MOVE,         // Carriage at the column
+    ROBOT_DROP,         // Chip seen or timed out
+    ROBOT_WAIT_STATUS,  // Instruction H or O
+    HUMAN_DETECT,       // Chip seen
+    HUMAN_WAIT_STATUS   // Instruction H or O
+} game_state_t;
+
+// What the carriage is doing
+typedef enum
+{
+    CARRIAGE_IDLE,
+    CARRIAGE_PARK,          // Parking or homing after a robot turn
+    CARRIAGE_PREPOSITION,   // Heading for the robot's likely next column
+    CARRIAGE_MOVE           // Heading for the robot's column
+} carriage_t;
 
 static const uint16_t num_columns       = 7;
-static const uint16_t steps_to_board    = 319;  // 319 steps = 45mm, 1000 steps = 141mm
-static const uint16_t column_steps      = 248;  // 248 steps = 35mm
+static const uint8_t  park_column       = 7;    // Column to wait over between turns, 7 = stay in place
+static const uint8_t  rehome_turns      = 8;    // Robot turns between homing drift checks
+static const uint8_t  center_column     = 3;    // Pre-position target without a hint
+static const uint16_t hint_ticks        = 51;   // 51/512 = 100ms to wait for a hint
 
-static turn_t   current_turn    = TBD;
-static uint8_t  robot_column    = 0;
-static uint8_t  human_column    = 0;
+static turn_t       current_turn    = TBD;
+static uint8_t      robot_column    = 0;
+static uint8_t      human_column    = 0;
+static uint8_t      robot_turns     = 0;
 
-void main (void)
-{
+static game_state_t game_state      = GAME_WAIT_START;
+static carriage_t   carriage        = CARRIAGE_IDLE;
+static uint8_t      hint_column     = 7;    // Host's guess at the robot's next column, 7 = none
+static uint8_t      target_column   = 0;    // Column the carriage is pre-positioning to
+static uint8_t      hint_waiting    = 0;    // Waiting for a hint this turn
+static uint8_t      error_sent      = 0;    // Error reported for the chip being dropped
+static uint8_t      missed          = 0;    // Miss counted for the chip being dropped
+static uint8_t      extending       = 0;    // Dispenser extending for the chip being dropped
+static uint8_t      sensor_faults   = 0;    // Photo-interrupters found failed, bit n = column n
+static state_t      saved           = {0};  // Game as last saved to FRAM
 
-    // Stop watchdog timer
-    WDT_A_hold(WDT_A_BASE);
+/*!
+* @brief Saves where the game is to FRAM, so a reset can pick it up again.
+*/
+static void
+game_save (void)
+{
+    saved.phase         = game_state;
+    saved.turn          = current_turn;
+    saved.robot_column  = robot_column;
+    saved.robot_turns   = robot_turns;
+    saved.dispenser     = extending;
+    saved.missed        = missed;
+    saved.error_sent    = error_sent;
+    saved.carriage      = (CARRIAGE_IDLE == carriage) && !stepper_is_busy();
+    saved.position      = stepper_get_position();
+    saved.commands      = uart_get_taken();
+    state_save(&saved);
+}   /* game_save() */
 
-    // Initialize MCLK = 16MHz, SMCLK = 2MHz, ACLK = 32.768kHz
-    CS_initClockSignal(CS_FLLREF, CS_REFOCLK_SELECT, CS_CLOCK_DIVIDER_1);
-    CS_initFLLSettle(CS_MCLK_DESIRED_FREQUENCY_IN_KHZ, CS_MCLK_FLLREF_RATIO);
-    CS_initClockSignal(CS_SMCLK, CS_DCOCLKDIV_SELECT, CS_CLOCK_DIVIDER_8);
-    CS_initClockSignal(CS_ACLK, CS_REFOCLK_SELECT, CS_CLOCK_DIVIDER_1);
+/*!
+* @brief Records a chip played by either side with the engine and in the
+* move history.
+* @param[in] column The column 0-6.
+*/
+static void
+game_play (uint8_t column)
+{
+    if (engine_play(column) && (saved.moves < STATE_MOVES))
+    {
+        saved.history[saved.moves++] = column;
+    }
+}   /* game_play() */
 
-    // Initialize stepper driver
-    stepper_init();
+/*!
+* @brief Stepper callback, runs from timer0_a1_isr.
+*/
+static void
+game_stepper_done (void)
+{
+    sched_post(SCHED_EV_STEPPER, 0);
+}   /* game_stepper_done() */
 
-    // Initialize servo
-    servo_init();
+/*!
+* @brief Stepper approach callback, runs from timer0_a1_isr.
+*/
+static void
+game_stepper_near (void)
+{
+    sched_post(SCHED_EV_APPROACH, 0);
+}   /* game_stepper_near() */
 
-    // Initialize UART, baudrate = 115200
-    uart_init();
+/*!
+* @brief Servo callback, runs from timer1_a1_isr.
+*/
+static void
+game_servo_done (void)
+{
+    sched_post(SCHED_EV_SERVO, 0);
+}   /* game_servo_done() */
 
-    // Initialize photo-interrupters
-    photo_init();
+/*!
+* @brief Gives the idle carriage its next job.
+*
+* @par
+* While the host is thinking about the robot's move the carriage heads for
+* the column it hinted at, or the center, so only the residual distance is
+* left once the column arrives. The last move always runs to completion
+* first, game_stepper() calls this again when it does.
+*/
+static void
+game_carriage_next (void)
+{
+    int16_t target;
 
-    // Disable the GPIO power-on default high-impedance mode to activate
-    // previously configured port settings
-    PMM_unlockLPM5();
+    if (CARRIAGE_IDLE != carriage)
+    {
+        return;
+    }
 
-    // Enable global interrupts
-    __bis_SR_register(GIE);
+    if (ROBOT_MOVE == game_state)
+    {
+        // The dispenser starts extending before the carriage gets there
+        stepper_enable();
+        carriage  = CARRIAGE_MOVE;
+        extending = 0;
+        stepper_set_approach(SERVO_LEAD_STEPS, game_stepper_near);
+        stepper_move_async(calib_get_position(robot_column));
+    }
+    else if ((HUMAN_WAIT_STATUS == game_state) || (ROBOT_WAIT_COLUMN == game_state))
+    {
+        // Give the host a moment to hint before settling for the center,
+        // a move already under way has to finish before it can turn back
+        if (hint_column < num_columns)
+        {
+            target_column = hint_column;
+        }
+        else if (sched_timer_expired(SCHED_TIMER_HINT))
+        {
+            target_column = center_column;
+        }
+        else
+        {
+            if (!hint_waiting)
+            {
+                hint_waiting = 1;
+                sched_timer_start(SCHED_TIMER_HINT, hint_ticks);
+            }
+            return;
+        }
 
-#if defined(uart_testing) || defined(servo_testing) || defined(bump_testing) || defined(stepper_testing) || defined(photo_testing)
-    // Set S1 as input
-    GPIO_setAsInputPinWithPullUpResistor(
-        GPIO_PORT_S1,
-        GPIO_PIN_S1
-        );
-    // Set S2 as input
-    GPIO_setAsInputPinWithPullUpResistor(
-        GPIO_PORT_S2,
-        GPIO_PIN_S2
-        );
-#else
-    // Retract chip dispenser
-    servo_write_max();
+        target = calib_get_position(target_column);
+        if (target != stepper_get_position())
+        {
+            trace_begin(TRACE_PREPOSITION);
+            stepper_enable();
+            carriage = CARRIAGE_PREPOSITION;
+            stepper_move_async(target);
+        }
+    }
+}   /* game_carriage_next() */
 
-    // Send stepper to 0 position
-    stepper_enable();
-    stepper_go_home();
-    stepper_disable();
+/*!
+* @brief Starts a turn for whoever plays next, or waits for a new game.
+* @param[in] turn The turn to start.
+*/
+static void
+game_start_turn (turn_t turn)
+{
+    current_turn = turn;
 
-    // Wait for start game instruction from UART
-    current_turn = uart_receive_start(); // @ = ROBOT, G = HUMAN
-#endif
+    // Nothing should be in a beam between turns
+    sensor_faults = photo_check();
 
-    while (1)
+    if (ROBOT == turn)
+    {
+        // Wait for column instruction from UART
+        trace_begin(TRACE_TURN);
+        trace_begin(TRACE_UART);
+        game_state = ROBOT_WAIT_COLUMN;
+        game_carriage_next();
+    }
+    else if (HUMAN == turn)
     {
+        // Watch the photo-interrupters for the human's chip
+        trace_begin(TRACE_TURN);
+        trace_begin(TRACE_DETECT);
+        photo_arm(0);
+        game_state = HUMAN_DETECT;
 
-#if !defined(uart_testing) && !defined(servo_testing) && !defined(bump_testing) && !defined(stepper_testing) && !defined(photo_testing) && !defined(mechanical_testing)
-        if (ROBOT == current_turn)
+        // Tell the host a chip in a failed column won't be seen
+        if (sensor_faults)
         {
-            // Wait for column instruction from UART
-            robot_column = uart_receive_column(); // p,q,r,s,t,u,v
+            uart_send_error(2); // z
+        }
+    }
+    else
+    {
+        // Wait for start game instruction from UART
+        game_state = GAME_WAIT_START;
+    }
+    game_save();
+}   /* game_start_turn() */
 
-            // Move stepper motor to appropriate column, some weird math bc we 0 is farthest away
-            uint16_t robot_column_steps = steps_to_board + column_steps * (num_columns - robot_column - 1);
-            stepper_enable();
-            stepper_send_steps(robot_column_steps, 1);
-            stepper_disable();
+/*!
+* @brief Starts the carriage towards the robot's column, once it has
+* finished whatever it is doing.
+*/
+static void
+game_start_move (void)
+{
+    game_state   = ROBOT_MOVE;
+    hint_column  = 7;
+    hint_waiting = 0;
+    sched_timer_stop(SCHED_TIMER_HINT);
+    trace_begin(TRACE_MOVE);
 
-            // Extend chip dispenser
-            servo_write_min();
+    // Already heading for the column, carry on as the move proper
+    if ((CARRIAGE_PREPOSITION == carriage) && (target_column == robot_column))
+    {
+        trace_end(TRACE_PREPOSITION, target_column);
+        carriage  = CARRIAGE_MOVE;
+        extending = 0;
+        stepper_set_approach(SERVO_LEAD_STEPS, game_stepper_near);
+    }
+    game_save();
+    game_carriage_next();
+}   /* game_start_move() */
 
-            // Poll photo-interrupters for correct column
-            uint8_t detected_column;
-            uint8_t error_sent = 0;
-            do
-            {
-                detected_column = photo_wait(1);
-                // Check for error and send if one hasn't been sent yet
-                if ((detected_column != robot_column) && !error_sent)
-                {
-                    // Check for chip jam error
-                    if (detected_column == 7) // 7 means it timed out
-                    {
-                        uart_send_error(1);
-                    }
-                    // or wrong column error
-                    else
-                    {
-                        uart_send_error(0);
-                    }
-                    error_sent = 1;
-                }
-            }
-            while (detected_column != robot_column);
+/*!
+* @brief Parks the carriage while the host decides, homing every few turns
+* to correct any drift. Runs on through the human's turn.
+*/
+static void
+game_start_park (void)
+{
+    trace_begin(TRACE_PARK);
+    stepper_enable();
+    if (++robot_turns >= rehome_turns)
+    {
+        robot_turns = 0;
+        stepper_home_async();
+    }
+    else if (park_column < num_columns)
+    {
+        stepper_move_async(calib_get_position(park_column));
+    }
+    else
+    {
+        stepper_disable();
+        trace_end(TRACE_PARK, 0);
+        return;
+    }
+    carriage = CARRIAGE_PARK;
+}   /* game_start_park() */
 
-            // Send no error
-            uart_send_no_error(); // W
+/*!
+* @brief Checks whether the game is ready for another instruction.
+* @return 1 if it is, 0 to keep instructions queued.
+*
+* @par
+* While the robot is placing its chip or watching for the human's, or
+* calibrating, every instruction waits its turn.
+*/
+static uint8_t
+game_ready (void)
+{
+    return (ROBOT_MOVE != game_state) && (ROBOT_DROP != game_state) && (HUMAN_DETECT != game_state)
+        && !calib_busy();
+}   /* game_ready() */
 
-            // Retract chip dispenser
-            servo_write_max();
+/*!
+* @brief Checks whether maintenance instructions may run.
+* @return Whether they run, wait or are refused, see uart_peek_instruction().
+*
+* @par
+* Only between games, and only once the carriage has stopped and any
+* calibration has finished or paused for the board to be emptied, since
+* they drive it themselves.
+*/
+static uart_maintain_t
+game_maintain (void)
+{
+    if (GAME_WAIT_START != game_state)
+    {
+        return UART_MAINTAIN_REFUSE;
+    }
+    if ((CARRIAGE_IDLE != carriage) || (calib_busy() && !calib_paused()))
+    {
+        return UART_MAINTAIN_HOLD;
+    }
+    return UART_MAINTAIN_RUN;
+}   /* game_maintain() */
 
-            // Send stepper home
-            stepper_enable();
-            stepper_go_home();
-            stepper_disable();
+/*!
+* @brief Drops the game under way, whatever it is doing, for a new one.
+*
+* @par
+* Jam recovery stops, the sensors stop watching and the dispenser comes
+* back, waiting for the next chip to load since the new game may drop it
+* straight away. A carriage move under way finishes as a park, so
+* game_stepper() switches the driver off once it stops.
+*/
+static void
+game_abandon (void)
+{
+    jam_stop();
+    photo_disarm();
+    sched_timer_stop(SCHED_TIMER_HINT);
+    hint_column  = 7;
+    hint_waiting = 0;
+    error_sent   = 0;
+    missed       = 0;
+    if (extending)
+    {
+        servo_write_max();
+        servo_settle();
+        power_delay(SERVO_RELOAD_TICKS);
+        extending = 0;
+    }
+    stepper_set_approach(0, 0);
+    if ((CARRIAGE_IDLE != carriage) || stepper_is_busy())
+    {
+        carriage = CARRIAGE_PARK;
+    }
+}   /* game_abandon() */
+
+/*!
+* @brief Handles an instruction from the host, once the game is ready for it.
+* @param[in] instruction The instruction, maintenance ones already answered.
+*
+* @par
+* Anything the state is not waiting for is dropped, as the blocking receives
+* always did. @ and G start a new game in any state, see game_event().
+*/
+static void
+game_instruction (uint8_t instruction)
+{
+    turn_t  next_turn;
+    uint8_t column;
 
-            // Wait for game status instruction from UART
-            current_turn = uart_receive_status(current_turn); // H = next turn, O = game over
+    // `,a-f, a hint at the robot's next column, g withdraws it
+    column = uart_decode_hint(instruction);
+    if (UART_NOT_COLUMN != column)
+    {
+        hint_column = column;
+        game_carriage_next();
+        return;
+    }
+
+    next_turn = uart_decode_start(instruction); // @ = ROBOT, G = HUMAN
+    if (TBD != next_turn)
+    {
+        if (GAME_WAIT_START != game_state)
+        {
+            game_abandon();
         }
+        engine_reset();
+        saved.moves = 0;
+        game_start_turn(next_turn);
+        return;
+    }
 
-        else if (HUMAN == current_turn)
+    switch (game_state)
+    {
+    case ROBOT_WAIT_COLUMN:
+        column = uart_decode_column(instruction); // p,q,r,s,t,u,v
+        if (UART_NOT_COLUMN == column)
         {
-            // Poll photo-interrupters for chip detection
-            human_column = photo_wait(0);
+            break;
+        }
+        trace_end(TRACE_UART, instruction);
+        robot_column = column;
 
-            // Send column instruction through UART
-            uart_send_column(human_column); // h,i,j,k,l,m,n
+        // w, the robot picks its own column and tells the host which
+        if (robot_column >= num_columns)
+        {
+            trace_begin(TRACE_ENGINE);
+            robot_column = engine_choose(ENGINE_DEPTH);
+            trace_end(TRACE_ENGINE, robot_column);
 
-            // Wait for game status instruction from UART
-            current_turn = uart_receive_status(current_turn); // H = next turn, O = game over
+            // A full board has no move, wait for the host to start a new game
+            if (robot_column >= num_columns)
+            {
+                uart_send_error(UART_ERROR_NO_MOVE);
+                trace_begin(TRACE_UART);
+                break;
+            }
+            uart_send_move(robot_column);
         }
+        game_start_move();
+        break;
 
-        else if (GAME_OVER == current_turn)
+    case ROBOT_WAIT_STATUS:
+    case HUMAN_WAIT_STATUS:
+        next_turn = uart_decode_status(instruction, current_turn); // H = next turn, O = game over
+        if (TBD != next_turn)
         {
-            // Wait for start game instruction from UART
-                current_turn = uart_receive_start(); // @ = ROBOT, G = HUMAN
+            trace_end(TRACE_UART, next_turn);
+            trace_end(TRACE_TURN, current_turn);
+            game_start_turn(next_turn);
         }
+        break;
+
+    default:
+        break;
+    }
+}   /* game_instruction() */
+
+/*!
+* @brief Starts extending the chip dispenser and watching for the chip. The
+* interlock holds the chip until game_release().
+*/
+static void
+game_extend (void)
+{
+    trace_begin(TRACE_DROP);
+    error_sent = 0;
+    missed     = 0;
+    extending  = 1;
+    servo_set_interlock(1);
+    servo_write_min();
+    photo_arm(1);
+    game_save();
+}   /* game_extend() */
 
+/*!
+* @brief Lets the chip go, if the carriage is over the robot's column.
+*/
+static void
+game_release (void)
+{
+    int16_t off = stepper_get_position() - calib_get_position(robot_column);
+
+    if ((off >= -SERVO_RELEASE_TOLERANCE) && (off <= SERVO_RELEASE_TOLERANCE))
+    {
+        servo_set_interlock(0);
+    }
+}   /* game_release() */
+
+/*!
+* @brief Handles the carriage closing in on the robot's column: first
+* extends the dispenser, then releases the chip once within tolerance.
+*/
+static void
+game_approach (void)
+{
+    if ((ROBOT_MOVE != game_state) || (CARRIAGE_MOVE != carriage))
+    {
+        return;
+    }
+
+    if (!extending)
+    {
+        game_extend();
+        stepper_set_approach(SERVO_RELEASE_TOLERANCE, game_stepper_near);
+    }
+    else
+    {
+        game_release();
+    }
+}   /* game_approach() */
+
+/*!
+* @brief Handles the carriage coming to a stop.
+*/
+static void
+game_stepper (void)
+{
+    carriage_t finished = carriage;
+
+    carriage = CARRIAGE_IDLE;
+    switch (finished)
+    {
+    case CARRIAGE_PARK:
+        stepper_disable();
+        if ((0 == robot_turns) && stepper_home_failed())
+        {
+            // Try again after the next robot turn
+            trace_end(TRACE_PARK, 2);
+            robot_turns = rehome_turns - 1;
+        }
         else
         {
-            // Should never get here, means that current_turn == TBD
-            for (;;);
+            trace_end(TRACE_PARK, 0 == robot_turns);
         }
-#endif
+        game_save();
+        game_carriage_next();
+        break;
 
-#if defined(uart_testing)
-        if (!GPIO_getInputPinValue(GPIO_PORT_S1, GPIO_PIN_S1))
+    case CARRIAGE_PREPOSITION:
+        stepper_disable();
+        trace_end(TRACE_PREPOSITION, target_column);
+        game_save();
+        game_carriage_next();
+        break;
+
+    case CARRIAGE_MOVE:
+        stepper_set_approach(0, 0);
+        stepper_disable();
+        trace_end(TRACE_MOVE, robot_column);
+
+        // Release the chip, the dispenser is already out unless the move
+        // was too short to see the approach
+        if (!extending)
         {
-            // Should send h,i,j,k,l,m,n upon successive presses
-            uart_send_column(human_column++);
+            game_extend();
         }
-        if (!GPIO_getInputPinValue(GPIO_PORT_S2, GPIO_PIN_S2))
+        game_release();
+        game_state = ROBOT_DROP;
+        game_save();
+
+        // Pick up a chip seen on the way in
+        sched_post(SCHED_EV_CHIP, 0);
+        break;
+
+    default:
+        // Blocking moves, the diagnostics' and homing at boot
+        break;
+    }
+}   /* game_stepper() */
+
+/*!
+* @brief Finishes the robot's drop and waits for the game status.
+* @param[in] detected_column The column the chip was seen in, 7 if its
+* sensor has failed.
+*/
+static void
+game_dropped (uint8_t detected_column)
+{
+    photo_disarm();
+    trace_end(TRACE_DROP, detected_column);
+    if (detected_column == 7)
+    {
+        uart_send_error(2); // z
+    }
+    else
+    {
+        uart_send_no_error(); // W
+    }
+    game_play(robot_column);
+
+    // Retract chip dispenser
+    servo_write_max();
+    extending = 0;
+    game_start_park();
+
+    // Wait for game status instruction from UART
+    trace_begin(TRACE_UART);
+    game_state = ROBOT_WAIT_STATUS;
+    game_save();
+}   /* game_dropped() */
+
+/*!
+* @brief Counts the robot's chip going past unseen against its column's
+* sensor. However many times the chip times out, it only counts once, so
+* a chip that jams hard doesn't fail a working sensor on its own.
+*/
+static void
+game_missed (void)
+{
+    if (!missed)
+    {
+        missed = 1;
+        photo_missed(robot_column);
+        sensor_faults = photo_check();
+        game_save();
+    }
+}   /* game_missed() */
+
+/*!
+* @brief Handles the robot's chip seen, or timed out after jam recovery.
+* @param[in] columns The beams the chip broke, bit n = column n, 0 if it
+* timed out.
+*
+* @par
+* A chip nobody saw drop is never played. Once jammed is reported the
+* sensors keep watching until someone clears the chip and it is seen.
+*/
+static void
+game_robot_chip (uint8_t columns)
+{
+    uint8_t detected_column;
+
+    // A chip clipping the next beam on its way into the right column counts
+    detected_column = (columns & (1 << robot_column)) ? robot_column : photo_column(columns);
+
+    // Check for error and send if one hasn't been sent yet
+    if ((detected_column != robot_column) && !error_sent)
+    {
+        // Check for chip jam error
+        if (detected_column == 7) // 7 means it timed out
         {
-            // Receive p,q,r,s,t,u,v
-            robot_column = uart_receive_column();
+            uart_send_error(1);
         }
-#endif
+        // or wrong column error
+        else
+        {
+            uart_send_error(0);
+        }
+        error_sent = 1;
+    }
+
+    // A sensor that keeps missing the robot's chip has failed
+    if (detected_column == 7)
+    {
+        game_missed();
+        photo_arm(1);
+        game_save();
+        return;
+    }
 
-#if defined(servo_testing)
-        // move to max value on one button, min value on other button
-        if (!GPIO_getInputPinValue(GPIO_PORT_S1, GPIO_PIN_S1))
+    // Keep watching until the chip lands in the right column, unless it
+    // was seen going past one that can't see it
+    if (detected_column != robot_column)
+    {
+        if ((sensor_faults >> robot_column) & 1)
         {
-            servo_write_min();
+            game_dropped(7);
         }
-        if (!GPIO_getInputPinValue(GPIO_PORT_S2, GPIO_PIN_S2))
+        else
         {
-            servo_write_max();
+            photo_arm(1);
         }
-#endif
+        return;
+    }
+    game_dropped(robot_column);
+}   /* game_robot_chip() */
+
+/*!
+* @brief Handles a chip seen by the photo-interrupters, or the robot's chip
+* timing out.
+* @param[in] columns The beams the chip broke, bit n = column n, 0 if it
+* timed out.
+*/
+static void
+game_chip (uint8_t columns)
+{
+    uint8_t detected_column;
+
+    if (HUMAN_DETECT == game_state)
+    {
+        photo_disarm();
+        detected_column = photo_column(columns);
+        trace_end(TRACE_DETECT, detected_column);
+        human_column = detected_column;
+
+        // Send column instruction through UART
+        uart_send_column(human_column); // h,i,j,k,l,m,n
+        game_play(human_column);
 
-#if defined(bump_testing)
-        // should increment human_column upon successive presses of bump switch
-        if (!GPIO_getInputPinValue(BUMP_PORT, BUMP_PIN))
+        // Wait for game status instruction from UART, closing in on the
+        // robot's next column meanwhile
+        trace_begin(TRACE_UART);
+        game_state = HUMAN_WAIT_STATUS;
+        game_save();
+        game_carriage_next();
+        return;
+    }
+
+    if (ROBOT_DROP != game_state)
+    {
+        return;
+    }
+
+    // No chip seen, try to clear it before calling for help. Recovery runs
+    // on the events and hands the chip to game_robot_chip() when it is done.
+    // The miss counts first: a sensor that missed the last chip too has
+    // failed, and recovery would only load more chips past it unseen, so
+    // the jam is reported straight away
+    if (!columns && !error_sent)
+    {
+        game_missed();
+        if (!((sensor_faults >> robot_column) & 1))
         {
-            GPIO_toggleOutputOnPin(GPIO_PORT_P1, GPIO_PIN0);
-            human_column++;
+            jam_start(calib_get_position(robot_column));
+            return;
         }
-#endif
+    }
+    game_robot_chip(columns);
+}   /* game_chip() */
+
+/*!
+* @brief Hands every chip the photo-interrupters have seen to game_chip().
+*/
+static void
+game_drops (void)
+{
+    photo_drop_t drop;
 
-#if defined(stepper_testing)
-        // move 10 steps on one button, go home on other button
-        if (!GPIO_getInputPinValue(GPIO_PORT_S1, GPIO_PIN_S1))
+    // Leave a chip seen before the carriage stops for game_stepper()
+    if (ROBOT_MOVE == game_state)
+    {
+        photo_update();
+        return;
+    }
+
+    while (photo_take_drop(&drop))
+    {
+        game_chip(drop.columns);
+    }
+}   /* game_drops() */
+
+/*!
+* @brief Scheduler handler, drives the game from the events posted by the ISRs.
+* @param[in] event The event.
+* @param[in] arg Its argument, listed in sched_event_t.
+*/
+static void
+game_event (sched_event_t event, uint8_t arg)
+{
+    uint8_t instruction;
+    uint8_t columns;
+
+    // Jam recovery and calibration take the events until they are done
+    if (jam_busy())
+    {
+        if (jam_event(event, arg, &columns))
         {
-            // 1000 steps = 141mm
-            // 248 steps = 35mm
-            stepper_enable();
-            stepper_send_steps(248, 1);
-            stepper_disable();
+            game_robot_chip(columns);
         }
-        if (!GPIO_getInputPinValue(GPIO_PORT_S2, GPIO_PIN_S2))
+    }
+    else if (calib_busy())
+    {
+        calib_event(event, arg);
+    }
+    else
+    {
+        switch (event)
         {
-            stepper_enable();
-            stepper_go_home();
-            stepper_disable();
-        }
-#endif
+        case SCHED_EV_UART:
+            // Taken below
+            break;
 
-#if defined(photo_testing)
-        human_column = photo_wait();
-#endif
+        case SCHED_EV_STEPPER:
+            // Homing phases and blocking moves also finish here
+            if (!stepper_is_busy())
+            {
+                game_stepper();
+            }
+            break;
 
-#if defined(mechanical_testing)
-        // Wait for column instruction from UART
-        robot_column = uart_receive_column(); // p,q,r,s,t,u,v
+        case SCHED_EV_APPROACH:
+            game_approach();
+            break;
 
-        // Move stepper motor to appropriate column, some weird math bc we 0 is farthest away
-        uint16_t robot_column_steps = steps_to_board + column_steps * (num_columns - robot_column - 1);
-        stepper_enable();
-        stepper_send_steps(robot_column_steps, 1);
-        stepper_disable();
+        case SCHED_EV_SERVO:
+            // A chip dropped where its sensor had already failed is done once
+            // it is out, one that has timed out since waits to be seen
+            if ((ROBOT_DROP == game_state) && !servo_is_busy() && !missed
+                && ((sensor_faults >> robot_column) & 1))
+            {
+                game_dropped(7);
+            }
+            break;
 
-        // Extend chip dispenser
-        servo_write_min();
+        case SCHED_EV_CHIP:
+            game_drops();
+            break;
 
-        // Poll photo-interrupters for correct column
-        uint8_t detected_column;
-        uint8_t error_sent = 0;
-        do
-        {
-            detected_column = photo_wait(1);
-            // Check for error and send if one hasn't been sent yet
-            if ((detected_column != robot_column) && !error_sent)
+        case SCHED_EV_TIMER:
+            if ((SCHED_TIMER_PHOTO == arg) && photo_timed_out())
+            {
+                photo_disarm();
+                game_chip(0);
+            }
+            else if ((SCHED_TIMER_HINT == arg) && sched_timer_expired(SCHED_TIMER_HINT))
             {
-                // Check for chip jam error
-                if (detected_column == 7) // 7 means it timed out
-                {
-                    uart_send_error(1); // y
-                }
-                // or wrong column error
-                else
-                {
-                    uart_send_error(0); // x
-                }
-                error_sent = 1;
+                game_carriage_next();
             }
+            break;
+
+        default:
+            break;
         }
-        while (detected_column != robot_column);
+    }
 
-        // Send no error
-        uart_send_no_error(); // W
+    // Carry out queued instructions the game is now ready for. Each is taken
+    // first, so the save that goes with it counts it as done. A new game is
+    // started whatever the game is doing, only a calibration finishes first
+    while (uart_peek_instruction(&instruction, game_maintain())
+        && (game_ready() || (!calib_busy() && uart_skip_to_start(&instruction))))
+    {
+        uart_take_instruction();
+        game_instruction(instruction);
+    }
 
-        // Retract chip dispenser
-        servo_write_max();
+    // Instructions dropped or only hinting didn't save, count them now so a
+    // reset doesn't carry them out again
+    if (saved.commands != uart_get_taken())
+    {
+        game_save();
+    }
+}   /* game_event() */
+
+/*!
+* @brief Picks the game up where a reset left it, or waits for a new one.
+*
+* @par
+* Only a reset by a fault picks the game up. After power up anything may
+* have moved while the power was off, so the carriage is always homed and
+* the saved game is dropped, for the host to start a new one.
+*
+* @par
+* After a reset by a fault the power never went off, so nothing has moved
+* the carriage since, and the host is still mid conversation. The carriage
+* carries on from the position the stepper kept in FRAM if it was standing
+* still, and is homed if the reset caught it moving. If homing never finds
+* the switch the carriage goes on from where it was assumed to be and
+* homing is tried again after the next robot turn. Instructions the game
+* hadn't taken are carried out as if nothing had happened, and replies go
+* on the way the host expects them.
+*
+* @par
+* A robot turn that was moving or dropping starts its move again, since the
+* chip only counts once it is seen. A human's chip dropped while the robot
+* was down is missed. A chip that had already gone unseen isn't dropped
+* again, nor is jam recovery run again, since the chip may be in the column
+* already: it is reported jammed and watched for.
+*/
+static void
+game_boot (void)
+{
+    uint8_t recovering = watchdog_recovering();
+    uint8_t i;
+
+    // From power up the game starts over and the carriage is homed, since
+    // anything may have moved while the power was off
+    if (!state_load(&saved) || !recovering)
+    {
+        saved.phase     = GAME_WAIT_START;
+        saved.moves     = 0;
+        saved.carriage  = 0;
+    }
+    else
+    {
+        uart_resume_instructions(saved.commands);
+    }
+
+    if (recovering)
+    {
+        protocol_resume();
+    }
 
-        // Send stepper home
+    if (saved.carriage)
+    {
+        stepper_set_position(saved.position);
+    }
+    else if (!recovering || !stepper_recover())
+    {
+        // Send stepper to 0 position
+        trace_begin(TRACE_HOME);
         stepper_enable();
         stepper_go_home();
         stepper_disable();
-#endif
+        trace_end(TRACE_HOME, stepper_home_failed());
+    }
+
+    // Let the next chip load if the dispenser was out, once the horn has
+    // come all the way back
+    if (saved.dispenser)
+    {
+        servo_settle();
+        power_delay(SERVO_RELOAD_TICKS);
+    }
+
+    engine_reset();
+    for (i = 0; (i < saved.moves) && (i < STATE_MOVES); i++)
+    {
+        engine_play(saved.history[i]);
+    }
+    current_turn = (turn_t)saved.turn;
+    robot_column = saved.robot_column;
+    robot_turns  = saved.robot_turns;
+    if (stepper_home_failed())
+    {
+        robot_turns = rehome_turns - 1;
+    }
+
+    switch ((game_state_t)saved.phase)
+    {
+    case ROBOT_WAIT_COLUMN:
+    case HUMAN_DETECT:
+        game_start_turn(current_turn);
+        break;
+
+    case ROBOT_MOVE:
+    case ROBOT_DROP:
+        trace_begin(TRACE_TURN);
+        if (saved.missed)
+        {
+            trace_begin(TRACE_DROP);
+            missed     = 1;
+            error_sent = saved.error_sent;
+            game_state = ROBOT_DROP;
+            game_robot_chip(0);
+            game_save();
+        }
+        else
+        {
+            game_start_move();
+        }
+        break;
+
+    case ROBOT_WAIT_STATUS:
+    case HUMAN_WAIT_STATUS:
+        trace_begin(TRACE_TURN);
+        trace_begin(TRACE_UART);
+        game_state = (game_state_t)saved.phase;
+        game_save();
+        game_carriage_next();
+        break;
 
+    default:
+        game_start_turn(TBD);
+        break;
     }
+
+    // Carry on with any instructions that were waiting
+    sched_post(SCHED_EV_UART, 0);
+}   /* game_boot() */
+
+void main (void)
+{
+
+    // Stop watchdog timer
+    WDT_A_hold(WDT_A_BASE);
+
+    // Initialize MCLK = 16MHz, SMCLK = 2MHz, ACLK = 32.768kHz
+    CS_initClockSignal(CS_FLLREF, CS_REFOCLK_SELECT, CS_CLOCK_DIVIDER_1);
+    CS_initFLLSettle(CS_MCLK_DESIRED_FREQUENCY_IN_KHZ, CS_MCLK_FLLREF_RATIO);
+    CS_initClockSignal(CS_SMCLK, CS_DCOCLKDIV_SELECT, CS_CLOCK_DIVIDER_8);
+    CS_initClockSignal(CS_ACLK, CS_REFOCLK_SELECT, CS_CLOCK_DIVIDER_1);
+
+    // Initialize scheduler clock and software timers
+    sched_init();
+
+    // Initialize stepper driver
+    stepper_init();
+
+    // Initialize servo
+    servo_init();
+
+    // Initialize UART, baudrate = 115200
+    uart_init();
+
+    // Initialize photo-interrupters
+    photo_init();
+
+    // Initialize turn phase timing
+    trace_init();
+    trace_begin(TRACE_BOOT);
+
+    // Disable the GPIO power-on default high-impedance mode to activate
+    // previously configured port settings
+    PMM_unlockLPM5();
+
+    // Watch the photo-interrupters' health from here on
+    photo_start();
+
+    // Enable global interrupts
+    __bis_SR_register(GIE);
+
+    // Retract chip dispenser
+    servo_write_max();
+
+    // Reset if the game stops making progress from here on
+    watchdog_init();
+
+    // Home unless the carriage position survived a reset, and resume any
+    // game. A resumed move may already be over, so the callbacks go first
+    stepper_set_callback(game_stepper_done);
+    servo_set_callback(game_servo_done);
+    game_boot();
+    trace_end(TRACE_BOOT, watchdog_recovering());
+
+    // Run the game from here on as events come in, starting with @ or G.
+    // The bench diagnostics are maintenance instructions, see diag.c
+    sched_run(game_event);
 }
 
 /*** end of file ***/
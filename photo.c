@@ -1,6 +1,44 @@
 /** @file photo.c
 *
 * @brief This module provides control functions for reading the photo-interrupters.
+*
+* @par
+* photo_arm() arms the sensors and returns. The port ISRs post SCHED_EV_CHIP
+* when a chip is seen and the timeout is the SCHED_TIMER_PHOTO software
+* timer, so the game carries on with other work while it waits for a chip.
+* photo_take_drop() then reports the chip. photo_wait() does all of this in
+* one blocking call for code that has nothing else to do.
+*
+* @par
+* Every edge on every sensor is queued with its trace_now() time in a ring
+* that only the port ISRs add to and only photo_take_drop() takes from, so
+* neither has to lock the other out. Each pin is watched for the edge back
+* from the level it last read, so a chip is seen both breaking and clearing
+* a beam, and two chips or a chip clipping two beams are all kept. Beams
+* broken within PHOTO_SIMULTANEOUS_TICKS of each other are one drop.
+*
+* @par
+* photo_take_drop() runs the edges through a filter before calling them a
+* chip. A beam has to stay broken for min_break ticks, so noise from the
+* stepper driver is thrown away, and once a chip has cleared it the beam has
+* to stay clear for min_clear ticks before it can see another, so a chip
+* bouncing on the edge of the beam is only seen once. Both are kept for each
+* column in FRAM and set with the [ maintenance instruction, see uart.c:
+* [ column min_break_l min_break_h min_clear_l min_clear_h sets a column, or
+* every column for column 7, and [ on its own only reports. The reply is
+* [ glitches_l glitches_h, then min_break and min_clear for columns 0 to 6,
+* all little endian.
+*
+* @par
+* The sensors are watched from photo_start() on, armed or not, counting the
+* edges on each and when it last changed. photo_check() runs between turns
+* and finds the sensors that have failed: one broken for PHOTO_STUCK_TICKS
+* with no chip in flight is stuck blocked, and one the robot's chip has gone
+* past unseen PHOTO_STUCK_MISSES times running, see photo_missed(), is
+* stuck clear. photo_health() answers the \ maintenance instruction with
+* \ stuck_blocked stuck_clear blocked, bit n = column n, then toggles_l
+* toggles_h ms_l ms_h for columns 0 to 6, ms being the time since the sensor
+* last changed, up to 65535.
 */
 
 // Includes
@@ -8,11 +46,76 @@
 #include "driverlib.h"
 #include "Board.h"
 #include "photo.h"
+#include "sched.h"
+#include "power.h"
+#include "trace.h"
+#include "protocol.h"
 #include "defines.h"
 
+#define NO_CHIP     7
+#define COLUMNS     7
+#define RING_SIZE   16      // Edges, power of 2
+#define MAX_DROPS   4       // Chips found and not yet taken
+#define ALARM_MAX   32767   // Trace ticks, longest photo_take_drop() waits before looking again
+#define OP_FILTER   0x5B    // [
+#define OP_HEALTH   0x5C    // Backslash
+
+typedef struct
+{
+    uint32_t    time;       // trace_now() when the ISR saw it
+    uint8_t     changed;    // Sensors that changed, bit n = column n
+    uint8_t     blocked;    // Of those, the ones now blocked
+} photo_edge_t;
+
+typedef struct
+{
+    uint16_t    min_break;  // Trace ticks a beam stays broken for a chip
+    uint16_t    min_clear;  // Trace ticks it stays clear before the next chip
+} photo_filter_t;
+
+// FRAM, kept through resets and written with FRAMCtl
+#pragma PERSISTENT(filters)
+static photo_filter_t filters[COLUMNS] =
+{
+    { PHOTO_MIN_BREAK_TICKS, PHOTO_MIN_CLEAR_TICKS },
+    { PHOTO_MIN_BREAK_TICKS, PHOTO_MIN_CLEAR_TICKS },
+    { PHOTO_MIN_BREAK_TICKS, PHOTO_MIN_CLEAR_TICKS },
+    { PHOTO_MIN_BREAK_TICKS, PHOTO_MIN_CLEAR_TICKS },
+    { PHOTO_MIN_BREAK_TICKS, PHOTO_MIN_CLEAR_TICKS },
+    { PHOTO_MIN_BREAK_TICKS, PHOTO_MIN_CLEAR_TICKS },
+    { PHOTO_MIN_BREAK_TICKS, PHOTO_MIN_CLEAR_TICKS }
+};
+
 // Local variables
-static uint16_t                 timeout_cycles  = 2559; // (2559+1)/512 = 5 seconds
-static Timer_A_initUpModeParam  param           = {0};
+static uint16_t                 timeout_cycles  = 2560; // 2560/512 = 5 seconds
+static uint8_t                  idle_p1         = 0;    // Sensor levels with no chip in the beam
+static uint8_t                  idle_p2         = 0;
+static uint8_t                  started         = 0;
+static volatile uint8_t         armed           = 0;
+static volatile uint8_t         level_p1        = 0;    // Sensor levels as last queued
+static volatile uint8_t         level_p2        = 0;
+static volatile photo_edge_t    ring[RING_SIZE];
+static volatile uint8_t         ring_head       = 0;    // Written by the port ISRs only
+static volatile uint8_t         ring_tail       = 0;    // Written by photo_take_drop() only
+static volatile uint8_t         lost            = 0;    // Edges lost to a full ring
+static uint8_t                  lost_seen       = 0;
+
+// Filter, only used outside the ISRs. Bit n = column n
+static uint8_t                  pending         = 0;    // Broken, not yet for min_break
+static uint8_t                  holding         = 0;    // Broken by a chip, not cleared yet
+static uint8_t                  settling        = 0;    // Cleared by a chip, not yet for min_clear
+static uint32_t                 broke_at[COLUMNS];
+static uint32_t                 cleared_at[COLUMNS];
+static photo_drop_t             drops[MAX_DROPS];
+static uint8_t                  drop_count      = 0;
+static uint16_t                 glitches        = 0;    // Breaks too short to be a chip
+
+// Health, bit n = column n
+static volatile uint16_t        toggles[COLUMNS];       // Edges seen
+static volatile uint32_t        changed_at[COLUMNS];    // trace_now() of the last one
+static uint8_t                  misses[COLUMNS];        // Robot's chips gone past unseen in a row
+static uint8_t                  stuck_blocked   = 0;
+static uint8_t                  stuck_clear     = 0;
 
 /*!
 * @brief Initializes photo-interrupters to be used for chip detection.
@@ -28,51 +131,612 @@ photo_init (void)
     P2REN &= ~(PHOTO1 | PHOTO2 | PHOTO3 | PHOTO4 | PHOTO5);
     P1REN &= ~(PHOTO6 | PHOTO7);
 
-    // Configure TimerA2 in up mode. Cycles at 512Hz. 5 seconds at 2559
-    param.clockSource                               = TIMER_A_CLOCKSOURCE_ACLK;
-    param.clockSourceDivider                        = TIMER_A_CLOCKSOURCE_DIVIDER_64;
-    param.timerPeriod                               = 0xFFFF;
-    param.timerInterruptEnable_TAIE                 = TIMER_A_TAIE_INTERRUPT_DISABLE;
-    param.captureCompareInterruptEnable_CCR0_CCIE   = TIMER_A_CCIE_CCR0_INTERRUPT_DISABLE;
-    param.timerClear                                = TIMER_A_DO_CLEAR;
-    param.startTimer                                = true;
-    Timer_A_initUpMode(TIMER_A2_BASE, &param);
+    // Edge interrupts are armed by photo_arm()
+    P2IE &= ~PHOTO_P2_PINS;
+    P1IE &= ~PHOTO_P1_PINS;
 }
 
+/*!
+* @brief Starts watching the sensors. Called once LPM5 is unlocked, since
+* the inputs only read true from then on.
+*
+* @par
+* The sensors are all the same part, so the level most of them read is
+* taken as the level with no chip in the beam, even with some already stuck.
+*/
+void
+photo_start (void)
+{
+    uint8_t  sensors = PHOTO_IN;
+    uint8_t  high    = 0;
+    uint32_t now     = trace_now();
+    uint8_t  column;
+
+    for (column = 0; column < COLUMNS; column++)
+    {
+        high += (sensors >> column) & 1;
+        changed_at[column] = now;
+    }
+    idle_p1 = (high > COLUMNS / 2) ? PHOTO_P1_PINS : 0;
+    idle_p2 = (high > COLUMNS / 2) ? PHOTO_P2_PINS : 0;
+
+    // Watch every sensor for the edge away from the level it reads now
+    level_p1 = P1IN & PHOTO_P1_PINS;
+    level_p2 = P2IN & PHOTO_P2_PINS;
+    P1IES = (P1IES & ~PHOTO_P1_PINS) | level_p1;
+    P2IES = (P2IES & ~PHOTO_P2_PINS) | level_p2;
+    P1IFG &= ~PHOTO_P1_PINS;
+    P2IFG &= ~PHOTO_P2_PINS;
+    P1IE  |= PHOTO_P1_PINS;
+    P2IE  |= PHOTO_P2_PINS;
+
+    // A sensor that changed while starting gets its interrupt anyway
+    P1IFG |= (P1IN & PHOTO_P1_PINS) ^ level_p1;
+    P2IFG |= (P2IN & PHOTO_P2_PINS) ^ level_p2;
+    started = 1;
+}   /* photo_start() */
+
+/*!
+* @brief Starts watching for a chip.
+* @param[in] check_timeout Should it time out after 5 seconds? 1 = yes, 0 = no
+*
+* @par
+* Edges from before are thrown away, so a chip still clearing a sensor is
+* not seen again. Arming again while armed only restarts the timeout, so
+* chips already queued are still taken.
+*/
+void
+photo_arm (uint8_t check_timeout)
+{
+    if (!started)
+    {
+        photo_start();
+    }
+
+    if (!armed)
+    {
+        // The ISRs queue nothing while disarmed, so the ring is ours to empty
+        ring_tail  = ring_head;
+        pending    = 0;
+        holding    = 0;
+        settling   = 0;
+        drop_count = 0;
+        armed      = 1;
+    }
+
+    if (check_timeout)
+    {
+        sched_timer_start(SCHED_TIMER_PHOTO, timeout_cycles);
+    }
+    else
+    {
+        sched_timer_stop(SCHED_TIMER_PHOTO);
+    }
+}   /* photo_arm() */
+
+/*!
+* @brief Stops watching for a chip. The sensors are still watched for
+* photo_check().
+*/
+void
+photo_disarm (void)
+{
+    armed = 0;
+    sched_timer_stop(SCHED_TIMER_PHOTO);
+    trace_set_alarm(0, 0);
+}   /* photo_disarm() */
+
+/*!
+* @brief Checks whether the armed watch has timed out.
+* @return 1 if 5 seconds passed without a chip, 0 if not.
+*/
+uint8_t
+photo_timed_out (void)
+{
+    return sched_timer_expired(SCHED_TIMER_PHOTO);
+}   /* photo_timed_out() */
+
+/*!
+* @brief Adds a beam a chip broke to the drop it was broken with.
+* @param[in] column The beam's column.
+* @param[in] time When it broke.
+*/
+static void
+photo_found (uint8_t column, uint32_t time)
+{
+    photo_drop_t *drop = &drops[drop_count ? drop_count - 1 : 0];
+
+    misses[column] = 0;
+
+    // Within PHOTO_SIMULTANEOUS_TICKS either side of the last drop
+    if (drop_count && ((time - drop->time + PHOTO_SIMULTANEOUS_TICKS) <= 2 * PHOTO_SIMULTANEOUS_TICKS))
+    {
+        if ((int32_t)(time - drop->time) < 0)
+        {
+            drop->time = time;
+        }
+        drop->columns |= 1 << column;
+    }
+    else if (drop_count < MAX_DROPS)
+    {
+        drop          = &drops[drop_count++];
+        drop->time    = time;
+        drop->columns = 1 << column;
+    }
+    else
+    {
+        // No room, the last drop takes it
+        drop->columns |= 1 << column;
+    }
+}   /* photo_found() */
+
+/*!
+* @brief Runs one queued edge through the filter.
+* @param[in] edge The edge.
+*/
+static void
+photo_filter_edge (volatile photo_edge_t *edge)
+{
+    uint8_t column;
+    uint8_t bit;
+
+    for (column = 0; column < COLUMNS; column++)
+    {
+        bit = 1 << column;
+        if (!(edge->changed & bit))
+        {
+            continue;
+        }
+
+        if (edge->blocked & bit)
+        {
+            // Breaking again this soon is the last chip bouncing
+            if ((settling & bit) && ((edge->time - cleared_at[column]) < filters[column].min_clear))
+            {
+                holding |= bit;
+            }
+            else
+            {
+                pending |= bit;
+                broke_at[column] = edge->time;
+            }
+            settling &= ~bit;
+        }
+        else if (pending & bit)
+        {
+            pending &= ~bit;
+            if ((edge->time - broke_at[column]) >= filters[column].min_break)
+            {
+                photo_found(column, broke_at[column]);
+                settling |= bit;
+                cleared_at[column] = edge->time;
+            }
+            else
+            {
+                glitches++;
+            }
+        }
+        else if (holding & bit)
+        {
+            holding  &= ~bit;
+            settling |= bit;
+            cleared_at[column] = edge->time;
+        }
+    }
+}   /* photo_filter_edge() */
+
+/*!
+* @brief Runs the queued edges through the filter, so the ring doesn't fill
+* while the game isn't ready to take a chip.
+*/
+void
+photo_update (void)
+{
+    uint8_t broken;
+
+    while (ring_tail != ring_head)
+    {
+        photo_filter_edge(&ring[ring_tail]);
+        ring_tail = (ring_tail + 1) & (RING_SIZE - 1);
+    }
+
+    // An edge lost to a full ring can leave a beam looking broken, so go by
+    // the levels the ISRs last saw
+    if (lost != lost_seen)
+    {
+        lost_seen = lost;
+        broken    = PHOTO_BITS(level_p1 ^ idle_p1, level_p2 ^ idle_p2);
+        pending  &= broken;
+        holding  &= broken;
+    }
+}   /* photo_update() */
+
+/*!
+* @brief Alarm set by photo_take_drop(), runs from timer3_a1_isr().
+*/
+static void
+photo_alarm (void)
+{
+    sched_post(SCHED_EV_CHIP, 0);
+}   /* photo_alarm() */
+
+/*!
+* @brief Takes the oldest chip seen since photo_arm(). The watch stays armed.
+* @param[out] drop The chip, filled in if there is one.
+* @return 1 if there was a chip, 0 if not.
+*
+* @par
+* A beam still broken but not yet for min_break, or a drop another beam may
+* still join, is left for later. An alarm is set for the moment the first
+* of them can be decided, see photo_alarm(), so a drop is taken within a
+* trace tick of its window closing rather than on the next scheduler tick.
+*/
+uint8_t
+photo_take_drop (photo_drop_t *drop)
+{
+    uint32_t now;
+    uint32_t due;
+    uint32_t at;
+    uint8_t  column;
+    uint8_t  bit;
+    uint8_t  open     = 0;
+    uint8_t  i;
+
+    photo_update();
+
+    // A beam broken for long enough is a chip before it clears
+    now = trace_now();
+    for (column = 0; column < COLUMNS; column++)
+    {
+        bit = 1 << column;
+        if ((pending & bit) && ((now - broke_at[column]) >= filters[column].min_break))
+        {
+            pending &= ~bit;
+            holding |= bit;
+            photo_found(column, broke_at[column]);
+        }
+    }
+
+    if (drop_count)
+    {
+        open = (now - drops[0].time) <= PHOTO_SIMULTANEOUS_TICKS;
+        for (column = 0; column < COLUMNS; column++)
+        {
+            if ((pending & (1 << column))
+                && ((broke_at[column] - drops[0].time + PHOTO_SIMULTANEOUS_TICKS) <= 2 * PHOTO_SIMULTANEOUS_TICKS))
+            {
+                open = 1;
+            }
+        }
+    }
+
+    if (!drop_count || open)
+    {
+        // Come back when the window closes or a beam has been broken for
+        // min_break, whichever is first, at most a second from now. Edges
+        // before then come back anyway
+        due = drop_count ? drops[0].time + PHOTO_SIMULTANEOUS_TICKS + 1 : now + ALARM_MAX;
+        for (column = 0; column < COLUMNS; column++)
+        {
+            at = broke_at[column] + filters[column].min_break;
+            if ((pending & (1 << column)) && ((int32_t)(at - due) < 0))
+            {
+                due = at;
+            }
+        }
+        if (pending || drop_count)
+        {
+            trace_set_alarm(due, photo_alarm);
+        }
+        return 0;
+    }
+
+    *drop = drops[0];
+    drop_count--;
+    for (i = 0; i < drop_count; i++)
+    {
+        drops[i] = drops[i + 1];
+    }
+    return 1;
+}   /* photo_take_drop() */
+
+/*!
+* @brief Answers the [ maintenance instruction, setting a column's filter if
+* it came with one.
+* @param[in] data The payload.
+* @param[in] len The number of payload bytes.
+*/
+void
+photo_filter (const uint8_t *data, uint8_t len)
+{
+    photo_filter_t filter;
+    uint8_t        reply[2 + sizeof(filters)];
+    uint8_t        column;
+
+    if (len >= 5)
+    {
+        filter.min_break = data[1] | (data[2] << 8);
+        filter.min_clear = data[3] | (data[4] << 8);
+        for (column = 0; column < COLUMNS; column++)
+        {
+            if ((column == data[0]) || (COLUMNS == data[0]))
+            {
+                FRAMCtl_write16((uint16_t *)&filter, (uint16_t *)&filters[column], 2);
+            }
+        }
+    }
+
+    reply[0] = glitches & 0xFF;
+    reply[1] = glitches >> 8;
+    for (column = 0; column < COLUMNS; column++)
+    {
+        reply[2 + 4 * column] = filters[column].min_break & 0xFF;
+        reply[3 + 4 * column] = filters[column].min_break >> 8;
+        reply[4 + 4 * column] = filters[column].min_clear & 0xFF;
+        reply[5 + 4 * column] = filters[column].min_clear >> 8;
+    }
+    protocol_send(OP_FILTER, reply, sizeof(reply));
+}   /* photo_filter() */
+
+/*!
+* @brief Notes that the robot's chip went into a column without being seen.
+* @param[in] column The column.
+*/
+void
+photo_missed (uint8_t column)
+{
+    if ((column < COLUMNS) && (misses[column] < PHOTO_STUCK_MISSES))
+    {
+        misses[column]++;
+    }
+}   /* photo_missed() */
+
+/*!
+* @brief Finds the sensors that have failed. Run between turns, when no chip
+* should be in a beam for long.
+* @return The failed sensors, bit n = column n.
+*/
+uint8_t
+photo_check (void)
+{
+    uint8_t  blocked = photo_blocked();
+    uint32_t now     = trace_now();
+    uint32_t since;
+    uint8_t  column;
+
+    stuck_blocked = 0;
+    stuck_clear   = 0;
+    for (column = 0; column < COLUMNS; column++)
+    {
+        __disable_interrupt();
+        since = changed_at[column];
+        __enable_interrupt();
+
+        if ((blocked & (1 << column)) && ((now - since) >= PHOTO_STUCK_TICKS))
+        {
+            stuck_blocked |= 1 << column;
+        }
+        if (misses[column] >= PHOTO_STUCK_MISSES)
+        {
+            stuck_clear |= 1 << column;
+        }
+    }
+
+    return stuck_blocked | stuck_clear;
+}   /* photo_check() */
+
+/*!
+* @brief Gets the beams broken now, chip or not.
+* @return The beams, bit n = column n.
+*/
+uint8_t
+photo_blocked (void)
+{
+    return PHOTO_BITS(level_p1 ^ idle_p1, level_p2 ^ idle_p2);
+}   /* photo_blocked() */
+
+/*!
+* @brief Answers the \ maintenance instruction.
+*/
+void
+photo_health (void)
+{
+    uint8_t  reply[3 + 4 * COLUMNS];
+    uint32_t now;
+    uint32_t since;
+    uint16_t count;
+    uint8_t  column;
+
+    photo_check();
+    reply[0] = stuck_blocked;
+    reply[1] = stuck_clear;
+    reply[2] = photo_blocked();
+
+    now = trace_now();
+    for (column = 0; column < COLUMNS; column++)
+    {
+        __disable_interrupt();
+        count = toggles[column];
+        since = changed_at[column];
+        __enable_interrupt();
+
+        since = (now - since) / (TRACE_TICKS_PER_SECOND / 1000);
+        if (since > 0xFFFF)
+        {
+            since = 0xFFFF;
+        }
+        reply[3 + 4 * column] = count & 0xFF;
+        reply[4 + 4 * column] = count >> 8;
+        reply[5 + 4 * column] = since & 0xFF;
+        reply[6 + 4 * column] = since >> 8;
+    }
+    protocol_send(OP_HEALTH, reply, sizeof(reply));
+}   /* photo_health() */
+
+/*!
+* @brief Picks one column out of the beams a drop broke.
+* @param[in] columns The beams, bit n = column n.
+* @return The highest column. 0-6, 7 if none
+*/
+uint8_t
+photo_column (uint8_t columns)
+{
+    uint8_t position = 0;
+
+    if (!columns)
+    {
+        return NO_CHIP;
+    }
+
+    // Determine position of sensed chip
+    while (columns)
+    {
+        columns = columns >> 1;
+        position++;
+    }
+
+    return (position - 1);
+}   /* photo_column() */
+
+/*!
+* @brief Takes the chip seen since photo_arm(), disarming if there is one.
+* @return The column that the chip was detected in. 0-6, 7 if none yet
+*/
+uint8_t
+photo_take (void)
+{
+    photo_drop_t drop;
+
+    if (!photo_take_drop(&drop))
+    {
+        return NO_CHIP;
+    }
+    photo_disarm();
+
+    return photo_column(drop.columns);
+}   /* photo_take() */
+
 /*!
 * @brief Waits until a chip is detected with photo-interrupters.
 * @param[in] check_timeout Should the function timeout after 5 seconds? 1 = yes, 0 = no
 * @return The column that the chip was detected in. 0-6, 7 if timed out
+*
+* @par
+* Sleeps in power_sleep() until a sensor or the timeout fires. The events they post
+* are left for the scheduler, whose handlers find nothing to take.
 */
 uint8_t
 photo_wait (uint8_t check_timeout)
 {
-    uint8_t sensors      = PHOTO_IN;
-    uint8_t sensors_prev = PHOTO_IN;
-    uint8_t sensors_diff = sensors ^ sensors_prev;
-    uint8_t position     = 0;
-    TA2R = 0x0000; // reset timer counter
+    uint8_t column;
 
-    // Wait until one of the sensors detects a chip
-    while (!(sensors_diff))
+    photo_disarm();
+    photo_arm(check_timeout);
+
+    __disable_interrupt();
+    while ((NO_CHIP == (column = photo_take())) && !(check_timeout && photo_timed_out()))
     {
-        // Detect timeout
-        if (check_timeout && (timeout_cycles <= Timer_A_getCounterValue(TIMER_A2_BASE)))
+        power_sleep();
+    }
+    __enable_interrupt();
+
+    photo_disarm();
+    return column;
+}   /* photo_wait() */
+
+/*!
+* @brief Counts the sensors that changed and queues them if armed. Called
+* from the port ISRs.
+* @param[in] changed Sensors that changed, bit n = column n.
+* @param[in] blocked Of those, the ones now blocked.
+* @return 1 if they were queued, 0 if not.
+*/
+static uint8_t
+photo_record (uint8_t changed, uint8_t blocked)
+{
+    uint32_t now  = trace_now();
+    uint8_t  next = (ring_head + 1) & (RING_SIZE - 1);
+    uint8_t  column;
+
+    for (column = 0; column < COLUMNS; column++)
+    {
+        if (changed & (1 << column))
         {
-            sensors_diff = 0x80;
-            break;
+            toggles[column]++;
+            changed_at[column] = now;
         }
-        sensors_prev = sensors;
-        sensors = PHOTO_IN;
-        sensors_diff = sensors ^ sensors_prev;
     }
 
-    // Determine position of sensed chip
-    while (sensors_diff)
+    if (!armed)
     {
-        sensors_diff = sensors_diff >> 1;
-        position++;
+        return 0;
+    }
+    if (next == ring_tail)
+    {
+        lost++;
+        return 0;
     }
 
-    return (position - 1);
-}
+    ring[ring_head].time    = now;
+    ring[ring_head].changed = changed;
+    ring[ring_head].blocked = blocked;
+    ring_head = next;
+    sched_post(SCHED_EV_CHIP, 0);
+    return 1;
+}   /* photo_record() */
+
+/*!
+* @brief PORT1 interrupt vector ISR
+*
+* @par
+* Records photo-interrupters 6 and 7, waking the CPU if armed. Each pin that fired
+* is then watched for the edge back, and fired again at once if it has
+* already gone back.
+*/
+#pragma vector=PORT1_VECTOR
+__interrupt void
+port1_isr (void)
+{
+    uint8_t flags = P1IFG & PHOTO_P1_PINS;
+    uint8_t level;
+    uint8_t changed;
+
+    P1IFG &= ~flags;
+    level = P1IN & flags;
+    P1IES = (P1IES & ~flags) | level;
+    P1IFG = (P1IFG & ~flags) | ((P1IN & flags) ^ level);
+
+    changed   = (level ^ level_p1) & flags;
+    level_p1 ^= changed;
+    if (changed && photo_record(PHOTO_BITS(changed, 0), PHOTO_BITS(changed & (level ^ idle_p1), 0)))
+    {
+        __bic_SR_register_on_exit(LPM3_bits);
+    }
+}   /* port1_isr() */
+
+/*!
+* @brief PORT2 interrupt vector ISR
+*
+* @par
+* Records photo-interrupters 1 to 5, as port1_isr().
+*/
+#pragma vector=PORT2_VECTOR
+__interrupt void
+port2_isr (void)
+{
+    uint8_t flags = P2IFG & PHOTO_P2_PINS;
+    uint8_t level;
+    uint8_t changed;
+
+    P2IFG &= ~flags;
+    level = P2IN & flags;
+    P2IES = (P2IES & ~flags) | level;
+    P2IFG = (P2IFG & ~flags) | ((P2IN & flags) ^ level);
+
+    changed   = (level ^ level_p2) & flags;
+    level_p2 ^= changed;
+    if (changed && photo_record(PHOTO_BITS(0, changed), PHOTO_BITS(0, changed & (level ^ idle_p2))))
+    {
+        __bic_SR_register_on_exit(LPM3_bits);
+    }
+}   /* port2_isr() */
@@ -6,8 +6,45 @@
 #ifndef PHOTO_H_
 #define PHOTO_H_
 
+// A chip seen by the photo-interrupters
+typedef struct
+{
+    uint32_t    time;       // trace_now() when the first beam broke
+    uint8_t     columns;    // Beams broken together, bit n = column n
+} photo_drop_t;
+
 void photo_init(void);
 
+void photo_start(void);
+
+void photo_arm(uint8_t check_timeout);
+
+void photo_disarm(void);
+
+uint8_t photo_timed_out(void);
+
+void photo_update(void);
+
+uint8_t photo_take_drop(photo_drop_t *drop);
+
+uint8_t photo_column(uint8_t columns);
+
+void photo_filter(const uint8_t *data, uint8_t len);
+
+void photo_missed(uint8_t column);
+
+uint8_t photo_check(void);
+
+uint8_t photo_blocked(void);
+
+void photo_health(void);
+
+uint8_t photo_take(void);
+
 uint8_t photo_wait(uint8_t check_timeout);
 
+__interrupt void port1_isr(void);
+
+__interrupt void port2_isr(void);
+
 #endif /* PHOTO_H_ */
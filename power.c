@@ -0,0 +1,91 @@
+/******************************************************************************/
+
+/** @file power.c
+*
+* @brief This module puts the CPU to sleep in the deepest low-power mode that
+* is safe while it waits.
+*
+* @par
+* LPM3 stops SMCLK and keeps ACLK, so TimerA2 for the scheduler, TimerA3
+* for the trace and the port interrupts keep going, and the UART asks for
+* SMCLK back itself when a byte comes in or goes out. The stepper on
+* TimerA0 and the servo PWM on TimerA1 both run from SMCLK, so the CPU
+* only sleeps in LPM0 while one of them is needed. The servo keeps its PWM
+* for a while after each move, until the horn has caught up, and after that
+* an idle servo is left where it is.
+*
+* @par
+* Every wait goes through power_sleep(), called with interrupts disabled
+* once the waiter has checked there is nothing to do, so an ISR can't slip
+* in between the check and the sleep. ISRs wake the CPU with
+* __bic_SR_register_on_exit(LPM3_bits), which ends either mode.
+*
+* @par
+* Since every wait comes through here, so does every chance to feed the
+* watchdog, and to answer the host's frames while the robot is busy, see
+* protocol_service().
+*/
+
+// Includes
+#include <stdint.h>
+#include "driverlib.h"
+#include "Board.h"
+#include "power.h"
+#include "sched.h"
+#include "stepper.h"
+#include "servo.h"
+#include "watchdog.h"
+#include "protocol.h"
+
+/*!
+* @brief Sleeps until an ISR wakes the CPU, or answers the host's frames
+* first. Called with interrupts disabled, and returns with them disabled.
+*/
+void
+power_sleep (void)
+{
+    watchdog_service();
+
+    // Take the host's bytes instead of sleeping on them. Interrupts come on
+    // meanwhile, so the waiter checks again before it sleeps
+    if (protocol_pending())
+    {
+        __enable_interrupt();
+        protocol_service();
+        __disable_interrupt();
+        return;
+    }
+
+    if (stepper_is_busy() || servo_is_powered())
+    {
+        __bis_SR_register(LPM0_bits | GIE);
+    }
+    else
+    {
+        __bis_SR_register(LPM3_bits | GIE);
+    }
+    __disable_interrupt();
+}   /* power_sleep() */
+
+/*!
+* @brief Sleeps for a while.
+* @param[in] ticks How long, in TimerA2 cycles at 512Hz, up to 32767.
+*
+* @par
+* Runs on the SCHED_TIMER_DELAY software timer, so its expiry is also
+* posted to the scheduler, whose handler ignores it.
+*/
+void
+power_delay (uint16_t ticks)
+{
+    sched_timer_start(SCHED_TIMER_DELAY, ticks);
+
+    __disable_interrupt();
+    while (!sched_timer_expired(SCHED_TIMER_DELAY))
+    {
+        power_sleep();
+    }
+    __enable_interrupt();
+}   /* power_delay() */
+
+/*** end of file ***/
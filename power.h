@@ -0,0 +1,18 @@
+/******************************************************************************/
+
+/** @file power.h
+*
+* @brief This module puts the CPU to sleep in the deepest low-power mode that
+* is safe while it waits.
+*/
+
+#ifndef POWER_H
+#define POWER_H
+
+void power_sleep(void);
+
+void power_delay(uint16_t ticks);
+
+#endif /* POWER_H */
+
+/*** end of file ***/
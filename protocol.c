@@ -0,0 +1,544 @@
+/******************************************************************************/
+
+/** @file protocol.c
+ *
+ * @brief This module frames UART instructions with a sequence number and CRC.
+ *
+ * Frame format:
+ * SOF  LEN  SEQ  OP  DATA[LEN]  CRC_L  CRC_H
+ * A5   n    s    op  ...
+ *
+ * OP is one of the 1 byte instructions listed in uart.c, or ACK (0x06) / NACK
+ * (0x15). The CRC is CRC16-CCITT (CRC-16/CCITT-FALSE: poly 0x1021, seed
+ * 0xFFFF) over LEN to the last data byte, computed by the CRC module.
+ *
+ * Every frame other than ACK/NACK is answered with an ACK carrying its SEQ,
+ * or a NACK if its CRC is bad or it could not be queued. A repeated SEQ is
+ * acknowledged again but not executed twice. Frames sent by the robot are
+ * retransmitted until they are acknowledged or RETRIES runs out.
+ *
+ * Bytes 0x40-0x7F outside a frame are legacy 1 byte instructions. Replies are
+ * framed after a framed instruction and sent bare after a legacy one.
+ *
+ * A frame that goes wrong, with a bad LEN or CRC, may leave bytes that look
+ * like legacy instructions, so after one everything is dropped until the
+ * line has been quiet for UART_IDLE_TICKS, see uart_received_idle(). A frame
+ * that stalls that long is abandoned. Once the host frames, a legacy byte is
+ * only taken if the line was quiet before it, anything else outside a frame
+ * is dropped the same way, and only a legacy start game instruction, @ or G,
+ * goes back to bare replies.
+ *
+ * Whether the host frames and both sequence numbers are kept in FRAM, so
+ * after a reset by a fault protocol_resume() carries on the conversation:
+ * a frame repeated because its ACK was lost to the reset is not executed
+ * twice, and replies go on being framed.
+ */
+
+// Includes
+#include <stdint.h>
+#include "driverlib.h"
+#include "Board.h"
+#include "defines.h"
+#include "uart.h"
+#include "protocol.h"
+#include "sched.h"
+#include "power.h"
+
+#define SOF             0xA5
+#define OP_ACK          0x06
+#define OP_NACK         0x15
+#define QUEUE_SIZE      4       // Received instructions not yet taken, power of 2
+#define ACK_TIMEOUT     52      // TimerA2 cycles at 512Hz, ~100ms
+#define RETRIES         5
+#define LEGACY_ROBOT    0x40    // @, legacy start game, robot first
+#define LEGACY_HUMAN    0x47    // G, legacy start game, human first
+
+typedef enum
+{
+    RX_SOF,
+    RX_LEN,
+    RX_BODY,
+    RX_CRC_L,
+    RX_CRC_H,
+    RX_DISCARD          // Dropping bytes until the line goes quiet
+} rx_state_t;
+
+typedef struct
+{
+    uint8_t op;
+    uint8_t len;
+    uint8_t data[PROTOCOL_MAX_DATA];
+} command_t;
+
+typedef struct
+{
+    uint8_t framed;
+    uint8_t rx_seq;
+    uint8_t rx_seq_valid;
+    uint8_t tx_seq;
+} link_t;
+
+// FRAM, kept through resets and written with FRAMCtl
+#pragma PERSISTENT(link_state)
+static link_t link_state = {0};
+
+// Local variables
+static command_t    queue[QUEUE_SIZE];
+static uint8_t      queue_head      = 0;
+static uint8_t      queue_tail      = 0;
+static rx_state_t   rx_state        = RX_SOF;
+static uint8_t      rx_frame[3 + PROTOCOL_MAX_DATA];   // LEN, SEQ, OP, DATA
+static uint8_t      rx_count        = 0;
+static uint16_t     rx_crc          = 0;
+static uint8_t      rx_seq          = 0;
+static uint8_t      rx_seq_valid    = 0;
+static uint8_t      tx_seq          = 0;
+static uint8_t      tx_reply        = 0;
+static uint8_t      framed          = 0;
+static uint8_t      tx_waiting      = 0;    // protocol_put() asleep on a full transmit buffer
+
+/*!
+ * @brief Copies the link state to FRAM, after any of it changes.
+ */
+static void
+protocol_save (void)
+{
+    link_t now;
+
+    now.framed       = framed;
+    now.rx_seq       = rx_seq;
+    now.rx_seq_valid = rx_seq_valid;
+    now.tx_seq       = tx_seq;
+    FRAMCtl_write8((uint8_t *)&now, (uint8_t *)&link_state, sizeof(now));
+}   /* protocol_save() */
+
+/*!
+ * @brief Takes up the link state from before a reset by a fault, instead of
+ * waiting to learn it from the host again.
+ */
+void
+protocol_resume (void)
+{
+    framed       = link_state.framed;
+    rx_seq       = link_state.rx_seq;
+    rx_seq_valid = link_state.rx_seq_valid;
+    tx_seq       = link_state.tx_seq;
+}   /* protocol_resume() */
+
+/*!
+ * @brief Computes the frame CRC over a header and a payload.
+ * @param[in] head The header bytes.
+ * @param[in] head_len The number of header bytes.
+ * @param[in] data The payload bytes.
+ * @param[in] len The number of payload bytes.
+ * @return The CRC16-CCITT.
+ *
+ * @par
+ * Bytes are written bit reversed so the result matches the usual MSB first
+ * CRC-16/CCITT-FALSE computed by the host.
+ */
+static uint16_t
+protocol_crc (const uint8_t *head, uint8_t head_len, const uint8_t *data, uint8_t len)
+{
+    CRC_setSeed(CRC_BASE, 0xFFFF);
+    while (head_len--)
+    {
+        CRC_set8BitDataReversed(CRC_BASE, *head++);
+    }
+    while (len--)
+    {
+        CRC_set8BitDataReversed(CRC_BASE, *data++);
+    }
+    return CRC_getResult(CRC_BASE);
+}   /* protocol_crc() */
+
+/*!
+ * @brief Queues a byte for transmission, waiting for room if necessary.
+ * @param[in] byte The byte to send.
+ */
+static void
+protocol_put (uint8_t byte)
+{
+    while (!uart_send(byte))
+    {
+        // protocol_service() mustn't write into the middle of this
+        tx_waiting = 1;
+        uart_wait_send();
+        tx_waiting = 0;
+    }
+}   /* protocol_put() */
+
+/*!
+ * @brief Sends one frame.
+ * @param[in] op The instruction, ACK or NACK.
+ * @param[in] seq The sequence number.
+ * @param[in] data The payload.
+ * @param[in] len The number of payload bytes.
+ */
+static void
+protocol_write (uint8_t op, uint8_t seq, const uint8_t *data, uint8_t len)
+{
+    uint8_t  header[3];
+    uint16_t crc;
+    uint8_t  i;
+
+    header[0] = len;
+    header[1] = seq;
+    header[2] = op;
+    crc = protocol_crc(header, 3, data, len);
+
+    protocol_put(SOF);
+    for (i = 0; i < 3; i++)
+    {
+        protocol_put(header[i]);
+    }
+    for (i = 0; i < len; i++)
+    {
+        protocol_put(data[i]);
+    }
+    protocol_put(crc & 0xFF);
+    protocol_put(crc >> 8);
+}   /* protocol_write() */
+
+/*!
+ * @brief Adds a received instruction to the queue.
+ * @param[in] op The instruction.
+ * @param[in] data The payload.
+ * @param[in] len The number of payload bytes.
+ * @return 1 if queued, 0 if the queue is full.
+ *
+ * @par
+ * Posts SCHED_EV_UART, since instructions also arrive while protocol_send()
+ * waits for an ACK, after the event for their bytes has been handled.
+ */
+static uint8_t
+protocol_queue (uint8_t op, const uint8_t *data, uint8_t len)
+{
+    uint8_t next = (queue_head + 1) & (QUEUE_SIZE - 1);
+    uint8_t i;
+
+    if (next == queue_tail)
+    {
+        return 0;
+    }
+
+    queue[queue_head].op  = op;
+    queue[queue_head].len = len;
+    for (i = 0; i < len; i++)
+    {
+        queue[queue_head].data[i] = data[i];
+    }
+    queue_head = next;
+    sched_post(SCHED_EV_UART, 0);
+    return 1;
+}   /* protocol_queue() */
+
+/*!
+ * @brief Handles a complete frame: checks it, acknowledges it and queues it.
+ * @return 1 if it passed its CRC, 0 if it was NACKed for it.
+ */
+static uint8_t
+protocol_accept (void)
+{
+    uint8_t len = rx_frame[0];
+    uint8_t seq = rx_frame[1];
+    uint8_t op  = rx_frame[2];
+
+    if (rx_crc != protocol_crc(rx_frame, 3 + len, 0, 0))
+    {
+        protocol_write(OP_NACK, seq, 0, 0);
+        return 0;
+    }
+    if (!framed)
+    {
+        framed = 1;
+        protocol_save();
+    }
+
+    // Reply to a frame sent by protocol_send()
+    if ((OP_ACK == op) || (OP_NACK == op))
+    {
+        if (seq == tx_seq)
+        {
+            tx_reply = op;
+        }
+        return 1;
+    }
+
+    // Repeat of the last frame because our ACK was lost
+    if (rx_seq_valid && (seq == rx_seq))
+    {
+        protocol_write(OP_ACK, seq, 0, 0);
+        return 1;
+    }
+
+    if (!protocol_queue(op, &rx_frame[3], len))
+    {
+        protocol_write(OP_NACK, seq, 0, 0);
+        return 1;
+    }
+    rx_seq       = seq;
+    rx_seq_valid = 1;
+    protocol_save();
+    protocol_write(OP_ACK, seq, 0, 0);
+    return 1;
+}   /* protocol_accept() */
+
+/*!
+ * @brief Takes a legacy 1 byte instruction received outside a frame.
+ * @param[in] byte The instruction.
+ * @param[in] idle 1 if the line was quiet before it.
+ * @return 1 if it was queued or dropped for a full queue, 0 if it was taken
+ * for the remains of a frame.
+ */
+static uint8_t
+protocol_legacy (uint8_t byte, uint8_t idle)
+{
+    if (framed)
+    {
+        if (!idle)
+        {
+            return 0;
+        }
+
+        // A host starting a game with bare bytes has stopped framing
+        if ((LEGACY_ROBOT == byte) || (LEGACY_HUMAN == byte))
+        {
+            framed = 0;
+            protocol_save();
+        }
+    }
+    protocol_queue(byte, 0, 0);
+    return 1;
+}   /* protocol_legacy() */
+
+/*!
+ * @brief Runs one received byte through the frame parser.
+ * @param[in] byte The received byte.
+ * @param[in] idle 1 if the line was quiet before it, uart_received_idle().
+ */
+static void
+protocol_parse (uint8_t byte, uint8_t idle)
+{
+    // A quiet line ends a frame that stalled part way through, or the
+    // remains of one being dropped
+    if (idle)
+    {
+        rx_state = RX_SOF;
+    }
+
+    switch (rx_state)
+    {
+    case RX_SOF:
+        if (SOF == byte)
+        {
+            rx_state = RX_LEN;
+        }
+        else if (0x40 == (byte & 0xC0)) // 01 header, legacy instruction
+        {
+            if (!protocol_legacy(byte, idle))
+            {
+                rx_state = RX_DISCARD;
+            }
+        }
+        else if (framed)
+        {
+            rx_state = RX_DISCARD;
+        }
+        break;
+
+    case RX_LEN:
+        if (byte > PROTOCOL_MAX_DATA)
+        {
+            rx_state = RX_DISCARD;
+        }
+        else
+        {
+            rx_frame[0] = byte;
+            rx_count    = 1;
+            rx_state    = RX_BODY;
+        }
+        break;
+
+    case RX_BODY:
+        rx_frame[rx_count++] = byte;
+        if ((3 + rx_frame[0]) == rx_count)
+        {
+            rx_state = RX_CRC_L;
+        }
+        break;
+
+    case RX_CRC_L:
+        rx_crc   = byte;
+        rx_state = RX_CRC_H;
+        break;
+
+    case RX_CRC_H:
+        rx_crc  |= (uint16_t)byte << 8;
+        rx_state = protocol_accept() ? RX_SOF : RX_DISCARD;
+        break;
+
+    case RX_DISCARD:
+        break;
+    }
+}   /* protocol_parse() */
+
+/*!
+ * @brief Takes an instruction if one has been received, framed or legacy.
+ * @param[out] op The 1 byte instruction.
+ * @param[out] data The payload, at least PROTOCOL_MAX_DATA bytes, or 0 to ignore it.
+ * @param[out] len The number of payload bytes, or 0 to ignore it.
+ * @return 1 if an instruction was taken, 0 if the received bytes hold none yet.
+ */
+uint8_t
+protocol_poll (uint8_t *op, uint8_t *data, uint8_t *len)
+{
+    command_t   *command;
+    uint8_t     byte;
+    uint8_t     i;
+
+    while (queue_head == queue_tail)
+    {
+        if (!uart_try_receive(&byte))
+        {
+            return 0;
+        }
+        protocol_parse(byte, uart_received_idle());
+    }
+
+    command = &queue[queue_tail];
+    if (data)
+    {
+        for (i = 0; i < command->len; i++)
+        {
+            data[i] = command->data[i];
+        }
+    }
+    if (len)
+    {
+        *len = command->len;
+    }
+    *op = command->op;
+    queue_tail = (queue_tail + 1) & (QUEUE_SIZE - 1);
+
+    return 1;
+}   /* protocol_poll() */
+
+/*!
+ * @brief Checks whether protocol_service() has bytes to take.
+ * @return 1 if bytes are waiting and there is room to queue what they hold,
+ * 0 if not, or if a frame is being written.
+ */
+uint8_t
+protocol_pending (void)
+{
+    return !tx_waiting && (((queue_head + 1) & (QUEUE_SIZE - 1)) != queue_tail) && uart_rx_pending();
+}   /* protocol_pending() */
+
+/*!
+ * @brief Runs the received bytes through the frame parser, acknowledging
+ * frames and queueing their instructions, while there is room for them.
+ *
+ * @par
+ * Called from power_sleep() and the engine's search, so the host's frames
+ * are answered within its ACK timeout however long the robot is busy. The
+ * instructions wait in the queue for the game to take them.
+ */
+void
+protocol_service (void)
+{
+    uint8_t byte;
+
+    while (protocol_pending() && uart_try_receive(&byte))
+    {
+        protocol_parse(byte, uart_received_idle());
+    }
+}   /* protocol_service() */
+
+/*!
+ * @brief Waits until an instruction is received, framed or legacy.
+ * @param[out] data The payload, at least PROTOCOL_MAX_DATA bytes, or 0 to ignore it.
+ * @param[out] len The number of payload bytes, or 0 to ignore it.
+ * @return The 1 byte instruction.
+ */
+uint8_t
+protocol_receive (uint8_t *data, uint8_t *len)
+{
+    uint8_t op;
+
+    while (!protocol_poll(&op, data, len))
+    {
+        uart_wait_receive();
+    }
+
+    return op;
+}   /* protocol_receive() */
+
+/*!
+ * @brief Sends an instruction, framed if the host is using frames.
+ * @param[in] op The 1 byte instruction.
+ * @param[in] data The payload, sent after op in legacy mode.
+ * @param[in] len The number of payload bytes.
+ * @return 1 if sent and acknowledged, 0 if the host never acknowledged it.
+ *
+ * @par
+ * In framed mode this waits for the ACK, retransmitting on NACK or timeout.
+ * Instructions received meanwhile are queued for protocol_receive().
+ */
+uint8_t
+protocol_send (uint8_t op, const uint8_t *data, uint8_t len)
+{
+    uint8_t     tries;
+    uint8_t     byte;
+    uint8_t     idle;
+    uint8_t     received;
+    uint8_t     i;
+
+    if (!framed)
+    {
+        protocol_put(op);
+        for (i = 0; i < len; i++)
+        {
+            protocol_put(data[i]);
+        }
+        return 1;
+    }
+
+    tx_seq++;
+    protocol_save();
+    for (tries = 0; tries <= RETRIES; tries++)
+    {
+        tx_reply = 0;
+        protocol_write(op, tx_seq, data, len);
+
+        sched_timer_start(SCHED_TIMER_ACK, ACK_TIMEOUT);
+        while ((0 == tx_reply) && !sched_timer_expired(SCHED_TIMER_ACK))
+        {
+            // Check and sleep with interrupts off so neither the reply nor
+            // the timeout is missed
+            __disable_interrupt();
+            received = uart_try_receive(&byte);
+            idle     = uart_received_idle();
+            if (!received && !sched_timer_expired(SCHED_TIMER_ACK))
+            {
+                power_sleep();
+            }
+            __enable_interrupt();
+
+            if (received)
+            {
+                protocol_parse(byte, idle);
+            }
+        }
+        sched_timer_stop(SCHED_TIMER_ACK);
+
+        if (OP_ACK == tx_reply)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}   /* protocol_send() */
+
+/*** end of file ***/
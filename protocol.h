@@ -0,0 +1,27 @@
+/******************************************************************************/
+
+/** @file protocol.h
+*
+* @brief This module frames UART instructions with a sequence number and CRC.
+*/
+
+#ifndef PROTOCOL_H_
+#define PROTOCOL_H_
+
+#define PROTOCOL_MAX_DATA   8   // Largest payload accepted from the host
+
+uint8_t protocol_poll(uint8_t *op, uint8_t *data, uint8_t *len);
+
+uint8_t protocol_pending(void);
+
+void protocol_service(void);
+
+uint8_t protocol_receive(uint8_t *data, uint8_t *len);
+
+uint8_t protocol_send(uint8_t op, const uint8_t *data, uint8_t len);
+
+void protocol_resume(void);
+
+#endif /* PROTOCOL_H_ */
+
+/*** end of file ***/
@@ -0,0 +1,241 @@
+/******************************************************************************/
+
+/** @file sched.c
+*
+* @brief This module runs the firmware as run-to-completion event handlers.
+*
+* @par
+* ISRs only record what happened and post an event, then wake the CPU.
+* sched_run() takes the events off the queue one at a time, oldest first,
+* and hands each to the handler, which runs to completion before the next
+* is taken. With the queue empty the CPU sleeps in power_sleep(), which
+* picks LPM0 or LPM3 by whether anything still needs SMCLK.
+*
+* @par
+* TimerA2 counts ACLK / 64 at 512Hz and is the clock for the software
+* timers. Each timer has a deadline, and the CCR1 compare is kept on the
+* earliest one, so timer2_a1_isr() only runs when a timer expires. Timers
+* are good for up to 64 seconds.
+*/
+
+// Includes
+#include <stdint.h>
+#include "driverlib.h"
+#include "Board.h"
+#include "sched.h"
+#include "power.h"
+
+#define QUEUE_SIZE      32      // Events, power of 2
+
+typedef struct
+{
+    uint8_t     event;
+    uint8_t     arg;
+} sched_entry_t;
+
+// Local variables
+static Timer_A_initUpModeParam  param       = {0};
+static volatile sched_entry_t   queue[QUEUE_SIZE];
+static volatile uint8_t         queue_head  = 0;
+static volatile uint8_t         queue_tail  = 0;
+static volatile uint8_t         dropped     = 0;    // Events lost to a full queue
+static uint16_t                 deadlines[SCHED_TIMERS];
+static volatile uint8_t         active      = 0;    // Bit n = timer n running
+static volatile uint8_t         expired     = 0;    // Bit n = timer n ran out
+
+/*!
+* @brief Starts TimerA2 as the scheduler clock.
+*/
+void
+sched_init (void)
+{
+    // Configure TimerA2 in up mode. Cycles at 512Hz.
+    param.clockSource                               = TIMER_A_CLOCKSOURCE_ACLK;
+    param.clockSourceDivider                        = TIMER_A_CLOCKSOURCE_DIVIDER_64;
+    param.timerPeriod                               = 0xFFFF;
+    param.timerInterruptEnable_TAIE                 = TIMER_A_TAIE_INTERRUPT_DISABLE;
+    param.captureCompareInterruptEnable_CCR0_CCIE   = TIMER_A_CCIE_CCR0_INTERRUPT_DISABLE;
+    param.timerClear                                = TIMER_A_DO_CLEAR;
+    param.startTimer                                = true;
+    Timer_A_initUpMode(TIMER_A2_BASE, &param);
+}   /* sched_init() */
+
+/*!
+* @brief Gets the scheduler clock.
+* @return The TimerA2 count, SCHED_TICKS_PER_SECOND.
+*/
+uint16_t
+sched_now (void)
+{
+    return Timer_A_getCounterValue(TIMER_A2_BASE);
+}   /* sched_now() */
+
+/*!
+* @brief Adds an event to the queue. Safe from ISRs, which must then wake
+* the CPU with __bic_SR_register_on_exit(LPM3_bits).
+* @param[in] event The event.
+* @param[in] arg Passed to the handler with it.
+*/
+void
+sched_post (sched_event_t event, uint8_t arg)
+{
+    uint16_t state = __get_interrupt_state();
+    uint8_t  next;
+
+    __disable_interrupt();
+    next = (queue_head + 1) & (QUEUE_SIZE - 1);
+    if (next == queue_tail)
+    {
+        dropped++;
+    }
+    else
+    {
+        queue[queue_head].event = event;
+        queue[queue_head].arg   = arg;
+        queue_head = next;
+    }
+    __set_interrupt_state(state);
+}   /* sched_post() */
+
+/*!
+* @brief Keeps CCR1 on the earliest running timer. Called with interrupts
+* disabled.
+*/
+static void
+sched_arm (void)
+{
+    uint16_t now        = sched_now();
+    uint16_t soonest    = 0xFFFF;
+    uint16_t left;
+    uint8_t  timer;
+
+    if (!active)
+    {
+        Timer_A_disableCaptureCompareInterrupt(TIMER_A2_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_1);
+        return;
+    }
+
+    for (timer = 0; timer < SCHED_TIMERS; timer++)
+    {
+        if (active & (1 << timer))
+        {
+            // Already due, let it fire on the next tick
+            left = ((int16_t)(deadlines[timer] - now) > 0) ? deadlines[timer] - now : 1;
+            if (left < soonest)
+            {
+                soonest = left;
+            }
+        }
+    }
+
+    Timer_A_setCompareValue(TIMER_A2_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_1, now + soonest);
+    Timer_A_clearCaptureCompareInterrupt(TIMER_A2_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_1);
+    Timer_A_enableCaptureCompareInterrupt(TIMER_A2_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_1);
+}   /* sched_arm() */
+
+/*!
+* @brief Starts a software timer, or restarts it if it is running.
+* @param[in] timer The timer.
+* @param[in] ticks How long until it posts SCHED_EV_TIMER, up to 32767.
+*/
+void
+sched_timer_start (sched_timer_t timer, uint16_t ticks)
+{
+    uint16_t state = __get_interrupt_state();
+
+    __disable_interrupt();
+    deadlines[timer] = sched_now() + ticks;
+    active  |= 1 << timer;
+    expired &= ~(1 << timer);
+    sched_arm();
+    __set_interrupt_state(state);
+}   /* sched_timer_start() */
+
+/*!
+* @brief Stops a software timer and forgets that it expired. An event it
+* already posted is still delivered, so handlers check sched_timer_expired().
+* @param[in] timer The timer.
+*/
+void
+sched_timer_stop (sched_timer_t timer)
+{
+    uint16_t state = __get_interrupt_state();
+
+    __disable_interrupt();
+    active  &= ~(1 << timer);
+    expired &= ~(1 << timer);
+    sched_arm();
+    __set_interrupt_state(state);
+}   /* sched_timer_stop() */
+
+/*!
+* @brief Checks whether a software timer has run out since it was started.
+* @param[in] timer The timer.
+* @return 1 if it has expired, 0 if it is running or stopped.
+*/
+uint8_t
+sched_timer_expired (sched_timer_t timer)
+{
+    return (expired >> timer) & 1;
+}   /* sched_timer_expired() */
+
+/*!
+* @brief Runs the handler for every event as it comes in. Never returns.
+* @param[in] handler Called with each event, in the order they were posted.
+*/
+void
+sched_run (sched_handler_t handler)
+{
+    sched_event_t event;
+    uint8_t       arg;
+
+    for (;;)
+    {
+        // Check and sleep with interrupts off so no event is missed between them
+        __disable_interrupt();
+        if (queue_head == queue_tail)
+        {
+            power_sleep();
+            continue;
+        }
+
+        event = (sched_event_t)queue[queue_tail].event;
+        arg   = queue[queue_tail].arg;
+        queue_tail = (queue_tail + 1) & (QUEUE_SIZE - 1);
+        __enable_interrupt();
+
+        handler(event, arg);
+    }
+}   /* sched_run() */
+
+/*!
+* @brief TIMER2_A3 interrupt vector ISR
+*
+* @par
+* Triggers on the CCR1 compare when the earliest software timer runs out.
+* Posts SCHED_EV_TIMER for every timer that is due and rearms for the next.
+*/
+#pragma vector=TIMER2_A1_VECTOR
+__interrupt void
+timer2_a1_isr (void)
+{
+    uint16_t now = sched_now();
+    uint8_t  timer;
+
+    Timer_A_clearCaptureCompareInterrupt(TIMER_A2_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_1);
+
+    for (timer = 0; timer < SCHED_TIMERS; timer++)
+    {
+        if ((active & (1 << timer)) && ((int16_t)(now - deadlines[timer]) >= 0))
+        {
+            active  &= ~(1 << timer);
+            expired |= 1 << timer;
+            sched_post(SCHED_EV_TIMER, timer);
+        }
+    }
+    sched_arm();
+
+    __bic_SR_register_on_exit(LPM3_bits);
+}   /* timer2_a1_isr() */
+
+/*** end of file ***/
@@ -0,0 +1,56 @@
+/******************************************************************************/
+
+/** @file sched.h
+*
+* @brief This module runs the firmware as run-to-completion event handlers.
+*/
+
+#ifndef SCHED_H
+#define SCHED_H
+
+#define SCHED_TICKS_PER_SECOND  512
+
+// Events posted by the ISRs, the argument is noted
+typedef enum
+{
+    SCHED_EV_UART,      // Bytes received, 0
+    SCHED_EV_STEPPER,   // Move or homing done, 0
+    SCHED_EV_APPROACH,  // Move nearly done, 0
+    SCHED_EV_SERVO,     // Servo move done, 0
+    SCHED_EV_CHIP,      // Photo-interrupter changed, or a drop is due to be decided, 0
+    SCHED_EV_TIMER      // Software timer expired, sched_timer_t
+} sched_event_t;
+
+// Software timers
+typedef enum
+{
+    SCHED_TIMER_PHOTO,  // Photo-interrupter timeout
+    SCHED_TIMER_HINT,   // Host's time to hint before the carriage heads for the center
+    SCHED_TIMER_DELAY,  // power_delay()
+    SCHED_TIMER_RELOAD, // Next chip loading during jam recovery or calibration
+    SCHED_TIMER_ACK,    // Framed message waiting for its acknowledgement
+    SCHED_TIMER_WATCHDOG,   // Round of watchdog check-ins
+    SCHED_TIMERS
+} sched_timer_t;
+
+typedef void (*sched_handler_t)(sched_event_t event, uint8_t arg);
+
+void sched_init(void);
+
+uint16_t sched_now(void);
+
+void sched_post(sched_event_t event, uint8_t arg);
+
+void sched_timer_start(sched_timer_t timer, uint16_t ticks);
+
+void sched_timer_stop(sched_timer_t timer);
+
+uint8_t sched_timer_expired(sched_timer_t timer);
+
+void sched_run(sched_handler_t handler);
+
+__interrupt void timer2_a1_isr(void);
+
+#endif /* SCHED_H */
+
+/*** end of file ***/
@@ -3,6 +3,18 @@
 /** @file servo.c
 *
 * @brief This module provides control functions for the servo motor.
+*
+* @par
+* The servo is moved along a ramp rather than jumped to its new position, so
+* the dispenser doesn't slam into its end stops and bounce a second chip
+* out. timer1_a1_isr() runs at the start of every 20ms PWM period and moves
+* the CCR2 duty up to rate counts closer to the target, so the new pulse
+* width takes effect from that period on.
+*
+* @par
+* The interlock holds an extending dispenser at SERVO_HOLD_DUTY, just short
+* of where the chip drops, so it can start extending while the carriage is
+* still on its way and only release the chip once the carriage is there.
 */
 
 // Includes
@@ -11,15 +23,23 @@
 #include "Board.h"
 #include "servo.h"
 #include "defines.h"
+#include "power.h"
+#include "watchdog.h"
 
 // Local variables
-static Timer_A_outputPWMParam param = {0};
+static Timer_A_outputPWMParam   param       = {0};
+static volatile uint8_t         busy        = 0;
+static servo_callback_t         callback    = 0;
+static uint16_t                 target      = SERVO_MAX_DUTY;
+static uint16_t                 step        = 0;    // Duty counts per PWM period
+static volatile uint8_t         locked      = 0;    // Interlock holding the chip
+static volatile uint8_t         settling    = 0;    // PWM periods left for the horn to catch up
 
 /*!
 * @brief Initializes TimerA1 to be used for PWM output for the servo motor.
 *
 * @par
-* PWM output should be on TA1.1 = P1.5.
+* PWM output should be on TA1.2 = P1.4. The servo starts retracted.
 */
 void
 servo_init (void)
@@ -40,41 +60,220 @@ servo_init (void)
         );
 
     Timer_A_outputPWM(TIMER_A1_BASE, &param);
-    //Timer_A_enableInterrupt(TIMER_A1_BASE);
+
+    // Give the horn time to get to the start position from wherever it
+    // was left, which after a reset may be the other end
+    settling = SERVO_TRAVEL_PERIODS;
+    watchdog_expect(WATCHDOG_SERVO, 1);
+    Timer_A_clearTimerInterrupt(TIMER_A1_BASE);
+    Timer_A_enableInterrupt(TIMER_A1_BASE);
 }   /* servo_init() */
 
 /*!
-* @brief Writes the servo to its minimum position. OUT
+* @brief Sets a function to be called when a move completes.
+* @param[in] function The callback, or 0 for none.
+* @par
+* The callback runs from timer1_a1_isr, so it should only set flags or start
+* other short work.
+*/
+void
+servo_set_callback (servo_callback_t function)
+{
+    callback = function;
+}   /* servo_set_callback() */
+
+/*!
+* @brief Checks whether a move is still running.
+* @return 1 if the servo is moving, 0 if it has reached its target.
+*/
+uint8_t
+servo_is_busy (void)
+{
+    return busy;
+}   /* servo_is_busy() */
+
+/*!
+* @brief Checks whether the servo still needs its PWM.
+* @return 1 if it is moving or catching up with its last move, 0 if it can
+* be left without pulses.
+*
+* @par
+* The PWM runs from SMCLK, which stops in LPM3. The horn lags the pulse
+* width, so it gets SERVO_SETTLE_PERIODS more periods once the duty is on
+* target.
+*/
+uint8_t
+servo_is_powered (void)
+{
+    return busy || settling;
+}   /* servo_is_powered() */
+
+/*!
+* @brief Waits until any move in progress has completed.
+*/
+void
+servo_wait (void)
+{
+    // Check and sleep with interrupts off so the completion can't be missed
+    __disable_interrupt();
+    while (busy)
+    {
+        power_sleep();
+    }
+    __enable_interrupt();
+}   /* servo_wait() */
+
+/*!
+* @brief Waits until the horn has caught up with the PWM, as well as any
+* move in progress.
+*/
+void
+servo_settle (void)
+{
+    __disable_interrupt();
+    while (busy || settling)
+    {
+        power_sleep();
+    }
+    __enable_interrupt();
+}   /* servo_settle() */
+
+/*!
+* @brief Engages or lifts the release interlock.
+* @param[in] lock 1 to stop extending at SERVO_HOLD_DUTY, 0 to let the chip go.
+* @par
+* A move held by the interlock stays busy, so don't servo_wait() on one.
+*/
+void
+servo_set_interlock (uint8_t lock)
+{
+    locked = lock;
+}   /* servo_set_interlock() */
+
+/*!
+* @brief Starts moving the servo and returns without waiting for it to
+* arrive.
+* @param[in] duty The target CCR2 duty, SERVO_MIN_DUTY to SERVO_MAX_DUTY.
+* @param[in] rate The most the duty changes per 20ms PWM period, 0 to jump
+* straight to the target.
+* @par
+* A move already in progress is taken over from wherever it has got to.
+* Completion is signalled through servo_is_busy() and the
+* servo_set_callback() callback.
+*/
+void
+servo_move_async (uint16_t duty, uint16_t rate)
+{
+    if (duty < SERVO_MIN_DUTY)
+    {
+        duty = SERVO_MIN_DUTY;
+    }
+    else if (duty > SERVO_MAX_DUTY)
+    {
+        duty = SERVO_MAX_DUTY;
+    }
+
+    Timer_A_disableInterrupt(TIMER_A1_BASE);
+    target  = duty;
+    step    = rate ? rate : SERVO_MAX_DUTY;
+    busy    = 1;
+
+    // The ramp starts on the next period
+    watchdog_expect(WATCHDOG_SERVO, 1);
+    Timer_A_clearTimerInterrupt(TIMER_A1_BASE);
+    Timer_A_enableInterrupt(TIMER_A1_BASE);
+}   /* servo_move_async() */
+
+/*!
+* @brief Moves the servo and waits for it to arrive.
+* @param[in] duty The target CCR2 duty, SERVO_MIN_DUTY to SERVO_MAX_DUTY.
+* @param[in] rate The most the duty changes per 20ms PWM period, 0 to jump.
+*/
+void
+servo_move_to (uint16_t duty, uint16_t rate)
+{
+    servo_move_async(duty, rate);
+    servo_wait();
+}   /* servo_move_to() */
+
+/*!
+* @brief Starts the servo towards its minimum position. OUT
 */
 void
 servo_write_min (void)
 {
-    param.dutyCycle = SERVO_MIN_DUTY;
-    Timer_A_outputPWM(TIMER_A1_BASE, &param);
+    servo_move_async(SERVO_MIN_DUTY, SERVO_RATE);
 }   /* servo_write_min() */
 
 /*!
-* @brief Writes the servo to its maximum position. IN
+* @brief Starts the servo towards its maximum position. IN
 */
 void
 servo_write_max (void)
 {
-    param.dutyCycle = SERVO_MAX_DUTY;
-    Timer_A_outputPWM(TIMER_A1_BASE, &param);
+    servo_move_async(SERVO_MAX_DUTY, SERVO_RATE);
 }   /* servo_write_max() */
 
 /*!
 * @brief TIMER1_A3 interrupt vector ISR
 *
 * @par
-* Should trigger when timer counts to 0.
+* Triggers when the timer counts to 0, at the start of each PWM period.
+* Moves the duty one step along the ramp and stops once it is on target.
+* While the interlock is engaged it waits at SERVO_HOLD_DUTY instead.
 */
 #pragma vector=TIMER1_A1_VECTOR
 __interrupt void
-timer1_a1_isr(void)
+timer1_a1_isr (void)
 {
+    uint16_t goal = target;
+
     // Clear interrupt flag
-    Timer_A_clearTimerInterrupt(TIMER_A0_BASE);
+    Timer_A_clearTimerInterrupt(TIMER_A1_BASE);
+    watchdog_check_in(WATCHDOG_SERVO);
+
+    if (locked && (goal < SERVO_HOLD_DUTY))
+    {
+        goal = SERVO_HOLD_DUTY;
+    }
+
+    if (param.dutyCycle + step < goal)
+    {
+        param.dutyCycle += step;
+    }
+    else if (param.dutyCycle > goal + step)
+    {
+        param.dutyCycle -= step;
+    }
+    else
+    {
+        param.dutyCycle = goal;
+    }
+    Timer_A_setCompareValue(TIMER_A1_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_2, param.dutyCycle);
+
+    if ((param.dutyCycle == target) && busy)
+    {
+        busy        = 0;
+        if (settling < SERVO_SETTLE_PERIODS)
+        {
+            settling = SERVO_SETTLE_PERIODS;
+        }
+        if (callback)
+        {
+            callback();
+        }
+
+        // Wake the CPU in case it sleeps until the move is done
+        __bic_SR_register_on_exit(LPM3_bits);
+    }
+    else if ((param.dutyCycle == target) && (0 == --settling))
+    {
+        Timer_A_disableInterrupt(TIMER_A1_BASE);
+        watchdog_expect(WATCHDOG_SERVO, 0);
+
+        // The CPU can do without SMCLK now
+        __bic_SR_register_on_exit(LPM3_bits);
+    }
 }   /* timer1_a1_isr() */
 
 /*** end of file ***/
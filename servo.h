@@ -8,8 +8,26 @@
 #ifndef SERVO_H
 #define SERVO_H
 
+typedef void (*servo_callback_t)(void);
+
 void servo_init(void);
 
+void servo_set_callback(servo_callback_t function);
+
+uint8_t servo_is_busy(void);
+
+uint8_t servo_is_powered(void);
+
+void servo_wait(void);
+
+void servo_settle(void);
+
+void servo_set_interlock(uint8_t lock);
+
+void servo_move_async(uint16_t duty, uint16_t rate);
+
+void servo_move_to(uint16_t duty, uint16_t rate);
+
 void servo_write_min(void);
 
 void servo_write_max(void);
@@ -0,0 +1,135 @@
+/******************************************************************************/
+
+/** @file state.c
+*
+* @brief This module keeps the game's state in FRAM so a reset can resume it.
+*
+* @par
+* There are two records, each with a sequence number and a CRC from the CRC
+* module. A save always overwrites the older one, so a reset part way
+* through leaves the newer one intact, and the torn record fails its CRC.
+* state_load() takes the valid record with the highest sequence number.
+*
+* @par
+* The carriage position is only worth keeping while the carriage stands
+* still. The stepper calls state_moving() before every move, which clears
+* the record's carriage flag, and the game saves the new position once the
+* move is over.
+*/
+
+// Includes
+#include <stdint.h>
+#include "driverlib.h"
+#include "Board.h"
+#include "state.h"
+
+typedef struct
+{
+    uint16_t    seq;            // Higher is newer, wrapping
+    state_t     state;
+    uint16_t    crc;            // CRC16-CCITT over seq and state
+} state_record_t;
+
+// FRAM, kept through resets and written with FRAMCtl
+#pragma PERSISTENT(records)
+static state_record_t records[2] = {0};
+
+// Local variables
+static uint8_t newest = 1;      // Record last written, the other is next
+
+/*!
+* @brief Computes the CRC a record should carry.
+* @param[in] record The record.
+* @return The CRC16-CCITT over everything but the CRC itself.
+*/
+static uint16_t
+state_crc (const state_record_t *record)
+{
+    const uint8_t *byte = (const uint8_t *)record;
+    uint16_t       i;
+
+    CRC_setSeed(CRC_BASE, 0xFFFF);
+    for (i = 0; i < sizeof(*record) - sizeof(record->crc); i++)
+    {
+        CRC_set8BitData(CRC_BASE, byte[i]);
+    }
+    return CRC_getResult(CRC_BASE);
+}   /* state_crc() */
+
+/*!
+* @brief Finds the newest valid record. Call once at power up, before the
+* carriage moves.
+* @param[out] state The state it holds.
+* @return 1 if there was one, 0 if neither record is valid.
+*/
+uint8_t
+state_load (state_t *state)
+{
+    uint8_t valid = 0;
+    uint8_t i;
+
+    for (i = 0; i < 2; i++)
+    {
+        if (state_crc(&records[i]) == records[i].crc)
+        {
+            valid |= 1 << i;
+        }
+    }
+
+    if (!valid)
+    {
+        newest = 1;
+        return 0;
+    }
+
+    if (3 == valid)
+    {
+        newest = ((int16_t)(records[1].seq - records[0].seq) > 0) ? 1 : 0;
+    }
+    else
+    {
+        newest = valid >> 1;
+    }
+
+    *state = records[newest].state;
+    return 1;
+}   /* state_load() */
+
+/*!
+* @brief Saves the state over the older record.
+* @param[in] state The state.
+*/
+void
+state_save (const state_t *state)
+{
+    state_record_t record;
+    uint8_t        next = newest ^ 1;
+
+    record.seq   = records[newest].seq + 1;
+    record.state = *state;
+    record.crc   = state_crc(&record);
+
+    FRAMCtl_write8((uint8_t *)&record, (uint8_t *)&records[next], sizeof(record));
+    newest = next;
+}   /* state_save() */
+
+/*!
+* @brief Marks the saved carriage position out of date, the carriage is
+* about to move.
+*/
+void
+state_moving (void)
+{
+    state_t state;
+
+    if ((state_crc(&records[newest]) != records[newest].crc) || !records[newest].state.carriage)
+    {
+        return;
+    }
+
+    state = records[newest].state;
+    state.carriage = 0;
+    state_save(&state);
+}   /* state_moving() */
+
+/*** end of file ***/
@@ -0,0 +1,37 @@
+/******************************************************************************/
+
+/** @file state.h
+*
+* @brief This module keeps the game's state in FRAM so a reset can resume it.
+*/
+
+#ifndef STATE_H
+#define STATE_H
+
+#define STATE_MOVES     42      // Chips on a full board
+
+typedef struct
+{
+    uint8_t     phase;          // Where the game was, game_state_t in main.c
+    uint8_t     turn;           // turn_t
+    uint8_t     robot_column;   // The robot's column this turn
+    uint8_t     robot_turns;    // Robot turns since the carriage was homed
+    uint8_t     dispenser;      // 1 if the dispenser was out
+    uint8_t     missed;         // 1 if the robot's chip has gone unseen
+    uint8_t     error_sent;     // 1 if an error was sent for it
+    uint8_t     carriage;       // 1 if the carriage stood still at position
+    int16_t     position;       // Carriage position in steps away from home
+    uint8_t     commands;       // Game instructions taken, uart_get_taken()
+    uint8_t     moves;          // Chips played
+    uint8_t     history[STATE_MOVES];   // Columns played, in turn order
+} state_t;
+
+uint8_t state_load(state_t *state);
+
+void state_save(const state_t *state);
+
+void state_moving(void);
+
+#endif /* STATE_H */
+
+/*** end of file ***/
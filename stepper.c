@@ -11,11 +11,76 @@
 #include "Board.h"
 #include "stepper.h"
 #include "defines.h"
+#include "power.h"
+#include "state.h"
+#include "watchdog.h"
+
+// Step periods are kept in timer counts with 8 fractional bits
+#define PERIOD_SHIFT            8
+
+// Homing phases, sequenced from timer0_a1_isr
+typedef enum
+{
+    HOME_IDLE,
+    HOME_SEEK,
+    HOME_BACKOFF,
+    HOME_APPROACH
+} home_phase_t;
+
+typedef struct
+{
+    int16_t     position;       // Where the carriage stood, or set out from
+    uint8_t     moving;         // 1 from the start of a move until it completes
+} stepper_mirror_t;
+
+// FRAM, kept through resets and written with FRAMCtl. Written as each move
+// starts and completes, for a reset part way through one
+#pragma PERSISTENT(last)
+static stepper_mirror_t last = {0};
 
 // Local variables
-static uint16_t                 count = 0;
+static volatile uint16_t        count = 0;
+static volatile uint8_t         busy = 0;
+static stepper_callback_t       callback = 0;
+static stepper_callback_t       approach = 0;           // Called once a move is nearly done
+static uint16_t                 approach_steps = 0;
 static Timer_A_outputPWMParam   param = {0};
 
+// Carriage position in steps away from the bump switch
+static volatile int16_t         position    = 0;
+static int8_t                   direction   = 0;
+static uint8_t                  stop_on_bump = 0;
+static uint8_t                  stop_on_release = 0;
+static volatile uint8_t         bumped      = 0;    // The switch stopped the move, or is still pressed backing off
+static uint8_t                  home_failed = 0;    // The last homing never found the switch
+static home_phase_t             home_phase  = HOME_IDLE;
+
+// Motion profile
+static uint16_t                 max_speed       = STEPPER_MAX_SPEED;
+static uint16_t                 acceleration    = STEPPER_ACCELERATION;
+static uint16_t                 total_steps     = 0;
+static uint16_t                 ramp_steps      = 0;
+static uint16_t                 ramp_index      = 0;
+static uint32_t                 period          = 0;
+static uint32_t                 min_period      = 0;
+static uint32_t                 max_period      = 0;
+
+static void stepper_finish(void);
+
+/*!
+* @brief Copies the position to FRAM.
+* @param[in] moving 1 as a move starts, 0 once the carriage stands still.
+*/
+static void
+stepper_mirror (uint8_t moving)
+{
+    stepper_mirror_t now;
+
+    now.position = position;
+    now.moving   = moving;
+    FRAMCtl_write8((uint8_t *)&now, (uint8_t *)&last, sizeof(now));
+}   /* stepper_mirror() */
+
 /*!
 * @brief Initializes TimerA0 to be used for PWM output for the stepper motor.
 * Stepper is off by default.
@@ -85,34 +150,404 @@ stepper_disable (void)
 }
 
 /*!
-* @brief Send a number of steps to the stepper motor.
+* @brief Sets the motion profile used by later moves.
+* @param[in] speed The cruise speed in steps/s, STEPPER_SPEED_MIN to
+* STEPPER_SPEED_LIMIT.
+* @param[in] accel The acceleration and deceleration in steps/s^2, at least
+* STEPPER_ACCEL_MIN.
+* @return 1 if it was taken, 0 if either is out of range and the profile was
+* left as it was.
+* @par
+* Moves start at STEPPER_START_SPEED, accelerate up to speed, cruise, and
+* decelerate back down to STEPPER_START_SPEED for the last step. A speed at or
+* below STEPPER_START_SPEED runs the whole move at that constant speed.
+* Homing keeps its own speeds but ramps with accel. The profile is not kept
+* through a reset.
+*/
+uint8_t
+stepper_set_profile (uint16_t speed, uint16_t accel)
+{
+    if ((speed < STEPPER_SPEED_MIN) || (speed > STEPPER_SPEED_LIMIT) || (accel < STEPPER_ACCEL_MIN))
+    {
+        return 0;
+    }
+
+    max_speed       = speed;
+    acceleration    = accel;
+    return 1;
+}   /* stepper_set_profile() */
+
+/*!
+* @brief Gets the motion profile moves run with.
+* @param[out] speed The cruise speed in steps/s.
+* @param[out] accel The acceleration in steps/s^2.
+*/
+void
+stepper_get_profile (uint16_t *speed, uint16_t *accel)
+{
+    *speed = max_speed;
+    *accel = acceleration;
+}   /* stepper_get_profile() */
+
+/*!
+* @brief Starts PWM output for a number of steps without waiting for them.
 * @param[in] num The number of steps to be run.
 * @param[in] dir The direction the motor should spin. 1 or 0
+* @param[in] speed The cruise speed in steps/s.
 * @par
-* This function can only be run after stepper_init() is run.
+* A move of 0 steps finishes straight away.
 */
-void
-stepper_send_steps (uint16_t num, uint8_t dir)
+static void
+stepper_start (uint16_t num, uint8_t dir, uint16_t speed)
 {
+    uint16_t start_speed = STEPPER_START_SPEED;
+    uint32_t start_index;
+    uint32_t cruise_index;
+
+    if (0 == num)
+    {
+        stepper_finish();
+        return;
+    }
+
+    if (speed < start_speed)
+    {
+        start_speed = speed;
+    }
+
+    // Austin's ramp: the nth step of a ramp from standstill is
+    // c(n) = c(n-1) - 2c(n-1)/(4n+1), and speed v is reached at n = v^2/2a
+    start_index  = ((uint32_t)start_speed * start_speed) / (2 * (uint32_t)acceleration);
+    cruise_index = ((uint32_t)speed * speed) / (2 * (uint32_t)acceleration);
+    if (0 == start_index)
+    {
+        start_index = 1;
+    }
+
+    ramp_steps = 0;
+    if (cruise_index > start_index)
+    {
+        ramp_steps = (cruise_index - start_index > (num >> 1)) ? (num >> 1) : (uint16_t)(cruise_index - start_index);
+    }
+    ramp_index  = start_index;
+    total_steps = num;
+    max_period  = ((uint32_t)STEPPER_TIMER_FREQUENCY << PERIOD_SHIFT) / start_speed;
+    min_period  = ((uint32_t)STEPPER_TIMER_FREQUENCY << PERIOD_SHIFT) / speed;
+    period      = max_period;
+
+    param.timerPeriod   = (max_period >> PERIOD_SHIFT) - 1;
+    param.dutyCycle     = param.timerPeriod >> 1;
+
     // Change direction according to parameter
     if (dir)
     {
         GPIO_setOutputHighOnPin(DIR_PORT, DIR_PIN);
+        direction = 1;
     }
     else
     {
         GPIO_setOutputLowOnPin(DIR_PORT, DIR_PIN);
+        direction = -1;
     }
 
     // Change count to number of steps and start PWM output
     count = num;
+    watchdog_expect(WATCHDOG_STEPPER, 1);
     Timer_A_outputPWM(TIMER_A0_BASE, &param);
     Timer_A_enableInterrupt(TIMER_A0_BASE);
+}   /* stepper_start() */
+
+/*!
+* @brief Calls the approach callback, once.
+*/
+static void
+stepper_approach (void)
+{
+    stepper_callback_t function = approach;
+
+    approach = 0;
+    if (function)
+    {
+        function();
+    }
+}   /* stepper_approach() */
+
+/*!
+* @brief Marks the motion complete and raises the completion callback.
+*/
+static void
+stepper_complete (void)
+{
+    stepper_mirror(0);
+    busy = 0;
+    watchdog_expect(WATCHDOG_STEPPER, 0);
+    stepper_approach();
+    if (callback)
+    {
+        callback();
+    }
+}   /* stepper_complete() */
+
+/*!
+* @brief Ends homing, zeroing the position only if the switch was found.
+* @param[in] found 1 if the bump switch stopped the last phase.
+*/
+static void
+stepper_home_done (uint8_t found)
+{
+    home_phase      = HOME_IDLE;
+    stop_on_bump    = 0;
+    stop_on_release = 0;
+    home_failed     = !found;
+    if (found)
+    {
+        position = 0;
+    }
+    stepper_complete();
+}   /* stepper_home_done() */
+
+/*!
+* @brief Called when a move runs out of steps. Starts the next homing phase,
+* or marks the motion complete and raises the completion callback.
+*/
+static void
+stepper_finish (void)
+{
+    switch (home_phase)
+    {
+    case HOME_SEEK:
+        if (!bumped)
+        {
+            // Ran the whole travel without finding the switch
+            stepper_home_done(0);
+            break;
+        }
+
+        // Back off until the switch is released
+        home_phase      = HOME_BACKOFF;
+        stop_on_bump    = 0;
+        stop_on_release = 1;
+        stepper_start(STEPPER_HOME_BACKOFF_STEPS, 1, STEPPER_START_SPEED);
+        break;
+
+    case HOME_BACKOFF:
+        if (bumped)
+        {
+            // Still pressed after the whole backoff, the switch is stuck
+            stepper_home_done(0);
+            break;
+        }
+
+        // Re-approach slowly
+        home_phase      = HOME_APPROACH;
+        stop_on_release = 0;
+        stop_on_bump    = 1;
+        bumped          = 0;
+        stepper_start(2 * STEPPER_HOME_BACKOFF_STEPS, 0, STEPPER_HOME_APPROACH_SPEED);
+        break;
+
+    case HOME_APPROACH:
+        stepper_home_done(bumped);
+        break;
+
+    default:
+        stepper_complete();
+        break;
+    }
+}   /* stepper_finish() */
+
+/*!
+* @brief Sets a function to be called when a move or homing completes.
+* @param[in] function The callback, or 0 for none.
+* @par
+* The callback runs from timer0_a1_isr, so it should only set flags or start
+* other short work. A move of 0 steps calls it from the caller instead.
+*/
+void
+stepper_set_callback (stepper_callback_t function)
+{
+    callback = function;
+}   /* stepper_set_callback() */
+
+/*!
+* @brief Sets a function to be called once the move under way, or the next
+* one, has a number of steps left to run.
+* @param[in] steps The steps left when it is called.
+* @param[in] function The callback, or 0 to cancel it.
+* @par
+* Lets other motion start while the carriage is still decelerating. The
+* callback runs from timer0_a1_isr, on the first step if the move is
+* shorter, and always before the completion callback. Homing cancels it.
+*/
+void
+stepper_set_approach (uint16_t steps, stepper_callback_t function)
+{
+    uint16_t state = __get_interrupt_state();
+
+    __disable_interrupt();
+    approach_steps = steps;
+    approach       = function;
+    __set_interrupt_state(state);
+}   /* stepper_set_approach() */
+
+/*!
+* @brief Checks whether a move or homing is still running.
+* @return 1 if the carriage is moving, 0 if it is idle.
+*/
+uint8_t
+stepper_is_busy (void)
+{
+    return busy;
+}   /* stepper_is_busy() */
+
+/*!
+* @brief Waits until any move or homing in progress has completed.
+*/
+void
+stepper_wait (void)
+{
+    // Check and sleep with interrupts off so the completion can't be missed
+    __disable_interrupt();
+    while (busy)
+    {
+        power_sleep();
+    }
+    __enable_interrupt();
+}   /* stepper_wait() */
+
+/*!
+* @brief Starts moving the carriage to an absolute position and returns
+* without waiting for it to arrive.
+* @param[in] target The position in steps away from home.
+* @par
+* This function can only be run after stepper_go_home() has established the
+* home position. Any move already in progress is finished first. Completion
+* is signalled through stepper_is_busy() and the stepper_set_callback()
+* callback.
+*/
+void
+stepper_move_async (int16_t target)
+{
+    int16_t distance;
+
+    stepper_wait();
+    state_moving();
+    stepper_mirror(1);
+    busy = 1;
+
+    distance = target - position;
+    if (distance >= 0)
+    {
+        stepper_start(distance, 1, max_speed);
+    }
+    else
+    {
+        stepper_start(-distance, 0, max_speed);
+    }
+}   /* stepper_move_async() */
+
+/*!
+* @brief Moves the carriage to an absolute position.
+* @param[in] target The position in steps away from home.
+* @par
+* This function can only be run after stepper_go_home() has established the
+* home position.
+*/
+void
+stepper_move_to (int16_t target)
+{
+    stepper_move_async(target);
+    stepper_wait();
+}   /* stepper_move_to() */
+
+/*!
+* @brief Gets the current carriage position.
+* @return The position in steps away from home.
+*/
+int16_t
+stepper_get_position (void)
+{
+    return position;
+}   /* stepper_get_position() */
+
+/*!
+* @brief Sets the carriage position without moving, for a position known
+* from before a reset.
+* @param[in] known The position in steps away from home.
+*/
+void
+stepper_set_position (int16_t known)
+{
+    position = known;
+    stepper_mirror(0);
+}   /* stepper_set_position() */
 
-    // Wait until all steps have been run before executing other code
-    while (0 != count);
+/*!
+* @brief Takes up the position the carriage stood at when the MCU reset.
+* @return 1 if it was standing still, 0 if the reset caught it moving and
+* the position is lost, home it.
+* @par
+* Only for a reset by a fault, which stops the driver where it was.
+*/
+uint8_t
+stepper_recover (void)
+{
+    if (last.moving)
+    {
+        return 0;
+    }
 
-}   /* stepper_send_steps() */
+    position = last.position;
+    return 1;
+}   /* stepper_recover() */
+
+/*!
+* @brief Checks how the last homing went.
+* @return 1 if it never found the bump switch and left the position as it
+* was, 0 if it zeroed the position or there hasn't been one.
+*/
+uint8_t
+stepper_home_failed (void)
+{
+    return home_failed;
+}   /* stepper_home_failed() */
+
+/*!
+* @brief Starts homing and returns without waiting for it to complete.
+* @par
+* This function can only be run after stepper_init() is run. The carriage
+* seeks the switch at STEPPER_HOME_SEEK_SPEED, backs off until it releases,
+* and re-approaches at STEPPER_HOME_APPROACH_SPEED so the zero does not
+* depend on how hard the seek hit the switch. The position is zeroed once
+* the switch is pressed. The phases are sequenced from timer0_a1_isr. A
+* seek that runs STEPPER_HOME_MAX_STEPS, or an approach that runs twice
+* STEPPER_HOME_BACKOFF_STEPS, without the switch pressing, or a backoff
+* that runs STEPPER_HOME_BACKOFF_STEPS without it releasing, ends homing
+* there, see stepper_home_failed().
+*/
+void
+stepper_home_async (void)
+{
+    stepper_wait();
+    state_moving();
+    stepper_mirror(1);
+    busy = 1;
+    stepper_set_approach(0, 0);
+
+    // Seek, skipped if the carriage is already on the switch
+    home_phase = HOME_SEEK;
+    if (GPIO_getInputPinValue(BUMP_PORT, BUMP_PIN))
+    {
+        stop_on_bump = 1;
+        bumped       = 0;
+        stepper_start(STEPPER_HOME_MAX_STEPS, 0, STEPPER_HOME_SEEK_SPEED);
+    }
+    else
+    {
+        bumped = 1;
+        stepper_finish();
+    }
+}   /* stepper_home_async() */
 
 /*!
 * @brief Moves the stepper motor back to its home position as determined
@@ -123,31 +558,83 @@ stepper_send_steps (uint16_t num, uint8_t dir)
 void
 stepper_go_home (void)
 {
-    while (GPIO_getInputPinValue(BUMP_PORT, BUMP_PIN))
-    {
-        stepper_send_steps(1, 0);
-    }
+    stepper_home_async();
+    stepper_wait();
 } /* stepper_go_home() */
 
 /*!
 * @brief TIMER0_A3 interrupt vector ISR
 *
 * @par
-* Should trigger when timer counts to 0.
+* Should trigger when timer counts to 0. Each trigger is one completed step,
+* after which the period of the next step is set from the motion profile.
+* While homing the seek and approach end on the first step that finds the
+* bump switch pressed, and the backoff on the first that finds it released.
 */
 #pragma vector=TIMER0_A1_VECTOR
 __interrupt void
 timer0_a1_isr (void)
 {
+    uint16_t next_period;
+
+    // Clear interrupt flag
+    Timer_A_clearTimerInterrupt(TIMER_A0_BASE);
+
     // Decrement count and stop PWM output if no more steps left
+    position += direction;
+    watchdog_check_in(WATCHDOG_STEPPER);
     count--;
+    if (stop_on_bump && !GPIO_getInputPinValue(BUMP_PORT, BUMP_PIN))
+    {
+        count  = 0;
+        bumped = 1;
+    }
+    else if (stop_on_release && GPIO_getInputPinValue(BUMP_PORT, BUMP_PIN))
+    {
+        count  = 0;
+        bumped = 0;
+    }
+    if (approach && (0 < count) && (count <= approach_steps) && (HOME_IDLE == home_phase))
+    {
+        stepper_approach();
+        __bic_SR_register_on_exit(LPM3_bits);
+    }
     if (0 >= count)
     {
         Timer_A_stop(TIMER_A0_BASE);
+        stepper_finish();
+
+        // Wake the CPU in case it sleeps until the move is done
+        __bic_SR_register_on_exit(LPM3_bits);
     }
+    else if (0 != ramp_steps)
+    {
+        if (total_steps - count <= ramp_steps)
+        {
+            // Accelerate
+            ramp_index++;
+            period -= (2 * period) / (4 * (uint32_t)ramp_index + 1);
+            if (period < min_period)
+            {
+                period = min_period;
+            }
+        }
+        else if (count <= ramp_steps)
+        {
+            // Decelerate
+            period += (2 * period) / (4 * (uint32_t)ramp_index - 1);
+            ramp_index--;
+            if (period > max_period)
+            {
+                period = max_period;
+            }
+        }
 
-    // Clear interrupt flag
-    Timer_A_clearTimerInterrupt(TIMER_A0_BASE);
+        // New period takes effect on the next timer cycle
+        next_period = (period >> PERIOD_SHIFT) - 1;
+        Timer_A_setCompareValue(TIMER_A0_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_0, next_period);
+        Timer_A_setCompareValue(TIMER_A0_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_1, next_period >> 1);
+    }
 }   /* timer0_a1_isr() */
 
 /*** end of file ***/
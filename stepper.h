@@ -8,13 +8,39 @@
 #ifndef STEPPER_H
 #define STEPPER_H
 
+typedef void (*stepper_callback_t)(void);
+
 void stepper_init(void);
 
 void stepper_enable(void);
 
 void stepper_disable(void);
 
-void stepper_send_steps(uint16_t num, uint8_t dir);
+uint8_t stepper_set_profile(uint16_t speed, uint16_t accel);
+
+void stepper_get_profile(uint16_t *speed, uint16_t *accel);
+
+void stepper_set_callback(stepper_callback_t function);
+
+void stepper_set_approach(uint16_t steps, stepper_callback_t function);
+
+uint8_t stepper_is_busy(void);
+
+void stepper_wait(void);
+
+void stepper_move_async(int16_t target);
+
+void stepper_move_to(int16_t target);
+
+int16_t stepper_get_position(void);
+
+void stepper_set_position(int16_t known);
+
+uint8_t stepper_recover(void);
+
+uint8_t stepper_home_failed(void);
+
+void stepper_home_async(void);
 
 void stepper_go_home(void);
 
@@ -0,0 +1,246 @@
+/******************************************************************************/
+
+/** @file trace.c
+*
+* @brief This module records timestamped turn phases in FRAM.
+*
+* @par
+* Every record is the time, the phase (with TRACE_END set when it ends) and
+* an argument. Records go into a ring in FRAM so they survive a reset, and
+* once it is full the oldest are overwritten. Time comes from TimerA3
+* counting ACLK continuously, so it keeps running in LPM3, with the overflows
+* counted by timer3_a1_isr() to make it 32 bits: 30.5us resolution, wrapping
+* after 36 hours. Its CCR1 compare gives trace_set_alarm() the same
+* resolution, for waits shorter than a scheduler tick.
+*
+* @par
+* trace_dump() sends the ring oldest first as X instructions, see uart.c:
+* X count_l count_h, then the records TRACE_CHUNK at a time as
+* X time_0 time_1 time_2 time_3 event arg ..., time little endian.
+*/
+
+// Includes
+#include <stdint.h>
+#include "driverlib.h"
+#include "Board.h"
+#include "trace.h"
+#include "protocol.h"
+
+#define TRACE_SIZE      256     // Records, power of 2
+#define TRACE_CHUNK     4       // Records sent per instruction
+#define RECORD_BYTES    6
+#define OP_TRACE        0x58    // X
+#define ALARM_LEAD      2       // Trace ticks, an alarm set any closer might be passed before it is armed
+
+typedef struct
+{
+    uint32_t    time;
+    uint8_t     event;
+    uint8_t     arg;
+} trace_record_t;
+
+// FRAM, kept through resets and written with FRAMCtl
+#pragma PERSISTENT(ring)
+static trace_record_t   ring[TRACE_SIZE]    = {0};
+#pragma PERSISTENT(ring_head)
+static uint16_t         ring_head           = 0;
+#pragma PERSISTENT(ring_count)
+static uint16_t         ring_count          = 0;
+
+// Local variables
+static volatile uint16_t    overflows   = 0;
+static Timer_A_initContinuousModeParam param = {0};
+static trace_callback_t     alarm       = 0;
+
+/*!
+* @brief Starts the trace timebase on TimerA3.
+*/
+void
+trace_init (void)
+{
+    param.clockSource                   = TIMER_A_CLOCKSOURCE_ACLK;
+    param.clockSourceDivider            = TIMER_A_CLOCKSOURCE_DIVIDER_1;
+    param.timerInterruptEnable_TAIE     = TIMER_A_TAIE_INTERRUPT_ENABLE;
+    param.timerClear                    = TIMER_A_DO_CLEAR;
+    param.startTimer                    = true;
+    Timer_A_initContinuousMode(TIMER_A3_BASE, &param);
+}   /* trace_init() */
+
+/*!
+* @brief Gets the trace time.
+* @return The time in ACLK cycles, TRACE_TICKS_PER_SECOND.
+*/
+uint32_t
+trace_now (void)
+{
+    uint16_t state = __get_interrupt_state();
+    uint16_t low;
+    uint16_t high;
+
+    __disable_interrupt();
+    low  = Timer_A_getCounterValue(TIMER_A3_BASE);
+    high = overflows;
+
+    // Overflowed since interrupts went off, the ISR hasn't counted it yet
+    if (Timer_A_getInterruptStatus(TIMER_A3_BASE) && (low < 0x8000))
+    {
+        high++;
+    }
+    __set_interrupt_state(state);
+
+    return ((uint32_t)high << 16) | low;
+}   /* trace_now() */
+
+/*!
+* @brief Calls a function from timer3_a1_isr() at a trace time.
+* @param[in] time The trace_now() time, less than 2 seconds away. One
+* already past calls it at once.
+* @param[in] function The function, or 0 to cancel the alarm.
+*/
+void
+trace_set_alarm (uint32_t time, trace_callback_t function)
+{
+    uint16_t state = __get_interrupt_state();
+    uint32_t now;
+
+    __disable_interrupt();
+    Timer_A_disableCaptureCompareInterrupt(TIMER_A3_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_1);
+    alarm = function;
+    if (function)
+    {
+        now = trace_now();
+        if ((int32_t)(time - now) < ALARM_LEAD)
+        {
+            time = now + ALARM_LEAD;
+        }
+        Timer_A_setCompareValue(TIMER_A3_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_1, (uint16_t)time);
+        Timer_A_clearCaptureCompareInterrupt(TIMER_A3_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_1);
+        Timer_A_enableCaptureCompareInterrupt(TIMER_A3_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_1);
+    }
+    __set_interrupt_state(state);
+}   /* trace_set_alarm() */
+
+/*!
+* @brief Adds a record to the ring.
+*/
+static void
+trace_record (uint8_t event, uint8_t arg)
+{
+    trace_record_t record;
+    uint16_t       next;
+
+    record.time  = trace_now();
+    record.event = event;
+    record.arg   = arg;
+
+    FRAMCtl_write8((uint8_t *)&record, (uint8_t *)&ring[ring_head], sizeof(record));
+    next = (ring_head + 1) & (TRACE_SIZE - 1);
+    FRAMCtl_write16(&next, &ring_head, 1);
+    if (ring_count < TRACE_SIZE)
+    {
+        next = ring_count + 1;
+        FRAMCtl_write16(&next, &ring_count, 1);
+    }
+}   /* trace_record() */
+
+/*!
+* @brief Records the start of a phase.
+* @param[in] phase The phase starting.
+*/
+void
+trace_begin (trace_phase_t phase)
+{
+    trace_record(phase, 0);
+}   /* trace_begin() */
+
+/*!
+* @brief Records the end of a phase.
+* @param[in] phase The phase ending.
+* @param[in] arg What came of it, listed in trace_phase_t.
+*/
+void
+trace_end (trace_phase_t phase, uint8_t arg)
+{
+    trace_record(TRACE_END | phase, arg);
+}   /* trace_end() */
+
+/*!
+* @brief Empties the ring.
+*/
+void
+trace_clear (void)
+{
+    uint16_t zero = 0;
+
+    FRAMCtl_write16(&zero, &ring_count, 1);
+}   /* trace_clear() */
+
+/*!
+* @brief Sends every record over UART, oldest first, and empties the ring.
+*/
+void
+trace_dump (void)
+{
+    uint8_t  buffer[TRACE_CHUNK * RECORD_BYTES];
+    uint16_t count = ring_count;
+    uint16_t index = (ring_head - count) & (TRACE_SIZE - 1);
+    uint8_t  len;
+
+    buffer[0] = count & 0xFF;
+    buffer[1] = count >> 8;
+    protocol_send(OP_TRACE, buffer, 2);
+
+    while (count)
+    {
+        len = 0;
+        while (count && (len < sizeof(buffer)))
+        {
+            buffer[len++] = ring[index].time & 0xFF;
+            buffer[len++] = (ring[index].time >> 8) & 0xFF;
+            buffer[len++] = (ring[index].time >> 16) & 0xFF;
+            buffer[len++] = ring[index].time >> 24;
+            buffer[len++] = ring[index].event;
+            buffer[len++] = ring[index].arg;
+            index = (index + 1) & (TRACE_SIZE - 1);
+            count--;
+        }
+        protocol_send(OP_TRACE, buffer, len);
+    }
+
+    trace_clear();
+}   /* trace_dump() */
+
+/*!
+* @brief TIMER3_A3 interrupt vector ISR
+*
+* @par
+* Counts TimerA3 overflows for the high half of trace_now(), and calls the
+* trace_set_alarm() function on the CCR1 compare, waking the CPU.
+*/
+#pragma vector=TIMER3_A1_VECTOR
+__interrupt void
+timer3_a1_isr (void)
+{
+    trace_callback_t function = alarm;
+
+    if (Timer_A_getInterruptStatus(TIMER_A3_BASE))
+    {
+        overflows++;
+        Timer_A_clearTimerInterrupt(TIMER_A3_BASE);
+    }
+
+    if (Timer_A_getCaptureCompareInterruptStatus(TIMER_A3_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_1,
+                                                 TIMER_A_CAPTURECOMPARE_INTERRUPT_FLAG))
+    {
+        Timer_A_clearCaptureCompareInterrupt(TIMER_A3_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_1);
+        Timer_A_disableCaptureCompareInterrupt(TIMER_A3_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_1);
+        alarm = 0;
+        if (function)
+        {
+            function();
+            __bic_SR_register_on_exit(LPM3_bits);
+        }
+    }
+}   /* timer3_a1_isr() */
+
+/*** end of file ***/
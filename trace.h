@@ -0,0 +1,50 @@
+/******************************************************************************/
+
+/** @file trace.h
+*
+* @brief This module records timestamped turn phases in FRAM.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#define TRACE_TICKS_PER_SECOND  32768
+#define TRACE_END               0x80    // Set in the event of a phase ending
+
+// Phases of a turn, the argument recorded with the end is noted
+typedef enum
+{
+    TRACE_TURN,         // Whole turn, turn_t
+    TRACE_UART,         // Waiting for an instruction, the instruction
+    TRACE_ENGINE,       // Robot choosing its column, the column
+    TRACE_MOVE,         // Carriage travelling to the column, the column
+    TRACE_DROP,         // Dispenser extended until the chip is seen, the column seen
+    TRACE_DETECT,       // Waiting for the human's chip, the column seen
+    TRACE_PARK,         // Parking or homing after a robot turn, 1 if homed, 2 if homing failed
+    TRACE_HOME,         // Homing at power up, 1 if it failed
+    TRACE_RECOVER,      // Clearing a jammed chip, the column seen or 7
+    TRACE_PREPOSITION,  // Carriage heading for the likely next column, the column
+    TRACE_BOOT          // Power up or reset until the game resumes, 1 if recovering from a fault
+} trace_phase_t;
+
+typedef void (*trace_callback_t)(void);
+
+void trace_init(void);
+
+uint32_t trace_now(void);
+
+void trace_set_alarm(uint32_t time, trace_callback_t function);
+
+void trace_begin(trace_phase_t phase);
+
+void trace_end(trace_phase_t phase, uint8_t arg);
+
+void trace_dump(void);
+
+void trace_clear(void);
+
+__interrupt void timer3_a1_isr(void);
+
+#endif /* TRACE_H */
+
+/*** end of file ***/
@@ -11,11 +11,50 @@
  * 01 000 111   start game      human first     G
  * 01 001 000   game status     not finished    H
  * 01 001 111   game status     game over       O
+ * 01 100 abc   hint column     abc = bin col#  `,a,b,c,d,e,f
+ * 01 100 111   hint column     no hint         g
  * 01 101 ABC   human column    abc = bin col#  h,i,j,k,l,m,n
  * 01 110 abc   robot column    abc = bin col#  p,q,r,s,t,u,v
+ * 01 110 111   robot column    robot chooses   w
  * 01 111 000   Error           wrong column    x
  * 01 111 001   Error           chip jammed     y
+ * 01 111 010   Error           sensor fault    z
+ * 01 111 011   Error           busy            {
  * 01 010 111   No Error        no error        W
+ * 01 011 000   Maintenance     dump trace      X
+ * 01 011 001   Maintenance     calibrate       Y
+ * 01 011 010   Maintenance     jam statistics  Z
+ * 01 011 011   Maintenance     photo filter    [
+ * 01 011 100   Maintenance     sensor health   \
+ * 01 011 101   Maintenance     diagnostic test ]
+ * 01 011 110   Maintenance     diagnostic dump ^
+ * 01 011 111   Maintenance     drop test       _
+ *
+ * After w the robot replies with the column it chose, p-v, before playing it.
+ * A hint is the host's best guess so far at the robot's next column, sent at
+ * any time before that column. The carriage heads for it, or for the center
+ * without one, while the host decides. Hints are not answered.
+ * z means a photo-interrupter has failed, see photo.c. It takes the place of
+ * W when the robot's chip has been dropped into a column whose sensor has
+ * failed, and is sent at the start of the human's turn while any has.
+ * Maintenance instructions carry their data after the opcode, see trace.c,
+ * calib.c, jam.c, photo.c and diag.c. Each is answered once the game has
+ * taken the game instructions sent before it, and only runs between games,
+ * before a start game instruction or after a game over, once the carriage
+ * has stopped and any calibration has finished. Sent during a game it is
+ * answered with { instead.
+ *
+ * Instructions can also be sent inside CRC checked frames, see protocol.c.
+ *
+ * Game instructions are queued until the game is ready for them, so the host
+ * can send several at once, a robot column and the game status after it for
+ * example, and have them carried out back to back. @ and G are taken
+ * whatever the game is doing, skipping anything queued before them, and
+ * abandon the game under way, a hard jam for example.
+ *
+ * The queue is kept in FRAM. The game saves how far it has taken it, so after
+ * a reset by a fault uart_resume_instructions() carries on from there, and
+ * instructions already answered with an ACK aren't lost.
  */
 
 // Includes
@@ -24,19 +63,61 @@
 #include "Board.h"
 #include "defines.h"
 #include "uart.h"
+#include "protocol.h"
+#include "trace.h"
+#include "sched.h"
+#include "calib.h"
+#include "jam.h"
+#include "photo.h"
+#include "diag.h"
+#include "power.h"
+#include "watchdog.h"
 
 #define UART1 // UART1 for actual robot, UART0 for launchpad
 
 #ifdef UART1
-#define UART_BASE EUSCI_A1_BASE
+#define UART_BASE   EUSCI_A1_BASE
+#define UART_VECTOR USCI_A1_VECTOR
 #else
-#define UART_BASE EUSCI_A0_BASE
+#define UART_BASE   EUSCI_A0_BASE
+#define UART_VECTOR USCI_A0_VECTOR
 #endif
 
+// Ring buffer sizes, must be powers of 2
+#define RX_BUFFER_SIZE  32
+#define TX_BUFFER_SIZE  32
+#define COMMAND_SIZE    8       // Game instructions waiting for the game, power of 2
+
+// FRAM, kept through resets and written with FRAMCtl
+// Game instructions received but not yet taken, from command_tail to command_head
+#pragma PERSISTENT(commands)
+static uint8_t commands[COMMAND_SIZE] = {0};
+#pragma PERSISTENT(command_head)
+static uint8_t command_head = 0;
+
 // Local variables
-static uint8_t RxData = 0;
 static uint8_t TxData = 0;
 
+// Ring buffers, heads are written by the producer and tails by the consumer
+static volatile uint8_t rx_buffer[RX_BUFFER_SIZE];
+static volatile uint8_t rx_gap[RX_BUFFER_SIZE];    // 1 if the line was idle before the byte
+static volatile uint8_t rx_head     = 0;
+static volatile uint8_t rx_tail     = 0;
+static volatile uint8_t rx_overruns = 0;
+static uint16_t         rx_last     = 0;    // sched_now() when the last byte came in
+static uint8_t          rx_idle     = 0;    // rx_gap of the byte last taken
+static volatile uint8_t tx_buffer[TX_BUFFER_SIZE];
+static volatile uint8_t tx_head     = 0;
+static volatile uint8_t tx_tail     = 0;
+static volatile uint8_t tx_waiting  = 0;    // uart_wait_send() asleep on a full buffer
+static uint8_t command_tail = 0;            // Next game instruction to take
+
+// Maintenance instruction waiting for the game instructions before it
+static uint8_t held         = 0;
+static uint8_t held_op      = 0;
+static uint8_t held_data[PROTOCOL_MAX_DATA];
+static uint8_t held_len     = 0;
+
 /*!
  * @brief Initializes eUSCIA0 with 115200 baudrate.
  * TODO: FOR ACTUAL ROBOT USE UART A1 NEED TO CHANGE
@@ -44,10 +125,19 @@ static uint8_t TxData = 0;
  * @par
  * Current implementation: Rx = P1.5, Tx = P1.4
  * Final implementation: Rx = P2.5, Tx = P2.6
+ *
+ * @par
+ * Received bytes are queued by uart_isr() until they are read, so nothing is
+ * lost while the main loop is busy elsewhere. Game instructions left queued
+ * from before the reset are dropped, see uart_resume_instructions().
+ * Run after sched_init(), the first byte counts as coming after a quiet line.
  */
 void
 uart_init (void)
 {
+    command_tail = command_head;
+    rx_last      = sched_now() - (UART_IDLE_TICKS + 1);
+
     // Configure and enable UART
     EUSCI_A_UART_initParam UARTparam = {0};
     UARTparam.selectClockSource = EUSCI_A_UART_CLOCKSOURCE_SMCLK;
@@ -62,6 +152,10 @@ uart_init (void)
     EUSCI_A_UART_init(UART_BASE, &UARTparam);
     EUSCI_A_UART_enable(UART_BASE);
 
+    // Interrupt enables are cleared by the reset above, so set them after it
+    EUSCI_A_UART_clearInterrupt(UART_BASE, EUSCI_A_UART_RECEIVE_INTERRUPT_FLAG);
+    EUSCI_A_UART_enableInterrupt(UART_BASE, EUSCI_A_UART_RECEIVE_INTERRUPT);
+
 #ifdef UART1
     // Configure UART1 pins
     GPIO_setAsPeripheralModuleFunctionOutputPin(
@@ -90,85 +184,377 @@ uart_init (void)
 }   /* uart_init() */
 
 /*!
- * @brief Wait until a start game instruction is received.
- * @return The starting turn, ROBOT or HUMAN.
+ * @brief Takes a received byte if one is waiting.
+ * @param[out] data The received byte.
+ * @return 1 if a byte was received, 0 if none are waiting.
  */
-turn_t
-uart_receive_start (void)
+uint8_t
+uart_try_receive (uint8_t *data)
+{
+    if (rx_head == rx_tail)
+    {
+        return 0;
+    }
+
+    *data   = rx_buffer[rx_tail];
+    rx_idle = rx_gap[rx_tail];
+    rx_tail = (rx_tail + 1) & (RX_BUFFER_SIZE - 1);
+    return 1;
+}   /* uart_try_receive() */
+
+/*!
+ * @brief Checks whether received bytes are waiting to be taken.
+ * @return 1 if any are, 0 if not.
+ */
+uint8_t
+uart_rx_pending (void)
 {
-    turn_t initial_turn = TBD;
+    return rx_head != rx_tail;
+}   /* uart_rx_pending() */
 
-    // Stay in this loop until the appropriate instruction is received.
-    do
+/*!
+ * @brief Checks whether the byte uart_try_receive() last took came after the
+ * line had been quiet.
+ * @return 1 if nothing was received for UART_IDLE_TICKS before it, 0 if it
+ * followed another byte closely.
+ *
+ * @par
+ * The gap is timed by uart_isr() as the byte arrives, so it holds however
+ * long the byte then waits to be read.
+ */
+uint8_t
+uart_received_idle (void)
+{
+    return rx_idle;
+}   /* uart_received_idle() */
+
+/*!
+ * @brief Sleeps until a byte is received, or returns at once if one is
+ * waiting. Other interrupts can wake it early, so callers check again.
+ */
+void
+uart_wait_receive (void)
+{
+    // Check and sleep with interrupts off so uart_isr() can't slip in between
+    __disable_interrupt();
+    if (rx_head == rx_tail)
+    {
+        power_sleep();
+    }
+    __enable_interrupt();
+}   /* uart_wait_receive() */
+
+/*!
+ * @brief Queues a byte for transmission.
+ * @param[in] data The byte to send.
+ * @return 1 if the byte was queued, 0 if the transmit buffer is full.
+ */
+uint8_t
+uart_send (uint8_t data)
+{
+    uint8_t next = (tx_head + 1) & (TX_BUFFER_SIZE - 1);
+
+    if (next == tx_tail)
     {
-        RxData = EUSCI_A_UART_receiveData(UART_BASE);
-        if (0x40 == RxData) // @
+        return 0;
+    }
+
+    tx_buffer[tx_head] = data;
+    tx_head = next;
+
+    // Transmit interrupt fires whenever TXBUF is empty, uart_isr() turns it
+    // back off once the buffer drains
+    watchdog_expect(WATCHDOG_UART, 1);
+    EUSCI_A_UART_enableInterrupt(UART_BASE, EUSCI_A_UART_TRANSMIT_INTERRUPT);
+    return 1;
+}   /* uart_send() */
+
+/*!
+ * @brief Sleeps until the transmit buffer has room, or returns at once if it
+ * has. Other interrupts can wake it early, so callers check again.
+ */
+void
+uart_wait_send (void)
+{
+    __disable_interrupt();
+    if (((tx_head + 1) & (TX_BUFFER_SIZE - 1)) == tx_tail)
+    {
+        tx_waiting = 1;
+        power_sleep();
+    }
+    __enable_interrupt();
+}   /* uart_wait_send() */
+
+/*!
+ * @brief Gets the number of bytes dropped because the receive buffer was full.
+ * @return The overrun count.
+ */
+uint8_t
+uart_get_overruns (void)
+{
+    return rx_overruns;
+}   /* uart_get_overruns() */
+
+/*!
+ * @brief Answers a maintenance instruction.
+ * @param[in] op The instruction, X to _.
+ * @param[in] data The payload.
+ * @param[in] len The number of payload bytes.
+ */
+static void
+uart_maintain (uint8_t op, const uint8_t *data, uint8_t len)
+{
+    // A calibration paused for the board to be emptied only takes Y
+    if (calib_paused() && (0x59 != op))
+    {
+        uart_send_error(UART_ERROR_BUSY);
+        return;
+    }
+
+    switch (op)
+    {
+    case 0x58: // X
+        trace_dump();
+        break;
+
+    case 0x59: // Y
+        calib_start();
+        break;
+
+    case 0x5A: // Z
+        jam_report();
+        break;
+
+    case 0x5B: // [
+        photo_filter(data, len);
+        break;
+
+    case 0x5C: // Backslash
+        photo_health();
+        break;
+
+    case 0x5D: // ]
+        diag_test(data, len);
+        break;
+
+    case 0x5E: // ^
+        diag_dump();
+        break;
+
+    case 0x5F: // _
+        diag_drops(data, len);
+        break;
+
+    default:
+        break;
+    }
+}   /* uart_maintain() */
+
+/*!
+ * @brief Gets the oldest game instruction not yet taken, leaving it queued.
+ * @param[out] instruction The instruction.
+ * @param[in] maintain Whether maintenance instructions may run.
+ * @return 1 if one is waiting, 0 if not.
+ *
+ * @par
+ * Queues whatever has been received first. A maintenance instruction waits
+ * until the game has taken every game instruction received before it, then
+ * runs, waits longer while the robot is busy between games, or is answered
+ * with { during a game. Once the queue is full the rest stay with
+ * protocol.c, which NACKs frames it has no room for, so the host slows down.
+ */
+uint8_t
+uart_peek_instruction (uint8_t *instruction, uart_maintain_t maintain)
+{
+    uint8_t next = (command_head + 1) & (COMMAND_SIZE - 1);
+    uint8_t received;
+
+    while (next != command_tail)
+    {
+        if (!held)
         {
-            initial_turn = ROBOT;
+            if (!protocol_poll(&received, held_data, &held_len))
+            {
+                break;
+            }
+            if (0x58 != (received & 0xF8)) // Not X to _
+            {
+                FRAMCtl_write8(&received, &commands[command_head], 1);
+                FRAMCtl_write8(&next, &command_head, 1);
+                next = (command_head + 1) & (COMMAND_SIZE - 1);
+                continue;
+            }
+            held    = 1;
+            held_op = received;
         }
-        else if (0x47 == RxData) // G
+
+        if ((command_head != command_tail) || (UART_MAINTAIN_HOLD == maintain))
         {
-            initial_turn = HUMAN;
+            break;
+        }
+        held = 0;
+        if (UART_MAINTAIN_RUN == maintain)
+        {
+            uart_maintain(held_op, held_data, held_len);
+
+            // A calibration runs on from here, the rest wait for it
+            if (calib_busy())
+            {
+                maintain = UART_MAINTAIN_HOLD;
+            }
+        }
+        else
+        {
+            uart_send_error(UART_ERROR_BUSY);
         }
     }
-    while (TBD == initial_turn);
 
-    return initial_turn;
-}   /* uart_receive_start() */
+    if (command_head == command_tail)
+    {
+        return 0;
+    }
+
+    *instruction = commands[command_tail];
+    return 1;
+}   /* uart_peek_instruction() */
 
 /*!
- * @brief Wait until column data is received.
- * @return The column 0-6.
+ * @brief Removes the instruction uart_peek_instruction() got from the queue.
+ */
+void
+uart_take_instruction (void)
+{
+    if (command_head != command_tail)
+    {
+        command_tail = (command_tail + 1) & (COMMAND_SIZE - 1);
+    }
+}   /* uart_take_instruction() */
+
+/*!
+ * @brief Skips the game instructions queued before a start game instruction,
+ * for a game abandoned while it is busy.
+ * @param[out] instruction The start game instruction.
+ * @return 1 if one is queued, now the oldest, 0 if not.
  */
 uint8_t
-uart_receive_column (void)
+uart_skip_to_start (uint8_t *instruction)
 {
-    // Stay in this loop until the appropriate instruction is received.
-    do
+    uint8_t i;
+
+    for (i = command_tail; i != command_head; i = (i + 1) & (COMMAND_SIZE - 1))
     {
-        RxData = EUSCI_A_UART_receiveData(UART_BASE);
+        if (TBD != uart_decode_start(commands[i]))
+        {
+            command_tail = i;
+            *instruction = commands[i];
+            return 1;
+        }
     }
-    while (0x30 != (RxData & 0x38));
+    return 0;
+}   /* uart_skip_to_start() */
 
-    return RxData & 0x07; // p,q,r,s,t,u,v
-}   /* uart_receive_column(); */
+/*!
+ * @brief Gets how far the game instructions have been taken, for the game to
+ * save with its state.
+ * @return The queue position of the next instruction to take.
+ */
+uint8_t
+uart_get_taken (void)
+{
+    return command_tail;
+}   /* uart_get_taken() */
 
 /*!
- * @brief Wait until a game status is received.
- * @param[in] current_turn The current turn in the game.
- * @return The next turn.
+ * @brief Queues again the game instructions from before a reset by a fault
+ * that the game hadn't taken.
+ * @param[in] taken uart_get_taken() as it was saved before the reset.
+ */
+void
+uart_resume_instructions (uint8_t taken)
+{
+    command_tail = taken & (COMMAND_SIZE - 1);
+}   /* uart_resume_instructions() */
+
+/*!
+ * @brief Decodes a start game instruction.
+ * @param[in] instruction The instruction.
+ * @return The starting turn, ROBOT or HUMAN, or TBD if it is not a start.
  */
 turn_t
-uart_receive_status (turn_t current_turn)
+uart_decode_start (uint8_t instruction)
+{
+    if (0x40 == instruction) // @
+    {
+        return ROBOT;
+    }
+    else if (0x47 == instruction) // G
+    {
+        return HUMAN;
+    }
+
+    return TBD;
+}   /* uart_decode_start() */
+
+/*!
+ * @brief Decodes a robot column instruction.
+ * @param[in] instruction The instruction.
+ * @return The column 0-6, 7 if the robot should choose, or UART_NOT_COLUMN.
+ */
+uint8_t
+uart_decode_column (uint8_t instruction)
 {
-    turn_t next_turn = TBD;
+    if (0x30 != (instruction & 0x38))
+    {
+        return UART_NOT_COLUMN;
+    }
 
-    // Stay in this loop until the proper instruction is received.
-    do
+    return instruction & 0x07; // p,q,r,s,t,u,v,w
+}   /* uart_decode_column() */
+
+/*!
+ * @brief Decodes a hint column instruction.
+ * @param[in] instruction The instruction.
+ * @return The column 0-6, 7 to withdraw the hint, or UART_NOT_COLUMN.
+ */
+uint8_t
+uart_decode_hint (uint8_t instruction)
+{
+    if (0x20 != (instruction & 0x38))
     {
-        RxData = EUSCI_A_UART_receiveData(UART_BASE);
+        return UART_NOT_COLUMN;
     }
-    while (0x08 != (RxData & 0x38));
 
+    return instruction & 0x07; // `,a,b,c,d,e,f,g
+}   /* uart_decode_hint() */
+
+/*!
+ * @brief Decodes a game status instruction.
+ * @param[in] instruction The instruction.
+ * @param[in] current_turn The current turn in the game.
+ * @return The next turn, or TBD if it is not a game status.
+ */
+turn_t
+uart_decode_status (uint8_t instruction, turn_t current_turn)
+{
     // Determine next turn if the game is not over
-    if (0x48 == RxData) // H
+    if (0x48 == instruction) // H
     {
         if (ROBOT == current_turn)
         {
-            next_turn = HUMAN;
+            return HUMAN;
         }
         else
         {
-            next_turn = ROBOT;
+            return ROBOT;
         }
     }
-    else if (0x4F == RxData) // O
+    else if (0x4F == instruction) // O
     {
-        next_turn = GAME_OVER;
+        return GAME_OVER;
     }
 
-    return next_turn;
-}   /* uart_receive_status() */
+    return TBD;
+}   /* uart_decode_status() */
 
 /*!
  * @brief Encode and send column data.
@@ -178,18 +564,30 @@ void
 uart_send_column (uint8_t column)
 {
     TxData = 0x68 | column; // h,i,j,k,l,m,n
-    EUSCI_A_UART_transmitData(UART_BASE, TxData);
+    protocol_send(TxData, 0, 0);
 }   /* uart_send_column() */
 
+/*!
+ * @brief Encode and send the column the robot chose to play.
+ * @param[in] The column to send. 0-6
+ */
+void
+uart_send_move (uint8_t column)
+{
+    TxData = 0x70 | column; // p,q,r,s,t,u,v
+    protocol_send(TxData, 0, 0);
+}   /* uart_send_move() */
+
 /*!
  * @brief Encode and send an error.
- * @param[in] The error to send. Enumerated in error_t.
+ * @param[in] The error to send, 0 x, 1 y, 2 z, UART_ERROR_BUSY or
+ * UART_ERROR_NO_MOVE.
  */
 void
 uart_send_error (uint8_t error)
 {
     TxData = 0x78 | error;
-    EUSCI_A_UART_transmitData(UART_BASE, TxData);
+    protocol_send(TxData, 0, 0);
 }   /* uart_send_error() */
 
 /*!
@@ -199,7 +597,79 @@ void
 uart_send_no_error (void)
 {
     TxData = 0x57;
-    EUSCI_A_UART_transmitData(UART_BASE, TxData);
+    protocol_send(TxData, 0, 0);
 }   /* uart_send_no_error() */
 
+/*!
+ * @brief eUSCI_A interrupt vector ISR
+ *
+ * @par
+ * Moves received bytes into the receive buffer and feeds TXBUF from the
+ * transmit buffer. The first byte into an empty receive buffer posts
+ * SCHED_EV_UART and wakes the CPU, the handler then drains the buffer.
+ * Each byte is marked with whether the line was idle before it, see
+ * uart_received_idle().
+ *
+ * @par
+ * The flags are polled instead of read through UCAxIV since reading the vector
+ * clears UCTXIFG. If that happens while the transmit buffer is empty, the flag
+ * stays clear and the next uart_send() never gets an interrupt.
+ */
+#pragma vector=UART_VECTOR
+__interrupt void
+uart_isr (void)
+{
+    uint16_t now;
+    uint8_t  gap;
+    uint8_t  data;
+    uint8_t  next;
+
+    if (EUSCI_A_UART_getInterruptStatus(UART_BASE,
+                                        EUSCI_A_UART_RECEIVE_INTERRUPT_FLAG))
+    {
+        now     = sched_now();
+        gap     = (uint16_t)(now - rx_last) > UART_IDLE_TICKS;
+        rx_last = now;
+        next    = (rx_head + 1) & (RX_BUFFER_SIZE - 1);
+        data    = EUSCI_A_UART_receiveData(UART_BASE);
+        if (next == rx_tail)
+        {
+            rx_overruns++;
+        }
+        else
+        {
+            if (rx_head == rx_tail)
+            {
+                sched_post(SCHED_EV_UART, 0);
+                __bic_SR_register_on_exit(LPM3_bits);
+            }
+            rx_buffer[rx_head] = data;
+            rx_gap[rx_head]    = gap;
+            rx_head = next;
+        }
+    }
+
+    if (EUSCI_A_UART_getInterruptStatus(UART_BASE,
+                                        EUSCI_A_UART_TRANSMIT_INTERRUPT_FLAG))
+    {
+        if (tx_head == tx_tail)
+        {
+            // Leave UCTXIFG set so enabling the interrupt restarts transmission
+            EUSCI_A_UART_disableInterrupt(UART_BASE, EUSCI_A_UART_TRANSMIT_INTERRUPT);
+            watchdog_expect(WATCHDOG_UART, 0);
+        }
+        else
+        {
+            EUSCI_A_UART_transmitData(UART_BASE, tx_buffer[tx_tail]);
+            tx_tail = (tx_tail + 1) & (TX_BUFFER_SIZE - 1);
+            watchdog_check_in(WATCHDOG_UART);
+            if (tx_waiting)
+            {
+                tx_waiting = 0;
+                __bic_SR_register_on_exit(LPM3_bits);
+            }
+        }
+    }
+}   /* uart_isr() */
+
 /*** end of file ***/
@@ -8,6 +8,11 @@
 #ifndef UART_H_
 #define UART_H_
 
+#define UART_NOT_COLUMN     0xFF    // uart_decode_column() or uart_decode_hint() of any other instruction
+#define UART_ERROR_BUSY     3       // uart_send_error() {, a maintenance instruction sent during a game
+#define UART_ERROR_NO_MOVE  4       // uart_send_error() |, w sent with the board full
+#define UART_IDLE_TICKS     8       // TimerA2 cycles at 512Hz, ~16ms of silence before a byte makes it uart_received_idle()
+
 typedef enum
 {
     ROBOT,
@@ -16,20 +21,58 @@ typedef enum
     GAME_OVER
 } turn_t;
 
+// Whether maintenance instructions may run, for uart_peek_instruction()
+typedef enum
+{
+    UART_MAINTAIN_REFUSE,   // During a game, answered with {
+    UART_MAINTAIN_HOLD,     // Between games while the robot is busy, kept until it isn't
+    UART_MAINTAIN_RUN       // Between games with the robot idle
+} uart_maintain_t;
+
 void uart_init(void);
 
-turn_t uart_receive_start(void);
+uint8_t uart_try_receive(uint8_t *data);
+
+uint8_t uart_rx_pending(void);
+
+uint8_t uart_received_idle(void);
+
+void uart_wait_receive(void);
+
+uint8_t uart_send(uint8_t data);
+
+void uart_wait_send(void);
+
+uint8_t uart_get_overruns(void);
 
-uint8_t uart_receive_column(void);
+uint8_t uart_peek_instruction(uint8_t *instruction, uart_maintain_t maintain);
 
-turn_t uart_receive_status(turn_t current_turn);
+void uart_take_instruction(void);
+
+uint8_t uart_skip_to_start(uint8_t *instruction);
+
+uint8_t uart_get_taken(void);
+
+void uart_resume_instructions(uint8_t taken);
+
+turn_t uart_decode_start(uint8_t instruction);
+
+uint8_t uart_decode_column(uint8_t instruction);
+
+uint8_t uart_decode_hint(uint8_t instruction);
+
+turn_t uart_decode_status(uint8_t instruction, turn_t current_turn);
 
 void uart_send_column(uint8_t column);
 
+void uart_send_move(uint8_t column);
+
 void uart_send_error(uint8_t error);
 
 void uart_send_no_error(void);
 
+__interrupt void uart_isr(void);
+
 #endif /* UART_H_ */
 
 /*** end of file ***/
@@ -0,0 +1,171 @@
+/******************************************************************************/
+
+/** @file watchdog.c
+*
+* @brief This module keeps the hardware watchdog fed while every part of the
+* firmware that should be running is.
+*
+* @par
+* The WDT_A counts ACLK and resets the MCU after 1s without being fed. It
+* is only fed from watchdog_service(), which runs from power_sleep() and
+* from the engine's search, so a main loop stuck without sleeping is reset.
+* Each ISR driven state machine expects to check in while it is running:
+* the stepper every step, the servo every PWM period and the UART every byte
+* sent. Every SERVICE_TICKS the service feeds the watchdog only if all the
+* clients expected in that time have checked in, so a wait on a move or a
+* byte that never finishes is reset too, even though the CPU keeps sleeping
+* and waking. A missed check-in is noted in FRAM and the watchdog left to
+* run out.
+*
+* @par
+* watchdog_init() records the reason for the last reset in FRAM. A reset by
+* the watchdog, or by any other fault the MCU resets itself for, leaves the
+* motors and the host where they were, so main.c and protocol.c pick up
+* where they left off rather than starting over.
+*/
+
+// Includes
+#include <stdint.h>
+#include "driverlib.h"
+#include "Board.h"
+#include "watchdog.h"
+#include "sched.h"
+
+#define SERVICE_TICKS   256     // TimerA2 cycles at 512Hz, 0.5s between check-in rounds
+
+// FRAM, kept through resets and written with FRAMCtl
+#pragma PERSISTENT(history)
+static watchdog_log_t history = {0};
+
+// Local variables
+static volatile uint8_t expected    = 0;    // Bit n = client n should be checking in
+static volatile uint8_t alive       = 0;    // Bit n = client n checked in this round
+static uint8_t          starved     = 0;    // A client missed its round, feeding stopped
+static uint8_t          recovering  = 0;
+
+/*!
+* @brief Records why the MCU reset and starts the watchdog. Call once the
+* clocks and the scheduler are running, before anything that can take long.
+*/
+void
+watchdog_init (void)
+{
+    watchdog_log_t next = history;
+    uint16_t       cause;
+
+    // The highest priority reason comes first, read the rest to clear them
+    cause = SYSRSTIV;
+    while (SYSRSTIV_NONE != SYSRSTIV)
+    {
+    }
+
+    // Everything from a watchdog timeout up is a PUC, power was never lost
+    recovering  = (cause >= SYSRSTIV_WDTTO);
+    next.cause  = cause;
+    next.resets++;
+    if (recovering)
+    {
+        next.faults++;
+        next.missed = history.missing;
+    }
+    next.missing = 0;
+    FRAMCtl_write8((uint8_t *)&next, (uint8_t *)&history, sizeof(next));
+
+    WDT_A_initWatchdogTimer(WDT_A_BASE, WDT_A_CLOCKSOURCE_ACLK, WDT_A_CLOCKDIVIDER_32K);
+    WDT_A_start(WDT_A_BASE);
+    sched_timer_start(SCHED_TIMER_WATCHDOG, SERVICE_TICKS);
+}   /* watchdog_init() */
+
+/*!
+* @brief Checks whether this boot follows a fault rather than power up or
+* the reset pin.
+* @return 1 if the last reset was a fault, 0 if not.
+*/
+uint8_t
+watchdog_recovering (void)
+{
+    return recovering;
+}   /* watchdog_recovering() */
+
+/*!
+* @brief Gets the reset history.
+* @return The log in FRAM.
+*/
+const watchdog_log_t *
+watchdog_get_log (void)
+{
+    return &history;
+}   /* watchdog_get_log() */
+
+/*!
+* @brief Starts or stops expecting a client to check in.
+* @param[in] client The client.
+* @param[in] running 1 before it starts, 0 once it has stopped.
+*
+* @par
+* Starting counts as a check-in, so it has a whole round to make its first.
+* Call with 1 before enabling the interrupt that checks in, since the ISR
+* may stop the client straight away.
+*/
+void
+watchdog_expect (watchdog_client_t client, uint8_t running)
+{
+    uint16_t state = __get_interrupt_state();
+
+    __disable_interrupt();
+    if (running)
+    {
+        expected |= 1 << client;
+        alive    |= 1 << client;
+    }
+    else
+    {
+        expected &= ~(1 << client);
+    }
+    __set_interrupt_state(state);
+}   /* watchdog_expect() */
+
+/*!
+* @brief Shows a client is still making progress. Called from its ISR.
+* @param[in] client The client.
+*/
+void
+watchdog_check_in (watchdog_client_t client)
+{
+    alive |= 1 << client;
+}   /* watchdog_check_in() */
+
+/*!
+* @brief Feeds the watchdog once a round is up, if every expected client
+* checked in during it. Cheap enough to call often.
+*/
+void
+watchdog_service (void)
+{
+    uint16_t state;
+    uint8_t  missing;
+
+    if (starved || !sched_timer_expired(SCHED_TIMER_WATCHDOG))
+    {
+        return;
+    }
+
+    state = __get_interrupt_state();
+    __disable_interrupt();
+    missing = expected & ~alive;
+    alive   = 0;
+    __set_interrupt_state(state);
+
+    if (missing)
+    {
+        // Note who stopped and let the watchdog run out
+        starved = 1;
+        FRAMCtl_write8(&missing, &history.missing, 1);
+        return;
+    }
+
+    WDT_A_resetTimer(WDT_A_BASE);
+    sched_timer_start(SCHED_TIMER_WATCHDOG, SERVICE_TICKS);
+}   /* watchdog_service() */
+
+/*** end of file ***/
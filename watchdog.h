@@ -0,0 +1,46 @@
+/******************************************************************************/
+
+/** @file watchdog.h
+*
+* @brief This module keeps the hardware watchdog fed while every part of the
+* firmware that should be running is.
+*/
+
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#define WATCHDOG_PERIOD_TICKS   32768   // ACLK cycles unfed before the WDT_A resets the MCU, 1s
+
+// Parts of the firmware that check in while they are running
+typedef enum
+{
+    WATCHDOG_STEPPER,   // timer0_a1_isr(), every step of a move or homing
+    WATCHDOG_SERVO,     // timer1_a1_isr(), every PWM period while powered
+    WATCHDOG_UART       // uart_isr(), every byte while any are queued to send
+} watchdog_client_t;
+
+// Reset history, kept in FRAM
+typedef struct
+{
+    uint16_t    cause;      // SYSRSTIV of the last reset
+    uint16_t    resets;     // Resets of any kind
+    uint16_t    faults;     // Resets by the watchdog or another fault
+    uint8_t     missed;     // Clients that stopped checking in before the last fault, 0 if the CPU stopped
+    uint8_t     missing;    // Clients found stopped since this boot
+} watchdog_log_t;
+
+void watchdog_init(void);
+
+uint8_t watchdog_recovering(void);
+
+const watchdog_log_t *watchdog_get_log(void);
+
+void watchdog_expect(watchdog_client_t client, uint8_t running);
+
+void watchdog_check_in(watchdog_client_t client);
+
+void watchdog_service(void);
+
+#endif /* WATCHDOG_H */
+
+/*** end of file ***/